@@ -0,0 +1,132 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+#include "benchmark.h"
+#include "pixloc/helper/strings.h"
+
+namespace pixloc {
+namespace bench {
+
+BenchmarkResult BenchmarkResult::Measure(const std::function<bool()> &run, unsigned int iterations) {
+  BenchmarkResult result;
+  result.is_valid = run();
+
+  for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+    auto start = std::chrono::steady_clock::now();
+    bool is_valid = run();
+    auto end = std::chrono::steady_clock::now();
+
+    result.latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    if (!is_valid) result.is_valid = false;
+  }
+
+  std::sort(result.latencies.begin(), result.latencies.end());
+
+  return result;
+}
+
+double BenchmarkResult::GetPercentile(unsigned short percentile) const {
+  if (latencies.empty()) return 0;
+
+  auto rank = static_cast<unsigned long>(std::ceil(percentile/100.0*latencies.size()));
+
+  return latencies[rank > 0 ? rank - 1 : 0];
+}
+
+double BenchmarkResult::GetMean() const {
+  return latencies.empty()
+         ? 0
+         : std::accumulate(latencies.begin(), latencies.end(), 0.0)/latencies.size();
+}
+
+double BenchmarkResult::GetPixelsPerSecond() const {
+  double median = GetPercentile(50);
+
+  return median > 0 ? pixels/(median/1000) : 0;
+}
+
+std::string BenchmarkResult::FormatJson() const {
+  std::string json = "{";
+  for (const auto &label : labels) {
+    json += "\"" + label.first + "\":" +
+        (helper::strings::IsNumeric(label.second) ? label.second : "\"" + label.second + "\"") + ",";
+  }
+
+  char numbers[320];
+  snprintf(numbers, sizeof(numbers),
+           "\"iterations\":%lu,\"pixels\":%lu,\"min_ms\":%.4f,\"mean_ms\":%.4f,\"p50_ms\":%.4f,\"p90_ms\":%.4f,"
+           "\"p99_ms\":%.4f,\"max_ms\":%.4f,\"pixels_per_second\":%.0f,",
+           static_cast<unsigned long>(latencies.size()), pixels,
+           GetPercentile(0), GetMean(), GetPercentile(50), GetPercentile(90), GetPercentile(99), GetPercentile(100),
+           GetPixelsPerSecond());
+
+  return json + numbers + "\"valid\":" + (is_valid ? "true" : "false") + "}";
+}
+
+std::string BenchmarkResult::FormatText() const {
+  std::string row;
+  for (unsigned long index = 0; index < labels.size(); ++index) {
+    row += PadLabel(labels[index].second, labels[index].first, index==0);
+  }
+
+  char numbers[120];
+  snprintf(numbers, sizeof(numbers), "%9.3f %9.3f %9.3f %10.1f  %s",
+           GetPercentile(50), GetPercentile(90), GetPercentile(99), GetPixelsPerSecond()/1000000,
+           is_valid ? "ok" : "INVALID");
+
+  return row + numbers;
+}
+
+std::string BenchmarkResult::FormatTextHeader() const {
+  std::string header;
+  for (unsigned long index = 0; index < labels.size(); ++index) {
+    header += PadLabel(labels[index].first, labels[index].first, index==0);
+  }
+
+  char numbers[120];
+  snprintf(numbers, sizeof(numbers), "%9s %9s %9s %10s  %s", "p50 ms", "p90 ms", "p99 ms", "Mpixel/s", "result");
+
+  return header + numbers;
+}
+
+// Pad given text to the column width of given label: wide 1st column of names, others at least as wide as their key
+std::string BenchmarkResult::PadLabel(const std::string &text, const std::string &key, bool is_first) {
+  unsigned long width = is_first ? kNameColumnWidth : std::max(key.length(), static_cast<unsigned long>(kMinColumnWidth));
+
+  return text + std::string(text.length() < width ? width - text.length() : 0, ' ') + " ";
+}
+
+} // namespace bench
+} // namespace pixloc
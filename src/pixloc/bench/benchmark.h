@@ -0,0 +1,84 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_BENCHMARK
+#define CLASS_PIXLOC_BENCHMARK
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pixloc {
+namespace bench {
+
+// Latencies of repeated runs of one benchmark case
+class BenchmarkResult {
+
+ public:
+  // Labels identifying the benchmark case, in output order, e.g. {"benchmark", "find_image"}
+  std::vector<std::pair<std::string, std::string>> labels;
+
+  // Amount of pixels examined per run
+  unsigned long pixels = 0;
+
+  // Did all runs produce the expected result?
+  bool is_valid = true;
+
+  // Run given function once to warm up, then time given amount of runs. The function returns validity of its result
+  static BenchmarkResult Measure(const std::function<bool()> &run, unsigned int iterations);
+
+  // Nearest-rank percentile of latencies, in milliseconds
+  double GetPercentile(unsigned short percentile) const;
+  double GetMean() const;
+
+  // Throughput at median latency
+  double GetPixelsPerSecond() const;
+
+  // Single line JSON object. Numeric labels are output as numbers
+  std::string FormatJson() const;
+
+  // Table row, aligned w/ FormatTextHeader()
+  std::string FormatText() const;
+  std::string FormatTextHeader() const;
+
+ private:
+  static const unsigned long kNameColumnWidth = 18;
+  static const unsigned long kMinColumnWidth = 9;
+
+  // Sorted ascending, in milliseconds
+  std::vector<double> latencies;
+
+  static std::string PadLabel(const std::string &text, const std::string &key, bool is_first);
+};
+
+} // namespace bench
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_BENCHMARK
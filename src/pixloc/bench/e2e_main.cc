@@ -0,0 +1,524 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "external/clara.hpp"
+#include "pixloc/bench/benchmark.h"
+#include "pixloc/bench/xvfb_server.h"
+
+/**
+ * pixloc_e2e_bench: wall-clock latency and correctness of the pixloc executable, incl. X capture and process startup,
+ * for every mode, capture backend and rectangle size, against a headless Xvfb server
+ */
+namespace {
+
+using pixloc::bench::BenchmarkResult;
+using pixloc::bench::XvfbServer;
+
+struct Options {
+  std::string pixloc;
+  std::string xvfb = "Xvfb";
+  std::string screen = "1920x1080x24";
+  std::string backend = "all";
+  std::string transport = "all";
+  std::string filter;
+  unsigned int iterations = 10;
+  bool json = false;
+  bool show_help = false;
+};
+
+const unsigned int kColorBackground = 0xf0f0f0;
+const unsigned int kColorFind = 0xbcbcbc;
+const unsigned int kColorOther = 0x202020;
+const char *const kFindColor = "188,188,188";
+
+// Scanned rectangles end at the bottom-right corner of the needle, so first-hit searches scan them completely
+const unsigned short kRectangleSizes[][2] = {{64, 64}, {256, 256}, {1024, 768}, {0xffff, 0xffff}};
+
+const unsigned short kRunLength = 8;
+const unsigned short kBitmaskWidth = 16;
+const unsigned short kBitmaskHeight = 8;
+const unsigned short kImageSize = 32;
+const unsigned short kAmountTemplates = 16;
+
+// Known patterns at known positions, close to the bottom-right corner of the screen
+struct Scene {
+  unsigned short width;
+  unsigned short height;
+
+  unsigned short run_x, run_y;                // Horizontal run of kRunLength pixels
+  unsigned short column_x, column_y;          // Vertical run of kRunLength pixels
+  unsigned short bitmask_x, bitmask_y;
+  unsigned short image_x, image_y;            // Noise patch, w/ the bitmask painted on top
+  unsigned short mouse_x, mouse_y;
+
+  std::string bitmask;
+  std::vector<unsigned int> image;            // Pixels of noise patch incl. bitmask, as painted
+
+  std::string directory;                      // Temporary files: image, library, daemon socket
+};
+
+// One query of a mode on one rectangle, w/ its expected output
+struct Query {
+  std::string mode;
+  std::vector<std::string> arguments;
+  unsigned long pixels;
+  std::string rectangle;
+
+  // Output must contain the expected text, or consist of the expected amount of lines
+  std::string expected_output;
+  unsigned long expected_lines;
+};
+
+std::string GenerateBitmask(unsigned short width, unsigned short height, std::mt19937 &random) {
+  std::string bitmask;
+  for (unsigned short y = 0; y < height; ++y) {
+    if (y > 0) bitmask += ',';
+    for (unsigned short x = 0; x < width; ++x) bitmask += random() & 1 ? '*' : '_';
+  }
+
+  return bitmask;
+}
+
+std::string FormatCoordinate(unsigned short x, unsigned short y) {
+  // pixloc outputs coordinates found in bitmask modes offset by -1
+  return "x=" + std::to_string(x - 1) + "; y=" + std::to_string(y - 1) + ";";
+}
+
+Scene CreateScene(unsigned short width, unsigned short height, const std::string &directory) {
+  if (width < 320 || height < 240) throw "Screen must be at least 320x240 pixels.";
+
+  Scene scene;
+  scene.width = width;
+  scene.height = height;
+  scene.directory = directory;
+
+  scene.run_x = static_cast<unsigned short>(width - 40);
+  scene.run_y = static_cast<unsigned short>(height - 10);
+  scene.column_x = static_cast<unsigned short>(width - 10);
+  scene.column_y = static_cast<unsigned short>(height - 40);
+  scene.bitmask_x = static_cast<unsigned short>(width - 80);
+  scene.bitmask_y = static_cast<unsigned short>(height - 60);
+  scene.image_x = static_cast<unsigned short>(scene.bitmask_x - 8);
+  scene.image_y = static_cast<unsigned short>(scene.bitmask_y - 8);
+  scene.mouse_x = static_cast<unsigned short>(width/2);
+  scene.mouse_y = static_cast<unsigned short>(height/2);
+
+  std::mt19937 random(7);
+  scene.bitmask = GenerateBitmask(kBitmaskWidth, kBitmaskHeight, random);
+
+  scene.image.resize(kImageSize*kImageSize);
+  for (auto &pixel : scene.image) {
+    pixel = static_cast<unsigned int>(random()) & 0xffffff;
+    if (pixel==kColorFind) pixel = kColorOther;
+  }
+  for (unsigned short y = 0; y < kBitmaskHeight; ++y) {
+    for (unsigned short x = 0; x < kBitmaskWidth; ++x) {
+      scene.image[(y + 8)*kImageSize + x + 8] = scene.bitmask[y*(kBitmaskWidth + 1) + x]=='*'
+                                                ? kColorFind
+                                                : kColorOther;
+    }
+  }
+
+  // Image needle as binary PPM
+  std::ofstream image_file(directory + "/image.ppm", std::ios::binary);
+  image_file << "P6\n" << kImageSize << " " << kImageSize << "\n255\n";
+  for (unsigned int pixel : scene.image) {
+    image_file.put(static_cast<char>(pixel >> 16)).put(static_cast<char>(pixel >> 8)).put(static_cast<char>(pixel));
+  }
+
+  // Library: the painted bitmask and random templates that are not on the screen
+  std::ofstream library_file(directory + "/library.txt");
+  library_file << "painted " << kFindColor << " " << scene.bitmask << "\n";
+  for (unsigned short index = 1; index < kAmountTemplates; ++index) {
+    library_file << "template_" << index << " " << kFindColor << " "
+                 << GenerateBitmask(static_cast<unsigned short>(6 + random()%15),
+                                    static_cast<unsigned short>(4 + random()%9), random) << "\n";
+  }
+
+  if (!image_file || !library_file) throw "Failed to write needle files.";
+
+  return scene;
+}
+
+// Paint scene w/ plain Xlib drawing calls into the background of a screen-covering window, which the X server
+// repaints on its own. The window stays mapped until the display connection is closed
+void PaintScene(Display *display, const Scene &scene) {
+  int screen = DefaultScreen(display);
+  Visual *visual = DefaultVisual(display, screen);
+  if (visual->red_mask!=0xff0000 || visual->green_mask!=0x00ff00 || visual->blue_mask!=0x0000ff)
+    throw "Screen must be of depth 24, e.g. --screen 1920x1080x24.";
+
+  Window root = RootWindow(display, screen);
+  Pixmap pixmap = XCreatePixmap(display, root, scene.width, scene.height,
+                                static_cast<unsigned int>(DefaultDepth(display, screen)));
+  GC gc = XCreateGC(display, pixmap, 0, nullptr);
+
+  XSetForeground(display, gc, kColorBackground);
+  XFillRectangle(display, pixmap, gc, 0, 0, scene.width, scene.height);
+
+  for (unsigned short y = 0; y < kImageSize; ++y) {
+    for (unsigned short x = 0; x < kImageSize; ++x) {
+      XSetForeground(display, gc, scene.image[y*kImageSize + x]);
+      XDrawPoint(display, pixmap, gc, scene.image_x + x, scene.image_y + y);
+    }
+  }
+
+  XSetForeground(display, gc, kColorFind);
+  XFillRectangle(display, pixmap, gc, scene.run_x, scene.run_y, kRunLength, 1);
+  XFillRectangle(display, pixmap, gc, scene.column_x, scene.column_y, 1, kRunLength);
+
+  XSetWindowAttributes attributes{};
+  attributes.override_redirect = True;
+  attributes.background_pixmap = pixmap;
+  Window window = XCreateWindow(display, root, 0, 0, scene.width, scene.height, 0, CopyFromParent, InputOutput,
+                                CopyFromParent, CWOverrideRedirect | CWBackPixmap, &attributes);
+
+  XSelectInput(display, window, ExposureMask);
+  XMapRaised(display, window);
+
+  XEvent event;
+  XWindowEvent(display, window, ExposureMask, &event);
+
+  XWarpPointer(display, None, root, 0, 0, 0, 0, scene.mouse_x, scene.mouse_y);
+  XFreeGC(display, gc);
+  XSync(display, False);
+}
+
+// Rectangle of given size, ending at given exclusive bottom-right corner, clipped to the valid from coordinate of 1,1
+void ResolveRectangle(unsigned short end, unsigned short size, unsigned short &from, unsigned short &range) {
+  from = static_cast<unsigned short>(end > size + 1 ? end - size : 1);
+  range = static_cast<unsigned short>(end - from);
+}
+
+std::vector<Query> CreateQueries(const Scene &scene, unsigned short width, unsigned short height, bool is_first) {
+  std::vector<Query> queries;
+  unsigned short from_x, from_y, range_x, range_y;
+
+  auto add = [&queries](const std::string &mode, std::vector<std::string> arguments, unsigned long pixels,
+                        const std::string &rectangle, const std::string &expected_output,
+                        unsigned long expected_lines) {
+    arguments.insert(arguments.begin(), {"--mode", mode});
+    queries.push_back(Query{mode, arguments, pixels, rectangle, expected_output, expected_lines});
+  };
+  auto tupel = [](unsigned short a, unsigned short b) { return std::to_string(a) + "," + std::to_string(b); };
+  auto rectangle = [](unsigned short a, unsigned short b) { return std::to_string(a) + "x" + std::to_string(b); };
+
+  // Uniaxial modes: output offset of last pixel of the run within the scanned row/column
+  ResolveRectangle(static_cast<unsigned short>(scene.run_x + kRunLength), width, from_x, range_x);
+  add("find horizontal",
+      {"--from", tupel(from_x, scene.run_y), "--range", std::to_string(range_x), "--color", kFindColor,
+       "--amount", std::to_string(kRunLength)},
+      range_x, rectangle(range_x, 1), "x:" + std::to_string(scene.run_x - from_x + kRunLength - 1) + ";", 0);
+  add("trace horizontal", {"--from", tupel(from_x, scene.run_y), "--range", std::to_string(range_x)},
+      range_x, rectangle(range_x, 1), "", range_x);
+
+  ResolveRectangle(static_cast<unsigned short>(scene.column_y + kRunLength), height, from_y, range_y);
+  add("find vertical",
+      {"--from", tupel(scene.column_x, from_y), "--range", std::to_string(range_y), "--color", kFindColor,
+       "--amount", std::to_string(kRunLength)},
+      range_y, rectangle(1, range_y), "y:" + std::to_string(scene.column_y - from_y + kRunLength - 1) + ";", 0);
+  add("trace vertical", {"--from", tupel(scene.column_x, from_y), "--range", std::to_string(range_y)},
+      range_y, rectangle(1, range_y), "", range_y);
+
+  // Bitmask modes
+  ResolveRectangle(static_cast<unsigned short>(scene.bitmask_x + kBitmaskWidth), width, from_x, range_x);
+  ResolveRectangle(static_cast<unsigned short>(scene.bitmask_y + kBitmaskHeight), height, from_y, range_y);
+  unsigned long pixels = static_cast<unsigned long>(range_x)*range_y;
+  std::vector<std::string> bitmask_rectangle{"--from", tupel(from_x, from_y), "--range", tupel(range_x, range_y),
+                                             "--color", kFindColor};
+
+  std::vector<std::string> arguments = bitmask_rectangle;
+  arguments.insert(arguments.end(), {"--bitmask", scene.bitmask});
+  add("find bitmask", arguments, pixels, rectangle(range_x, range_y),
+      FormatCoordinate(scene.bitmask_x, scene.bitmask_y), 0);
+  add("find all bitmask", arguments, pixels, rectangle(range_x, range_y),
+      FormatCoordinate(scene.bitmask_x, scene.bitmask_y), 0);
+
+  arguments = bitmask_rectangle;
+  arguments.insert(arguments.end(), {"--library", scene.directory + "/library.txt"});
+  add("find library", arguments, pixels, rectangle(range_x, range_y),
+      "painted: " + FormatCoordinate(scene.bitmask_x, scene.bitmask_y), 0);
+
+  add("trace bitmask", bitmask_rectangle, pixels, rectangle(range_x, range_y), "", range_y);
+
+  // Image modes: the background dominates also the smallest rectangle around the noise patch
+  ResolveRectangle(static_cast<unsigned short>(scene.image_x + kImageSize), width, from_x, range_x);
+  ResolveRectangle(static_cast<unsigned short>(scene.image_y + kImageSize), height, from_y, range_y);
+  pixels = static_cast<unsigned long>(range_x)*range_y;
+
+  add("find image",
+      {"--from", tupel(from_x, from_y), "--range", tupel(range_x, range_y), "--image", scene.directory + "/image.ppm"},
+      pixels, rectangle(range_x, range_y), FormatCoordinate(scene.image_x, scene.image_y), 0);
+  add("trace main color", {"--from", tupel(from_x, from_y), "--range", tupel(range_x, range_y)},
+      pixels, rectangle(range_x, range_y), "240,240,240", 0);
+
+  // Mouse position is independent of the rectangle
+  if (is_first)
+    add("trace mouse", {"--from", "1,1", "--range", "1,1"}, 1, "1x1",
+        "x=" + std::to_string(scene.mouse_x) + "; y=" + std::to_string(scene.mouse_y) + ";", 0);
+
+  return queries;
+}
+
+// Run given executable w/ given arguments, collect its standard output. Returns exit status, or -1 on failure
+int RunProcess(const std::vector<std::string> &arguments, std::string &output) {
+  int output_pipe[2];
+  if (pipe(output_pipe)==-1) return -1;
+
+  pid_t pid = fork();
+  if (pid==-1) return -1;
+
+  if (pid==0) {
+    std::vector<char *> argv;
+    for (const auto &argument : arguments) argv.push_back(const_cast<char *>(argument.c_str()));
+    argv.push_back(nullptr);
+
+    int null_device = open("/dev/null", O_WRONLY);
+    dup2(output_pipe[1], STDOUT_FILENO);
+    if (null_device!=-1) dup2(null_device, STDERR_FILENO);
+    close(output_pipe[0]);
+    close(output_pipe[1]);
+
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+
+  close(output_pipe[1]);
+
+  output.clear();
+  char buffer[4096];
+  ssize_t amount_read;
+  while ((amount_read = read(output_pipe[0], buffer, sizeof(buffer))) > 0)
+    output.append(buffer, static_cast<unsigned long>(amount_read));
+  close(output_pipe[0]);
+
+  int status;
+  if (waitpid(pid, &status, 0)==-1 || !WIFEXITED(status)) return -1;
+
+  return WEXITSTATUS(status);
+}
+
+// Wait for daemon to accept connections on given socket
+bool WaitForSocket(const std::string &path) {
+  struct sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  for (unsigned short attempt = 0; attempt < 100; ++attempt) {
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    bool is_connected = connection!=-1 &&
+        connect(connection, reinterpret_cast<struct sockaddr *>(&address), sizeof(address))==0;
+    if (connection!=-1) close(connection);
+    if (is_connected) return true;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  return false;
+}
+
+bool IsValidOutput(const Query &query, const std::string &output) {
+  if (!query.expected_output.empty()) return output.find(query.expected_output)!=std::string::npos;
+
+  return static_cast<unsigned long>(std::count(output.begin(), output.end(), '\n'))==query.expected_lines;
+}
+
+std::string ToName(std::string mode) {
+  std::replace(mode.begin(), mode.end(), ' ', '_');
+
+  return mode;
+}
+
+// Benchmark all queries of all rectangle sizes, via one process per query or via a daemon. Returns validity
+bool RunQueries(const Options &options, const Scene &scene, const std::string &backend, const std::string &transport,
+                bool &is_header_written) {
+  std::vector<std::string> prefix{options.pixloc};
+  pid_t daemon_pid = -1;
+  std::string socket_path = scene.directory + "/daemon.sock";
+
+  if (transport=="daemon") {
+    daemon_pid = fork();
+    if (daemon_pid==0) {
+      execl(options.pixloc.c_str(), options.pixloc.c_str(), "--serve", socket_path.c_str(),
+            "--input", ("x11:" + backend).c_str(), static_cast<char *>(nullptr));
+      _exit(127);
+    }
+    if (daemon_pid==-1 || !WaitForSocket(socket_path)) throw "Failed to start pixloc daemon.";
+
+    prefix.insert(prefix.end(), {"--client", socket_path});
+  } else {
+    prefix.insert(prefix.end(), {"--input", "x11:" + backend});
+  }
+
+  bool is_valid = true;
+  bool is_first = true;
+  for (const auto &size : kRectangleSizes) {
+    for (const auto &query : CreateQueries(scene, size[0], size[1], is_first)) {
+      std::string name = ToName(query.mode);
+      if (!options.filter.empty() && name.find(options.filter)==std::string::npos) continue;
+
+      std::vector<std::string> arguments = prefix;
+      arguments.insert(arguments.end(), query.arguments.begin(), query.arguments.end());
+
+      std::string output;
+      BenchmarkResult result = BenchmarkResult::Measure([&]() {
+        return RunProcess(arguments, output) >= 0 && IsValidOutput(query, output);
+      }, options.iterations);
+
+      result.labels = {{"mode", name}, {"backend", backend}, {"transport", transport}, {"rectangle", query.rectangle}};
+      result.pixels = query.pixels;
+      if (!result.is_valid) is_valid = false;
+
+      if (!options.json && !is_header_written) {
+        std::cout << result.FormatTextHeader() << std::endl;
+        is_header_written = true;
+      }
+      std::cout << (options.json ? result.FormatJson() : result.FormatText()) << std::endl;
+    }
+    is_first = false;
+  }
+
+  if (daemon_pid > 0) {
+    kill(daemon_pid, SIGTERM);
+    waitpid(daemon_pid, nullptr, 0);
+    unlink(socket_path.c_str());
+  }
+
+  return is_valid;
+}
+
+clara::Parser CreateParser(Options &options) {
+  using namespace clara;
+
+  return Opt(options.pixloc, "path")["--pixloc"]("pixloc executable, default: next to this one").optional() |
+      Opt(options.xvfb, "path")["--xvfb"]("Xvfb executable, default: Xvfb").optional() |
+      Opt(options.screen, "geometry")["--screen"]("Xvfb screen, default: 1920x1080x24").optional() |
+      Opt(options.backend, "backend")["--backend"]("xshm, xgetimage or all (default)").optional() |
+      Opt(options.transport,
+          "transport")["--transport"]("cli (process per query), daemon or all (default)").optional() |
+      Opt(options.iterations, "amount")["--iterations"]("timed runs per query, default: 10").optional() |
+      Opt(options.filter, "mode")["--filter"]("only run modes whose name contains given text").optional() |
+      Opt(options.json)["--json"]("output one JSON object per line").optional() |
+      Help(options.show_help);
+}
+
+} // namespace
+
+/**
+ * @param argc Amount of arguments received
+ * @param argv Array of arguments received, argv[0] is name and path of executable
+ */
+int main(int argc, char **argv) {
+  Options options;
+  auto parser = CreateParser(options);
+  auto clara_result = parser.parse(clara::Args(argc, argv));
+
+  if (!clara_result) {
+    std::cerr << "Error: " << clara_result.errorMessage() << "\n";
+    return -1;
+  }
+
+  if (options.show_help) {
+    parser.writeToStream(std::cout);
+    return 0;
+  }
+
+  if (options.pixloc.empty()) {
+    std::string self = argv[0];
+    unsigned long offset_slash = self.rfind('/');
+    options.pixloc = (offset_slash==std::string::npos ? "." : self.substr(0, offset_slash)) + "/pixloc";
+  }
+
+  char directory_template[] = "/tmp/pixloc_e2e_XXXXXX";
+  if (!mkdtemp(directory_template)) {
+    std::cerr << "Error: Failed to create temporary directory.\n";
+    return -1;
+  }
+  std::string directory = directory_template;
+
+  bool is_valid = true;
+  try {
+    XvfbServer server(options.xvfb, options.screen);
+    setenv("DISPLAY", server.GetDisplayName().c_str(), 1);
+
+    Display *display = XOpenDisplay(server.GetDisplayName().c_str());
+    if (!display) throw "Failed to open Xvfb display.";
+
+    Scene scene = CreateScene(static_cast<unsigned short>(DisplayWidth(display, DefaultScreen(display))),
+                              static_cast<unsigned short>(DisplayHeight(display, DefaultScreen(display))),
+                              directory);
+    PaintScene(display, scene);
+
+    bool is_header_written = false;
+    for (const std::string backend : {"xshm", "xgetimage"}) {
+      if (options.backend!="all" && options.backend!=backend) continue;
+
+      // Backends not supported by the server or build are reported and skipped
+      std::string output;
+      if (RunProcess({options.pixloc, "--input", "x11:" + backend, "--mode", "trace mouse", "--from", "1,1",
+                      "--range", "1,1"}, output)!=0) {
+        std::cerr << "Skipping capture backend " << backend << ": not supported\n";
+        continue;
+      }
+
+      for (const std::string transport : {"cli", "daemon"}) {
+        if (options.transport!="all" && options.transport!=transport) continue;
+
+        if (!RunQueries(options, scene, backend, transport, is_header_written)) is_valid = false;
+      }
+    }
+
+    XCloseDisplay(display);
+  } catch (char const *exception) {
+    std::cerr << "Error: " << exception << "\n";
+    is_valid = false;
+  }
+
+  unlink((directory + "/image.ppm").c_str());
+  unlink((directory + "/library.txt").c_str());
+  rmdir(directory.c_str());
+
+  return is_valid ? 0 : 1;
+}
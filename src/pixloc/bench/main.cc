@@ -0,0 +1,715 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "external/clara.hpp"
+#include "pixloc/bench/benchmark.h"
+#include "pixloc/bench/synthetic_frame.h"
+#include "pixloc/models/color_matcher.h"
+#include "pixloc/models/image.h"
+#include "pixloc/models/image_needle.h"
+#include "pixloc/models/pixel_decoder.h"
+#include "pixloc/models/pixel_scanner.h"
+#include "pixloc/models/scan_kernel.h"
+#include "pixloc/models/template_library.h"
+
+/**
+ * pixloc_bench: time the scanning cores of all modes on synthetic frames, independently of X
+ */
+namespace {
+
+using pixloc::bench::BenchmarkResult;
+using pixloc::bench::SyntheticFrame;
+
+struct Options {
+  unsigned int iterations = 20;
+  unsigned short threads = 0;
+  std::string resolution = "all";
+  std::string content = "all";
+  std::string filter;
+  bool json = false;
+  bool verify = false;
+  bool show_help = false;
+};
+
+struct Resolution {
+  const char *name;
+  unsigned short width;
+  unsigned short height;
+};
+
+const Resolution kResolutions[] = {{"1080p", 1920, 1080}, {"1440p", 2560, 1440}, {"4k", 3840, 2160}};
+
+const SyntheticFrame::Content kContents[] = {
+    SyntheticFrame::kFlatUi, SyntheticFrame::kNoisyPhoto, SyntheticFrame::kRepetitiveGrid
+};
+
+const unsigned short kRed = (SyntheticFrame::kColorFind >> 16) & 0xff;
+const unsigned short kGreen = (SyntheticFrame::kColorFind >> 8) & 0xff;
+const unsigned short kBlue = SyntheticFrame::kColorFind & 0xff;
+
+// Needles are painted close to the bottom-right corner, so first-hit searches scan nearly the whole frame
+const unsigned short kBitmaskWidth = 16;
+const unsigned short kBitmaskHeight = 8;
+const unsigned short kImageSize = 32;
+const unsigned short kAmountTemplates = 32;
+
+// Frame w/ needles painted into it, and everything needed to scan it
+struct Workload {
+  std::unique_ptr<SyntheticFrame> frame;
+  std::string resolution;
+  std::string content;
+
+  std::string bitmask;
+  std::string bitmask_coordinate;
+
+  std::unique_ptr<pixloc::Image> image;
+  std::string image_coordinate;
+
+  std::unique_ptr<pixloc::TemplateLibrary> library;
+
+  // Decoded 0x00RRGGBB rows, for kernel benchmarks
+  std::vector<unsigned int> rgb;
+};
+
+// Available match row kernels, from the scalar reference up to the best one supported by the CPU
+std::vector<std::string> GetKernelNames() {
+  std::string best = pixloc::ColorMatcher::GetBestMatchRowKernelName();
+  std::vector<std::string> names{"scalar"};
+
+  if (best=="sse2" || best=="avx2") names.emplace_back("sse2");
+  if (best=="avx2") names.emplace_back("avx2");
+
+  return names;
+}
+
+std::string FormatCoordinate(unsigned short x, unsigned short y) {
+  // Scanners are constructed w/ starting coordinate 1,1: offsets in the frame are output as-is
+  return "x=" + std::to_string(x) + "; y=" + std::to_string(y) + ";\n";
+}
+
+Workload CreateWorkload(const Resolution &resolution, SyntheticFrame::Content content) {
+  Workload workload;
+  workload.frame.reset(new SyntheticFrame(resolution.width, resolution.height, content));
+  workload.resolution = std::to_string(resolution.width) + "x" + std::to_string(resolution.height);
+  workload.content = SyntheticFrame::GetContentName(content);
+
+  std::mt19937 random(7);
+  SyntheticFrame &frame = *workload.frame;
+
+  auto bitmask_x = static_cast<unsigned short>(resolution.width - 64);
+  auto bitmask_y = static_cast<unsigned short>(resolution.height - 40);
+  workload.bitmask = SyntheticFrame::GenerateBitmask(kBitmaskWidth, kBitmaskHeight, random);
+  workload.bitmask_coordinate = FormatCoordinate(bitmask_x, bitmask_y);
+  frame.PaintBitmask(pixloc::Bitmask(workload.bitmask), bitmask_x, bitmask_y, SyntheticFrame::kColorFind);
+
+  // Image needle surrounds the painted bitmask, so it is unique also within repetitive content
+  auto image_x = static_cast<unsigned short>(bitmask_x - 8);
+  auto image_y = static_cast<unsigned short>(bitmask_y - 8);
+  workload.image.reset(new pixloc::Image(kImageSize, kImageSize,
+                                         frame.CopyRectangle(image_x, image_y, kImageSize, kImageSize).data()));
+  workload.image_coordinate = FormatCoordinate(image_x, image_y);
+
+  // Library: the painted bitmask and templates of random sizes and colors, not contained in the frame
+  std::stringstream library;
+  library << "painted " << kRed << "," << kGreen << "," << kBlue << " " << workload.bitmask << "\n";
+  for (unsigned short index = 1; index < kAmountTemplates; ++index) {
+    unsigned int rgb = index & 1 ? SyntheticFrame::kColorFind : static_cast<unsigned int>(random()) & 0xffffff;
+
+    library << "template_" << index << " "
+            << ((rgb >> 16) & 0xff) << "," << ((rgb >> 8) & 0xff) << "," << (rgb & 0xff) << " "
+            << SyntheticFrame::GenerateBitmask(static_cast<unsigned short>(6 + random()%15),
+                                               static_cast<unsigned short>(4 + random()%9), random) << "\n";
+  }
+  workload.library.reset(new pixloc::TemplateLibrary(library));
+
+  workload.rgb.resize(static_cast<unsigned long>(resolution.width)*resolution.height);
+
+  return workload;
+}
+
+bool IsSelected(const Options &options, const std::string &name) {
+  return options.filter.empty() || name.find(options.filter)!=std::string::npos;
+}
+
+void Report(const Options &options, BenchmarkResult result, const std::string &name, const std::string &kernel,
+            const Workload &workload, unsigned short threads, unsigned long pixels, bool &is_valid) {
+  result.labels = {
+      {"benchmark", name}, {"kernel", kernel}, {"resolution", workload.resolution}, {"content", workload.content},
+      {"threads", std::to_string(threads)}
+  };
+  result.pixels = pixels;
+
+  if (!result.is_valid) is_valid = false;
+
+  static bool is_header_written = false;
+  if (!options.json && !is_header_written) {
+    std::cout << result.FormatTextHeader() << std::endl;
+    is_header_written = true;
+  }
+
+  std::cout << (options.json ? result.FormatJson() : result.FormatText()) << std::endl;
+}
+
+// Compare SIMD match row kernels against the scalar reference on random rows of all widths up to 67 pixels, i.e.
+// w/ and w/o tails not filling a vector, of random colors and per-channel tolerances. Return amount of mismatches
+unsigned long VerifyMatchRowKernelsOnRandomRows(const Options &options) {
+  const unsigned short kMaxWidth = 67;
+  const unsigned int kRowsPerWidth = 2000;
+  // Guard word behind the bitmap of each row: kernels must not write beyond GetAmountWords(width)
+  const uint64_t kGuard = 0x5a5a5a5a5a5a5a5a;
+
+  std::mt19937 random(17);
+  std::vector<unsigned int> rgb_row(kMaxWidth);
+  std::vector<uint64_t> bitmap_reference(pixloc::Bitmask::GetAmountWords(kMaxWidth) + 1);
+  std::vector<uint64_t> bitmap(bitmap_reference.size());
+  unsigned long amount_mismatches_total = 0;
+
+  // Channel value near given one: within its tolerance, or just beyond
+  auto vary_channel = [&random](unsigned int value, unsigned short tolerance) {
+    int varied = static_cast<int>(value) + static_cast<int>(random()%(2u*tolerance + 5)) - tolerance - 2;
+
+    return static_cast<unsigned int>(varied < 0 ? 0 : (varied > 255 ? 255 : varied));
+  };
+
+  for (const auto &kernel : GetKernelNames()) {
+    if (kernel=="scalar") continue;
+
+    auto match_row = pixloc::ColorMatcher::GetMatchRowKernel(kernel.c_str());
+    unsigned long amount_mismatches = 0;
+
+    for (unsigned short width = 0; width <= kMaxWidth; ++width) {
+      unsigned short amount_words = pixloc::Bitmask::GetAmountWords(width);
+
+      for (unsigned int index = 0; index < kRowsPerWidth; ++index) {
+        unsigned int rgb_find = static_cast<unsigned int>(random()) & 0xffffff;
+        pixloc::ColorTolerance tolerance;
+        // Tolerances incl. none and ones reaching beyond 0 and 255
+        unsigned short max_tolerance = index%4==0 ? 0 : (index%4==1 ? 255 : 64);
+        tolerance.red = static_cast<unsigned short>(random()%(max_tolerance + 1u));
+        tolerance.green = static_cast<unsigned short>(random()%(max_tolerance + 1u));
+        tolerance.blue = static_cast<unsigned short>(random()%(max_tolerance + 1u));
+
+        pixloc::ColorMatcher matcher(static_cast<unsigned short>(rgb_find >> 16),
+                                     static_cast<unsigned short>((rgb_find >> 8) & 0xff),
+                                     static_cast<unsigned short>(rgb_find & 0xff), tolerance);
+
+        for (unsigned short x = 0; x < width; ++x) {
+          rgb_row[x] = random()%2
+                       ? static_cast<unsigned int>(random()) & 0xffffff
+                       : (vary_channel(rgb_find >> 16, tolerance.red) << 16)
+                           | (vary_channel((rgb_find >> 8) & 0xff, tolerance.green) << 8)
+                           | vary_channel(rgb_find & 0xff, tolerance.blue);
+        }
+
+        std::fill(bitmap_reference.begin(), bitmap_reference.end(), kGuard);
+        std::fill(bitmap.begin(), bitmap.end(), kGuard);
+        pixloc::ColorMatcher::MatchRowScalar(matcher, rgb_row.data(), width, bitmap_reference.data());
+        match_row(matcher, rgb_row.data(), width, bitmap.data());
+
+        if (!std::equal(bitmap.begin(), bitmap.begin() + amount_words + 1, bitmap_reference.begin()))
+          ++amount_mismatches;
+      }
+    }
+
+    if (options.json)
+      std::cout << "{\"verify\":\"color_matcher_random\",\"kernel\":\"" << kernel
+                << "\",\"mismatches\":" << amount_mismatches << "}" << std::endl;
+    else
+      std::cout << "verify color_matcher_random " << kernel << ": " << (amount_mismatches==0 ? "ok" : "MISMATCH")
+                << std::endl;
+
+    amount_mismatches_total += amount_mismatches;
+  }
+
+  return amount_mismatches_total;
+}
+
+// Compare SIMD kernels against the scalar reference kernels, return amount of mismatches
+unsigned long VerifyKernels(const Options &options, Workload &workload, const pixloc::PixelDecoder &decoder) {
+  const pixloc::Frame &frame = workload.frame->GetFrame();
+  unsigned short words_per_row = pixloc::Bitmask::GetAmountWords(frame.width);
+  std::vector<uint64_t> bitmap_reference(words_per_row), bitmap(words_per_row);
+  std::mt19937 random(11);
+  unsigned long amount_mismatches_total = 0;
+
+  for (unsigned short y = 0; y < frame.height; ++y) decoder.DecodeRow(frame, y, &workload.rgb[y*frame.width]);
+
+  for (const auto &kernel : GetKernelNames()) {
+    if (kernel=="scalar") continue;
+
+    // Color matcher: every row, at several (per-channel) tolerances
+    unsigned long amount_mismatches = 0;
+    auto match_row = pixloc::ColorMatcher::GetMatchRowKernel(kernel.c_str());
+    pixloc::ColorTolerance tolerances[] = {
+        pixloc::ColorTolerance(0), pixloc::ColorTolerance(10), pixloc::ColorTolerance(60), pixloc::ColorTolerance(0)
+    };
+    tolerances[3].red = 40;
+    tolerances[3].blue = 90;
+
+    for (const auto &tolerance : tolerances) {
+      pixloc::ColorMatcher matcher(kRed, kGreen, kBlue, tolerance);
+
+      for (unsigned short y = 0; y < frame.height; ++y) {
+        const unsigned int *rgb_row = &workload.rgb[y*frame.width];
+        pixloc::ColorMatcher::MatchRowScalar(matcher, rgb_row, frame.width, bitmap_reference.data());
+        match_row(matcher, rgb_row, frame.width, bitmap.data());
+
+        if (bitmap!=bitmap_reference) ++amount_mismatches;
+      }
+    }
+
+    // Image needle: random needle rows w/ transparent pixels, at random offsets, incl. the matching one
+    unsigned long amount_image_mismatches = 0;
+    auto match_image_row = pixloc::ImageNeedle::GetMatchRowKernel(kernel.c_str());
+    const unsigned short needle_width = 37;
+    std::vector<unsigned int> masks(needle_width);
+
+    for (unsigned int index = 0; index < 100000; ++index) {
+      auto needle_x = static_cast<unsigned short>(random()%(frame.width - needle_width));
+      auto needle_y = static_cast<unsigned short>(random()%frame.height);
+      auto haystack_x = index & 1 ? needle_x : static_cast<unsigned short>(random()%(frame.width - needle_width));
+      auto haystack_y = index & 1 ? needle_y : static_cast<unsigned short>(random()%frame.height);
+      unsigned int packed_tolerance = ((random()%40) << 16) | ((random()%40) << 8) | (random()%40);
+
+      for (auto &mask : masks) mask = random()%10==0 ? 0 : 0x00ffffff;
+
+      const unsigned int *needle = &workload.rgb[needle_y*frame.width + needle_x];
+      const unsigned int *haystack = &workload.rgb[haystack_y*frame.width + haystack_x];
+
+      if (match_image_row(haystack, needle, masks.data(), needle_width, packed_tolerance)!=
+          pixloc::ImageNeedle::MatchRowScalar(haystack, needle, masks.data(), needle_width, packed_tolerance))
+        ++amount_image_mismatches;
+    }
+
+    const std::pair<const char *, unsigned long> checks[] = {
+        {"color_matcher", amount_mismatches}, {"image_needle", amount_image_mismatches}
+    };
+    for (const auto &check : checks) {
+      if (options.json)
+        std::cout << "{\"verify\":\"" << check.first << "\",\"kernel\":\"" << kernel
+                  << "\",\"resolution\":\"" << workload.resolution << "\",\"content\":\"" << workload.content
+                  << "\",\"mismatches\":" << check.second << "}" << std::endl;
+      else
+        std::cout << "verify " << check.first << " " << kernel << " " << workload.resolution << " "
+                  << workload.content << ": " << (check.second==0 ? "ok" : "MISMATCH") << std::endl;
+
+      amount_mismatches_total += check.second;
+    }
+  }
+
+  return amount_mismatches_total;
+}
+
+// Pixel layout to re-encode synthetic frames into: channel masks of a TrueColor visual, or w/o masks a palette visual
+struct EncodedLayout {
+  const char *name;
+  unsigned short bits_per_pixel;
+  bool is_lsb_first;
+  unsigned long red_mask;
+  unsigned long green_mask;
+  unsigned long blue_mask;
+  // Layout the scan kernels are expected to be specialized on
+  const char *kernel_layout;
+};
+
+// Every layout the scan kernels are instantiated for, incl. masked ones of all pixel sizes
+const EncodedLayout kEncodedLayouts[] = {
+    {"bgrx32", 32, true, 0xff0000, 0x00ff00, 0x0000ff, "bgrx32"},
+    {"bgr24", 24, true, 0xff0000, 0x00ff00, 0x0000ff, "bgr24"},
+    {"rgb565", 16, true, 0xf800, 0x07e0, 0x001f, "rgb565"},
+    {"rgbx32", 32, true, 0x0000ff, 0x00ff00, 0xff0000, "masked"},
+    {"xrgb32_msb", 32, false, 0xff0000, 0x00ff00, 0x0000ff, "masked"},
+    {"rgb24", 24, true, 0x0000ff, 0x00ff00, 0xff0000, "masked"},
+    {"rgb24_msb", 24, false, 0xff0000, 0x00ff00, 0x0000ff, "masked"},
+    {"rgb555", 16, true, 0x7c00, 0x03e0, 0x001f, "masked"},
+    {"rgb565_msb", 16, false, 0xf800, 0x07e0, 0x001f, "masked"},
+    {"rgb332", 8, true, 0xe0, 0x1c, 0x03, "masked"},
+    {"palette8", 8, true, 0, 0, 0, "masked"}
+};
+
+// Colors of the palette visual: the synthetic frames' colors to find and other, the rest random
+std::vector<unsigned int> CreatePalette() {
+  std::mt19937 random(13);
+  std::vector<unsigned int> palette(256);
+  for (auto &rgb : palette) rgb = static_cast<unsigned int>(random()) & 0xffffff;
+
+  palette[1] = SyntheticFrame::kColorFind;
+  palette[2] = SyntheticFrame::kColorOther;
+
+  return palette;
+}
+
+// Encode given packed 0xRRGGBB color into a raw pixel value of given layout. Set the color it must be decoded into:
+// the color itself w/ 8 bits per channel, the channel values of less bits scaled to 0..255, resp. the palette's color
+unsigned long EncodePixel(unsigned int rgb, const EncodedLayout &layout, const std::vector<unsigned int> &palette,
+                          unsigned int &rgb_decoded) {
+  if (layout.red_mask==0) {
+    unsigned long index = rgb==SyntheticFrame::kColorFind ? 1 : (rgb==SyntheticFrame::kColorOther ? 2 : 3 + rgb%253);
+    rgb_decoded = palette[index];
+
+    return index;
+  }
+
+  const unsigned long masks[] = {layout.red_mask, layout.green_mask, layout.blue_mask};
+  unsigned long pixel = 0;
+  rgb_decoded = 0;
+
+  for (unsigned short channel = 0; channel < 3; ++channel) {
+    unsigned long mask = masks[channel];
+    unsigned short shift = 0, bits = 0;
+    while (!((mask >> shift) & 1)) ++shift;
+    while ((mask >> (shift + bits)) & 1) ++bits;
+
+    unsigned long value = ((rgb >> (16 - 8*channel)) & 0xff) >> (8 - bits);
+    unsigned long max_value = (1UL << bits) - 1;
+    pixel |= value << shift;
+    rgb_decoded |= static_cast<unsigned int>((value*255 + max_value/2)/max_value) << (16 - 8*channel);
+  }
+
+  return pixel;
+}
+
+// Compare the fused decode and match kernels, and PixelDecoder::DecodeRow(), of all pixel layouts against the
+// colors the synthetic frame was encoded from, matched one pixel at a time. Return amount of mismatching rows
+unsigned long VerifyScanKernels(const Options &options, const Workload &workload) {
+  const SyntheticFrame &synthetic = *workload.frame;
+  const pixloc::Frame &source = synthetic.GetFrame();
+  // Narrower than the frame, so the last bitmap word of every row is partial
+  auto width = static_cast<unsigned short>(source.width - 27);
+  unsigned short words_per_row = pixloc::Bitmask::GetAmountWords(width);
+  const std::vector<unsigned int> palette = CreatePalette();
+  unsigned long amount_mismatches_total = 0;
+
+  for (const auto &layout : kEncodedLayouts) {
+    std::unique_ptr<pixloc::PixelDecoder> decoder(
+        layout.red_mask==0
+        ? new pixloc::PixelDecoder(palette)
+        : new pixloc::PixelDecoder(layout.red_mask, layout.green_mask, layout.blue_mask));
+    unsigned short bytes_per_pixel = layout.bits_per_pixel/8;
+
+    pixloc::Frame frame;
+    frame.width = width;
+    frame.height = source.height;
+    frame.stride = static_cast<unsigned int>(source.width)*bytes_per_pixel;
+    frame.bits_per_pixel = layout.bits_per_pixel;
+    frame.is_lsb_first = layout.is_lsb_first;
+
+    std::vector<unsigned char> data(static_cast<unsigned long>(frame.stride)*frame.height);
+    std::vector<unsigned int> rgb_decoded(static_cast<unsigned long>(width)*frame.height);
+    unsigned int rgb_find = 0;
+    EncodePixel(SyntheticFrame::kColorFind, layout, palette, rgb_find);
+
+    for (unsigned short y = 0; y < source.height; ++y) {
+      for (unsigned short x = 0; x < source.width; ++x) {
+        unsigned int rgb;
+        unsigned long pixel = EncodePixel(synthetic.GetPixel(x, y), layout, palette, rgb);
+        unsigned char *p = &data[static_cast<unsigned long>(y)*frame.stride + x*bytes_per_pixel];
+
+        for (unsigned short index = 0; index < bytes_per_pixel; ++index) {
+          unsigned short shift = 8*(layout.is_lsb_first ? index : bytes_per_pixel - 1 - index);
+          p[index] = static_cast<unsigned char>(pixel >> shift);
+        }
+
+        if (x < width) rgb_decoded[static_cast<unsigned long>(y)*width + x] = rgb;
+      }
+    }
+    frame.data = data.data();
+
+    // Matchers of the color to find as decoded in this layout, so exact matching finds pixels in all layouts
+    auto red = static_cast<unsigned short>(rgb_find >> 16);
+    auto green = static_cast<unsigned short>((rgb_find >> 8) & 0xff);
+    auto blue = static_cast<unsigned short>(rgb_find & 0xff);
+    pixloc::ColorTolerance tolerances[] = {pixloc::ColorTolerance(0), pixloc::ColorTolerance(10),
+                                           pixloc::ColorTolerance(0), pixloc::ColorTolerance(0)};
+    tolerances[2].red = 40;
+    tolerances[2].blue = 90;
+    tolerances[3].distance = pixloc::ColorTolerance::kDistanceCie76;
+    tolerances[3].max_distance = 10;
+
+    std::vector<pixloc::ColorMatcher> matchers;
+    for (const auto &tolerance : tolerances) matchers.emplace_back(red, green, blue, tolerance);
+    matchers.emplace_back(std::vector<pixloc::MatchColor>{
+        pixloc::MatchColor(red, green, blue, pixloc::ColorTolerance(4)),
+        pixloc::MatchColor(0x20, 0x20, 0x20, pixloc::ColorTolerance(0))});
+
+    std::vector<unsigned int> rgb_row(width);
+    std::vector<uint64_t> bitmap_reference(words_per_row), bitmap(words_per_row);
+    std::vector<std::pair<std::string, unsigned long>> checks{{"decode_row", 0}};
+
+    for (unsigned short y = 0; y < frame.height; ++y) {
+      decoder->DecodeRow(frame, y, rgb_row.data());
+      if (!std::equal(rgb_row.begin(), rgb_row.end(), &rgb_decoded[static_cast<unsigned long>(y)*width]))
+        ++checks[0].second;
+    }
+
+    for (const auto &matcher : matchers) {
+      for (const auto &kernel_name : GetKernelNames()) {
+        pixloc::ScanKernel kernel(*decoder, matcher, frame.bits_per_pixel, frame.is_lsb_first, kernel_name.c_str());
+        std::string name = std::string("scan_kernel ") + kernel.GetName();
+        // Scalar and SSE2 share the baseline instantiation
+        if (checks.back().first==name) continue;
+
+        checks.emplace_back(name, 0);
+        // Kernel must be specialized on the expected layout
+        if (std::string(kernel.GetName()).compare(0, strlen(layout.kernel_layout), layout.kernel_layout)!=0)
+          ++checks.back().second;
+
+        for (unsigned short y = 0; y < frame.height; ++y) {
+          const unsigned int *rgb_reference = &rgb_decoded[static_cast<unsigned long>(y)*width];
+          std::fill(bitmap_reference.begin(), bitmap_reference.end(), 0);
+          for (unsigned short x = 0; x < width; ++x)
+            if (matcher.Matches(rgb_reference[x])) bitmap_reference[x >> 6] |= static_cast<uint64_t>(1) << (x & 63);
+
+          kernel.MatchRow(frame.Row(y), width, bitmap.data());
+          if (bitmap!=bitmap_reference) ++checks.back().second;
+        }
+      }
+    }
+
+    for (const auto &check : checks) {
+      if (options.json)
+        std::cout << "{\"verify\":\"" << check.first << "\",\"layout\":\"" << layout.name
+                  << "\",\"resolution\":\"" << workload.resolution << "\",\"content\":\"" << workload.content
+                  << "\",\"mismatches\":" << check.second << "}" << std::endl;
+      else
+        std::cout << "verify " << check.first << " " << layout.name << " " << workload.resolution << " "
+                  << workload.content << ": " << (check.second==0 ? "ok" : "MISMATCH") << std::endl;
+
+      amount_mismatches_total += check.second;
+    }
+  }
+
+  return amount_mismatches_total;
+}
+
+// Run all selected benchmarks on given workload, return whether all of them produced the expected results
+bool RunBenchmarks(const Options &options, Workload &workload, const pixloc::PixelDecoder &decoder) {
+  const pixloc::Frame &frame = workload.frame->GetFrame();
+  const unsigned long pixels = static_cast<unsigned long>(frame.width)*frame.height;
+  const std::string best_kernel = pixloc::ColorMatcher::GetBestMatchRowKernelName();
+
+  std::vector<unsigned short> thread_counts{1};
+  if (options.threads > 1) thread_counts.push_back(options.threads);
+
+  const pixloc::ColorMatcher color_matcher(kRed, kGreen, kBlue, 0);
+  auto create_scanner = [&](unsigned short x, unsigned short y, unsigned short width, unsigned short height) {
+    return std::unique_ptr<pixloc::PixelScanner>(
+        new pixloc::PixelScanner(frame.Crop(x, y, width, height), &decoder, static_cast<unsigned short>(x + 1),
+                                 static_cast<unsigned short>(y + 1), width, height, color_matcher));
+  };
+
+  bool is_valid = true;
+
+  if (IsSelected(options, "decode_row"))
+    Report(options, BenchmarkResult::Measure([&]() {
+      for (unsigned short y = 0; y < frame.height; ++y) decoder.DecodeRow(frame, y, &workload.rgb[y*frame.width]);
+      return true;
+    }, options.iterations), "decode_row", "", workload, 1, pixels, is_valid);
+
+  if (IsSelected(options, "match_row")) {
+    for (unsigned short y = 0; y < frame.height; ++y) decoder.DecodeRow(frame, y, &workload.rgb[y*frame.width]);
+
+    pixloc::ColorMatcher matcher(kRed, kGreen, kBlue, 0);
+    std::vector<uint64_t> bitmap(pixloc::Bitmask::GetAmountWords(frame.width));
+
+    for (const auto &kernel : GetKernelNames()) {
+      auto match_row = pixloc::ColorMatcher::GetMatchRowKernel(kernel.c_str());
+
+      Report(options, BenchmarkResult::Measure([&]() {
+        for (unsigned short y = 0; y < frame.height; ++y)
+          match_row(matcher, &workload.rgb[y*frame.width], frame.width, bitmap.data());
+        return true;
+      }, options.iterations), "match_row", kernel, workload, 1, pixels, is_valid);
+    }
+
+    // Perceptual distance: compiled into a lookup, matched per pixel by MatchRow()
+    pixloc::ColorTolerance tolerance;
+    tolerance.distance = pixloc::ColorTolerance::kDistanceCie76;
+    tolerance.max_distance = 10;
+    pixloc::ColorMatcher lookup_matcher(kRed, kGreen, kBlue, tolerance);
+
+    Report(options, BenchmarkResult::Measure([&]() {
+      for (unsigned short y = 0; y < frame.height; ++y)
+        lookup_matcher.MatchRow(&workload.rgb[y*frame.width], frame.width, bitmap.data());
+      return true;
+    }, options.iterations), "match_row", lookup_matcher.GetKernelName(), workload, 1, pixels, is_valid);
+  }
+
+  // Decoding and matching raw rows at once, like bitmask modes do
+  if (IsSelected(options, "scan_kernel")) {
+    std::vector<uint64_t> bitmap(pixloc::Bitmask::GetAmountWords(frame.width));
+    std::string previous_name;
+
+    for (const auto &kernel_name : GetKernelNames()) {
+      pixloc::ScanKernel kernel(decoder, color_matcher, frame.bits_per_pixel, frame.is_lsb_first, kernel_name.c_str());
+      if (previous_name==kernel.GetName()) continue;
+
+      previous_name = kernel.GetName();
+      Report(options, BenchmarkResult::Measure([&]() {
+        for (unsigned short y = 0; y < frame.height; ++y) kernel.MatchRow(frame.Row(y), frame.width, bitmap.data());
+        return true;
+      }, options.iterations), "scan_kernel", kernel.GetName(), workload, 1, pixels, is_valid);
+    }
+  }
+
+  // Uniaxial modes: every row, resp. every column, scanned like by a single query
+  if (IsSelected(options, "find_horizontal"))
+    Report(options, BenchmarkResult::Measure([&]() {
+      for (unsigned short y = 0; y < frame.height; ++y)
+        create_scanner(0, y, frame.width, 1)->ScanUniaxial(frame.width, 1);
+      return true;
+    }, options.iterations), "find_horizontal", best_kernel, workload, 1, pixels, is_valid);
+
+  if (IsSelected(options, "find_vertical"))
+    Report(options, BenchmarkResult::Measure([&]() {
+      for (unsigned short x = 0; x < frame.width; ++x)
+        create_scanner(x, 0, 1, frame.height)->ScanUniaxial(frame.height, 1);
+      return true;
+    }, options.iterations), "find_vertical", "", workload, 1, pixels, is_valid);
+
+  for (unsigned short threads : thread_counts) {
+    if (IsSelected(options, "trace_main_color"))
+      Report(options, BenchmarkResult::Measure([&]() {
+        std::ostringstream out;
+        create_scanner(0, 0, frame.width, frame.height)->TraceMainColor(out, 0, threads);
+        return !out.str().empty();
+      }, options.iterations), "trace_main_color", "", workload, threads, pixels, is_valid);
+
+    if (IsSelected(options, "find_bitmask"))
+      Report(options, BenchmarkResult::Measure([&]() {
+        return create_scanner(0, 0, frame.width, frame.height)->FindBitmask(workload.bitmask, threads)==
+            workload.bitmask_coordinate;
+      }, options.iterations), "find_bitmask", best_kernel, workload, threads, pixels, is_valid);
+
+    if (IsSelected(options, "find_all_bitmask"))
+      Report(options, BenchmarkResult::Measure([&]() {
+        std::ostringstream out;
+        create_scanner(0, 0, frame.width, frame.height)->FindAllBitmasks(workload.bitmask, 0, threads, out);
+        return out.str().find(workload.bitmask_coordinate)!=std::string::npos;
+      }, options.iterations), "find_all_bitmask", best_kernel, workload, threads, pixels, is_valid);
+
+    if (IsSelected(options, "find_image")) {
+      pixloc::ImageNeedle needle(*workload.image, pixloc::ColorTolerance(0));
+
+      Report(options, BenchmarkResult::Measure([&]() {
+        return create_scanner(0, 0, frame.width, frame.height)->FindImage(needle, threads)==
+            workload.image_coordinate;
+      }, options.iterations), "find_image", best_kernel, workload, threads, pixels, is_valid);
+    }
+
+    if (IsSelected(options, "find_library"))
+      Report(options, BenchmarkResult::Measure([&]() {
+        std::ostringstream out;
+        create_scanner(0, 0, frame.width, frame.height)->FindTemplates(*workload.library, threads, out);
+        return out.str().find("painted: " + workload.bitmask_coordinate)!=std::string::npos;
+      }, options.iterations), "find_library", best_kernel, workload, threads, pixels, is_valid);
+  }
+
+  return is_valid;
+}
+
+clara::Parser CreateParser(Options &options) {
+  using namespace clara;
+
+  return Opt(options.iterations, "amount")["--iterations"]("timed runs per benchmark, default: 20").optional() |
+      Opt(options.threads, "threads")["--threads"]("threads of parallel modes, default: amount of cores").optional() |
+      Opt(options.resolution, "resolution")["--resolution"]("1080p, 1440p, 4k or all (default)").optional() |
+      Opt(options.content, "content")["--content"]("flat, noisy, grid or all (default)").optional() |
+      Opt(options.filter, "name")["--filter"]("only run benchmarks whose name contains given text").optional() |
+      Opt(options.json)["--json"]("output one JSON object per line").optional() |
+      Opt(options.verify)["--verify"]("verify SIMD kernels against scalar reference before benchmarking").optional() |
+      Help(options.show_help);
+}
+
+} // namespace
+
+/**
+ * @param argc Amount of arguments received
+ * @param argv Array of arguments received, argv[0] is name and path of executable
+ */
+int main(int argc, char **argv) {
+  Options options;
+  auto parser = CreateParser(options);
+  auto clara_result = parser.parse(clara::Args(argc, argv));
+
+  if (!clara_result) {
+    std::cerr << "Error: " << clara_result.errorMessage() << "\n";
+    return -1;
+  }
+
+  if (options.show_help) {
+    parser.writeToStream(std::cout);
+    return 0;
+  }
+
+  if (options.threads==0) options.threads = static_cast<unsigned short>(std::thread::hardware_concurrency());
+
+  // Synthetic frames are packed 0x00RRGGBB
+  pixloc::PixelDecoder decoder(0xff0000, 0x00ff00, 0x0000ff);
+
+  bool is_valid = true;
+  bool has_workload = false;
+
+  if (options.verify && VerifyMatchRowKernelsOnRandomRows(options) > 0) is_valid = false;
+
+  try {
+    for (const auto &resolution : kResolutions) {
+      if (options.resolution!="all" && options.resolution!=resolution.name) continue;
+
+      for (auto content : kContents) {
+        if (options.content!="all" && options.content!=SyntheticFrame::GetContentName(content)) continue;
+
+        has_workload = true;
+        Workload workload = CreateWorkload(resolution, content);
+
+        if (options.verify && VerifyKernels(options, workload, decoder) + VerifyScanKernels(options, workload) > 0)
+          is_valid = false;
+        if (!RunBenchmarks(options, workload, decoder)) is_valid = false;
+      }
+    }
+  } catch (char const *exception) {
+    std::cerr << "Error: " << exception << "\n";
+    return -1;
+  }
+
+  if (!has_workload) {
+    std::cerr << "Error: Invalid resolution or content given.\n";
+    return -1;
+  }
+
+  return is_valid ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+
+#include "synthetic_frame.h"
+
+namespace pixloc {
+namespace bench {
+
+// Constructor
+SyntheticFrame::SyntheticFrame(unsigned short width, unsigned short height, Content content, unsigned int seed) {
+  const unsigned int probe = 1;
+
+  pixels.resize(static_cast<unsigned long>(width)*height);
+
+  frame.data = reinterpret_cast<const unsigned char *>(pixels.data());
+  frame.width = width;
+  frame.height = height;
+  frame.stride = static_cast<unsigned int>(width)*sizeof(unsigned int);
+  frame.bits_per_pixel = 32;
+  frame.is_lsb_first = *reinterpret_cast<const unsigned char *>(&probe)==1;
+
+  std::mt19937 random(seed);
+
+  switch (content) {
+    case kFlatUi:GenerateFlatUi(random);
+      break;
+    case kNoisyPhoto:GenerateNoisyPhoto(random);
+      break;
+    case kRepetitiveGrid:GenerateRepetitiveGrid();
+      break;
+  }
+}
+
+void SyntheticFrame::PaintBitmask(const Bitmask &bitmask, unsigned short x, unsigned short y, unsigned int rgb_set) {
+  for (unsigned short bitmask_y = 0; bitmask_y < bitmask.GetHeight(); ++bitmask_y) {
+    for (unsigned short bitmask_x = 0; bitmask_x < bitmask.GetWidth(); ++bitmask_x) {
+      SetPixel(x + bitmask_x, y + bitmask_y, bitmask.Get(bitmask_x, bitmask_y) ? rgb_set : kColorOther);
+    }
+  }
+}
+
+std::vector<unsigned int> SyntheticFrame::CopyRectangle(unsigned short x, unsigned short y,
+                                                        unsigned short width, unsigned short height) const {
+  std::vector<unsigned int> rectangle;
+  rectangle.reserve(static_cast<unsigned long>(width)*height);
+
+  for (unsigned short offset_y = 0; offset_y < height; ++offset_y) {
+    const unsigned int *row = &pixels[static_cast<unsigned long>(y + offset_y)*frame.width + x];
+    rectangle.insert(rectangle.end(), row, row + width);
+  }
+
+  return rectangle;
+}
+
+const char *SyntheticFrame::GetContentName(Content content) {
+  switch (content) {
+    case kFlatUi:return "flat";
+    case kNoisyPhoto:return "noisy";
+    default:return "grid";
+  }
+}
+
+std::string SyntheticFrame::GenerateBitmask(unsigned short width, unsigned short height, std::mt19937 &random) {
+  std::string bitmask;
+
+  for (unsigned short y = 0; y < height; ++y) {
+    if (y > 0) bitmask += Bitmask::kRowSeparator;
+
+    for (unsigned short x = 0; x < width; ++x) {
+      bitmask += random() & 1 ? Bitmask::kCharSet : Bitmask::kCharUnset;
+    }
+  }
+
+  return bitmask;
+}
+
+void SyntheticFrame::FillRectangle(unsigned short x, unsigned short y, unsigned short width, unsigned short height,
+                                   unsigned int rgb) {
+  unsigned short last_x = std::min<unsigned short>(x + width, frame.width);
+  unsigned short last_y = std::min<unsigned short>(y + height, frame.height);
+
+  for (unsigned short offset_y = y; offset_y < last_y; ++offset_y) {
+    std::fill(&pixels[static_cast<unsigned long>(offset_y)*frame.width + x],
+              &pixels[static_cast<unsigned long>(offset_y)*frame.width + last_x],
+              rgb);
+  }
+}
+
+// Window-like content: large homochromatic areas, the worst case for homochromatic run checks
+void SyntheticFrame::GenerateFlatUi(std::mt19937 &random) {
+  std::fill(pixels.begin(), pixels.end(), 0xf0f0f0);
+
+  // Title bar and buttons in the color to find
+  FillRectangle(0, 0, frame.width, 24, kColorFind);
+
+  unsigned long amount_buttons = static_cast<unsigned long>(frame.width)*frame.height/20000;
+  for (unsigned long index = 0; index < amount_buttons; ++index) {
+    FillRectangle(static_cast<unsigned short>(random()%frame.width),
+                  static_cast<unsigned short>(random()%frame.height),
+                  static_cast<unsigned short>(40 + random()%120),
+                  static_cast<unsigned short>(16 + random()%16),
+                  kColorFind);
+  }
+
+  // Text specks: ~1% of pixels
+  unsigned long amount_specks = pixels.size()/100;
+  for (unsigned long index = 0; index < amount_specks; ++index) {
+    pixels[random()%pixels.size()] = 0x303030;
+  }
+}
+
+void SyntheticFrame::GenerateNoisyPhoto(std::mt19937 &random) {
+  for (auto &pixel : pixels) {
+    unsigned int value = random();
+    pixel = (value & 3)==0 ? kColorFind : (value >> 8) & 0xffffff;
+  }
+}
+
+void SyntheticFrame::GenerateRepetitiveGrid() {
+  const unsigned short kCellSize = 24;
+
+  for (unsigned short y = 0; y < frame.height; ++y) {
+    for (unsigned short x = 0; x < frame.width; ++x) {
+      SetPixel(x, y, x%kCellSize==0 || y%kCellSize==0
+                     ? kColorFind
+                     : (((x/kCellSize) + (y/kCellSize)) & 1 ? 0xe0e0e0 : 0x404040));
+    }
+  }
+}
+
+} // namespace bench
+} // namespace pixloc
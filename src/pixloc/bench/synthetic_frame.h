@@ -0,0 +1,96 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_SYNTHETIC_FRAME
+#define CLASS_PIXLOC_SYNTHETIC_FRAME
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pixloc/models/bitmask.h"
+#include "pixloc/models/frame.h"
+
+namespace pixloc {
+namespace bench {
+
+// Generated 32 bpp frame of packed 0x00RRGGBB pixels in host byte order, for benchmarking independently of X
+class SyntheticFrame {
+
+ public:
+  enum Content {
+    kFlatUi,          // Light background w/ buttons and sparse dark text specks
+    kNoisyPhoto,      // Random colors, every 4th pixel in the color to find
+    kRepetitiveGrid   // Checkered cells w/ 1 pixel lines in the color to find
+  };
+
+  static const unsigned int kColorFind = 0xbcbcbc;
+  static const unsigned int kColorOther = 0x202020;
+
+  // Constructor: generate content, reproducible for the same seed
+  SyntheticFrame(unsigned short width, unsigned short height, Content content, unsigned int seed = 1);
+
+  inline const Frame &GetFrame() const { return frame; }
+
+  inline unsigned int GetPixel(unsigned short x, unsigned short y) const {
+    return pixels[static_cast<unsigned long>(y)*frame.width + x];
+  }
+
+  inline void SetPixel(unsigned short x, unsigned short y, unsigned int rgb) {
+    pixels[static_cast<unsigned long>(y)*frame.width + x] = rgb;
+  }
+
+  // Paint set pixels of given bitmask in the color to find, unset ones in another color, at given top-left corner
+  void PaintBitmask(const Bitmask &bitmask, unsigned short x, unsigned short y, unsigned int rgb_set);
+
+  // Copy given rectangle of pixels, row by row
+  std::vector<unsigned int> CopyRectangle(unsigned short x, unsigned short y,
+                                          unsigned short width, unsigned short height) const;
+
+  static const char *GetContentName(Content content);
+
+  // Generate random bitmask pattern of given size, e.g. "*_*,__*"
+  static std::string GenerateBitmask(unsigned short width, unsigned short height, std::mt19937 &random);
+
+ private:
+  std::vector<unsigned int> pixels;
+  Frame frame;
+
+  void FillRectangle(unsigned short x, unsigned short y, unsigned short width, unsigned short height,
+                     unsigned int rgb);
+
+  void GenerateFlatUi(std::mt19937 &random);
+  void GenerateNoisyPhoto(std::mt19937 &random);
+  void GenerateRepetitiveGrid();
+};
+
+} // namespace bench
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_SYNTHETIC_FRAME
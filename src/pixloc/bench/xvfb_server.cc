@@ -0,0 +1,92 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "xvfb_server.h"
+
+namespace pixloc {
+namespace bench {
+
+// Constructor
+XvfbServer::XvfbServer(const std::string &executable, const std::string &geometry) {
+  int display_pipe[2];
+  if (pipe(display_pipe)==-1) throw "Failed to create pipe to Xvfb.";
+
+  this->pid = fork();
+  if (this->pid==-1) throw "Failed to start Xvfb.";
+
+  if (this->pid==0) {
+    // Child: Xvfb picks a free display number and writes it into the pipe once it accepts connections
+    close(display_pipe[0]);
+
+    int null_device = open("/dev/null", O_WRONLY);
+    if (null_device!=-1) dup2(null_device, STDERR_FILENO);
+
+    std::string display_fd = std::to_string(display_pipe[1]);
+    execlp(executable.c_str(), executable.c_str(),
+           "-displayfd", display_fd.c_str(),
+           "-screen", "0", geometry.c_str(),
+           "-nolisten", "tcp", "-noreset",
+           static_cast<char *>(nullptr));
+    _exit(127);
+  }
+
+  close(display_pipe[1]);
+
+  std::string display_number;
+  struct pollfd poll_descriptor{display_pipe[0], POLLIN, 0};
+  char character;
+  while (poll(&poll_descriptor, 1, kStartTimeoutMs) > 0 && read(display_pipe[0], &character, 1)==1
+      && character!='\n') {
+    display_number += character;
+  }
+  close(display_pipe[0]);
+
+  if (display_number.empty()) {
+    kill(this->pid, SIGTERM);
+    waitpid(this->pid, nullptr, 0);
+    throw "Xvfb did not start, is it installed?";
+  }
+
+  this->display_name = ":" + display_number;
+}
+
+// Destructor
+XvfbServer::~XvfbServer() {
+  kill(this->pid, SIGTERM);
+  waitpid(this->pid, nullptr, 0);
+}
+
+} // namespace bench
+} // namespace pixloc
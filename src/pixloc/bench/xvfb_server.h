@@ -0,0 +1,63 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_XVFB_SERVER
+#define CLASS_PIXLOC_XVFB_SERVER
+
+#include <sys/types.h>
+#include <string>
+
+namespace pixloc {
+namespace bench {
+
+// Headless X server, running as child process for the lifetime of this object
+class XvfbServer {
+
+ public:
+  // Constructor: start Xvfb on a free display number w/ given screen geometry, e.g. 1920x1080x24.
+  // Throws if it cannot be started or does not report its display in time
+  XvfbServer(const std::string &executable, const std::string &geometry);
+
+  // Display name for XOpenDisplay() and $DISPLAY, e.g. ":1"
+  inline const std::string &GetDisplayName() const { return display_name; }
+
+  // Destructor: terminate server
+  ~XvfbServer();
+
+ private:
+  static const int kStartTimeoutMs = 10000;
+
+  pid_t pid;
+  std::string display_name;
+};
+
+} // namespace bench
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_XVFB_SERVER
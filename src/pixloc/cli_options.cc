@@ -29,16 +29,263 @@
 
 #include <regex>
 
+#include "config.h"
 #include "cli_options.h"
+#include "external/clara.hpp"
 #include "pixloc/helper/strings.h"
 
 namespace pixloc {
 namespace clioptions {
 
+static clara::Parser CreateParser(Arguments &arguments) {
+  using namespace clara;
+
+  return Opt(arguments.mode, "mode")["-m"]["--mode"]("see usage examples for available modes").required() |
+      Opt(arguments.from, "from")["-f"]["--from"]("starting coordinate").required() |
+      Opt(arguments.range, "range")["-r"]["--range"]("amount of pixels to be scanned").required() |
+      Opt(arguments.color,
+          "color")["-c"]["--color"]("rgb color value to find, or ;-separated list of colors w/ optional /tolerance").optional() |
+      Opt(arguments.amount, "amount")["-a"]["--amount"]("amount of consecutive pixels of given color to find").optional() |
+      Opt(arguments.bitmask,
+          "bitmask")["-b"]["--bitmask"]("pixel mask to find (* = given color, _ = other colors)").optional() |
+      Opt(arguments.image, "image")["-i"]["--image"]("PPM/PAM image to find, in find image mode").optional() |
+      Opt(arguments.library,
+          "library")["-l"]["--library"]("file of named bitmask templates to find, in find library mode").optional() |
+      Opt(arguments.tolerance,
+          "tolerance")["-t"]["--tolerance"]("optional: color tolerance, per channel: n or r,g,b, or max. distance").optional() |
+      Opt(arguments.distance,
+          "distance")["--distance"]("optional: color distance: channel (default), weighted or cie76").optional() |
+      Opt(arguments.step,
+          "step")["-s"]["--step"]("optional: interval step size of horizontal/vertical find mode").optional() |
+      Opt(arguments.wait,
+          "milliseconds")["-w"]["--wait"]("optional: in find modes, wait up to given time for a match").optional() |
+      Opt(arguments.threads,
+          "threads")["--threads"]("optional: amount of threads finding bitmasks / tracing main color, default: amount of cores").optional() |
+      Opt(arguments.top,
+          "amount")["--top"]("optional: in trace main color mode, output amount of most common colors w/ their pixels").optional() |
+      Opt(arguments.max_results,
+          "amount")["--max-results"]("optional: in find all bitmask mode, max. amount of occurrences to output").optional() |
+      Opt(arguments.strips,
+          "rows")["--strips"]("optional: in find bitmask mode, capture in strips of given rows, scanned while the next are transferred").optional() |
+      Opt(arguments.max_age,
+          "milliseconds")["--max-age"]("optional: reuse screen captured by an earlier pixloc call up to given time ago").optional() |
+      Opt(arguments.format,
+          "format")["--format"]("optional: in trace horizontal, vertical and bitmask modes: text (default), jsonl or raw").optional() |
+      Opt(arguments.compare,
+          "fingerprint")["--compare"]("optional: in fingerprint mode, exit w/ status 1 if the fingerprint differs from given one").optional() |
+      Opt(arguments.perceptual)["--perceptual"]("optional: in fingerprint mode, compute coarse perceptual fingerprint").optional() |
+      Opt(arguments.input,
+          "input")["--input"]("optional: x11 (default), x11:xshm, x11:xgetimage, PPM/PGM/PAM file or raw:<format>:<w>x<h>[:<stride>]:<file>").optional() |
+      Opt(arguments.serve, "socket")["--serve"]("optional: run as daemon, serving queries on given socket").optional() |
+      Opt(arguments.client, "socket")["--client"]("optional: send query to daemon listening on given socket").optional() |
+      Opt(arguments.batch,
+          "file")["--batch"]("optional: run query lines of given file (- = stdin) on one capture").optional() |
+      Opt(arguments.matched_color)["--matched-color"]("optional: in find modes, output index of the matched color").optional() |
+      Opt(arguments.stats)["--stats"]("optional: output timings of phases and counters to stderr, as JSON").optional() |
+      Help(arguments.show_help);
+}
+
+bool ParseArguments(int argc, const char *const *argv, Arguments &arguments, std::string &error_message) {
+  auto clara_result = CreateParser(arguments).parse(clara::Args(argc, argv));
+  if (!clara_result) {
+    error_message = clara_result.errorMessage();
+
+    return false;
+  }
+
+  return true;
+}
+
+bool ParseArgumentsLine(const std::string &line, Arguments &arguments, std::string &error_message) {
+  std::vector<std::string> tokens = helper::strings::SplitArguments(line);
+  std::vector<const char *> argv{"pixloc"};
+  for (const auto &token : tokens) argv.push_back(token.c_str());
+
+  return ParseArguments(static_cast<int>(argv.size()), argv.data(), arguments, error_message);
+}
+
+void WriteHelp(std::ostream &stream) {
+  Arguments arguments;
+
+  stream << "pixloc version " <<
+         Pixloc_VERSION_MAJOR << "." << Pixloc_VERSION_MINOR << "\n"
+             "Copyright (c) 2019 Kay Stenschke\n\n";
+  CreateParser(arguments).writeToStream(stream);
+  stream << kUsageExamples;
+}
+
+std::string FormatArguments(const Arguments &arguments) {
+  std::string line;
+  const std::pair<const char *, const std::string *> options[] = {
+      {"--mode", &arguments.mode},
+      {"--from", &arguments.from},
+      {"--range", &arguments.range},
+      {"--color", &arguments.color},
+      {"--amount", &arguments.amount},
+      {"--bitmask", &arguments.bitmask},
+      {"--image", &arguments.image},
+      {"--library", &arguments.library},
+      {"--tolerance", &arguments.tolerance},
+      {"--distance", &arguments.distance},
+      {"--step", &arguments.step},
+      {"--wait", &arguments.wait},
+      {"--threads", &arguments.threads},
+      {"--top", &arguments.top},
+      {"--max-results", &arguments.max_results},
+      {"--strips", &arguments.strips},
+      {"--max-age", &arguments.max_age},
+      {"--format", &arguments.format},
+      {"--compare", &arguments.compare}
+  };
+
+  for (const auto &option : options) {
+    if (option.second->empty()) continue;
+
+    if (!line.empty()) line += " ";
+    line += std::string(option.first) + " " + helper::strings::QuoteArgument(*option.second);
+  }
+
+  if (arguments.matched_color) line += line.empty() ? "--matched-color" : " --matched-color";
+  if (arguments.perceptual) line += line.empty() ? "--perceptual" : " --perceptual";
+
+  return line;
+}
+
+void ResolveQuery(const Arguments &arguments, const FrameSource &source, Query &query) {
+  query.mode_id = GetModeIdFromName(arguments.mode);
+  query.is_trace_mode = IsTraceMode(query.mode_id);
+
+  query.use_mouse_for_from = strcmp(arguments.from.c_str(), "mouse")==0;
+  if (query.use_mouse_for_from || query.mode_id==kModeIdTraceMouse) {
+    source.GetMousePosition(query.from_x, query.from_y);
+    if (query.mode_id==kModeIdTraceMouse) return;
+  }
+
+  if (!query.use_mouse_for_from && !helper::strings::ResolveNumericTupel(arguments.from, query.from_x, query.from_y))
+    throw "Valid from coordinate is required.";
+  ResolveScanningRange(query.mode_id, arguments.range, query.range_x, query.range_y);
+  ValidateScanningRectangle(query.from_x, query.from_y, query.range_x, query.range_y, source);
+
+  if (ModeRequiresAmountPx(query.mode_id) &&
+      (query.amount_px = static_cast<unsigned short>(helper::strings::ToInt(arguments.amount, 0)))==0)
+    throw "Valid amount of pixels to find is required.";
+
+  query.is_bitmask_mode = IsBitmaskMode(query.mode_id);
+  if (ModeRequiresBitmask(query.mode_id)) {
+    ValidateBitmask(arguments.bitmask, query.range_x, query.range_y);
+    query.bitmask = arguments.bitmask;
+  }
+
+  if (query.mode_id==kModeIdFindImage) {
+    if (arguments.image.empty()) throw "Image to find is required.";
+    query.image = std::make_shared<const Image>(arguments.image);
+    ValidateImage(*query.image, query.range_x, query.range_y);
+  }
+
+  if (query.mode_id==kModeIdFindLibrary) {
+    if (arguments.library.empty()) throw "Template library is required.";
+    query.library = std::make_shared<const TemplateLibrary>(arguments.library);
+  }
+
+  ResolveColorTolerance(arguments.tolerance, arguments.distance, query.color_tolerance);
+  if (query.mode_id==kModeIdFindImage && query.color_tolerance.distance!=ColorTolerance::kDistanceChannel)
+    throw "Color distances are not available in find image mode.";
+
+  if (ModeRequiresColor(query.mode_id))
+    ResolveColors(arguments.color, arguments.distance, query.color_tolerance, query.colors);
+
+  if (arguments.matched_color) {
+    if (!IsFindMode(query.mode_id) || !ModeRequiresColor(query.mode_id))
+      throw "Matched colors are only available in find modes of given colors.";
+    query.report_matched_color = true;
+  }
+
+  if (!arguments.step.empty()) {
+    if (!helper::strings::IsNumeric(arguments.step)) throw "Invalid step size given.";
+    query.step_size = static_cast<unsigned short>(helper::strings::ToInt(arguments.step, 1));
+    if (query.step_size < 1) query.step_size = 1;
+    if (query.step_size > ((query.range_x > 1) ? query.range_x : query.range_y)) throw "Step size exceeds range.";
+  }
+  if (!arguments.wait.empty()) {
+    if (!helper::strings::IsNumeric(arguments.wait) || arguments.wait.length() > 9)
+      throw "Invalid wait duration given.";
+    if (!IsFindMode(query.mode_id)) throw "Waiting is only available in find modes.";
+    query.wait_ms = helper::strings::ToInt(arguments.wait, 0);
+  }
+  if (!arguments.threads.empty()) {
+    if (!helper::strings::IsNumeric(arguments.threads) || arguments.threads.length() > 5 ||
+        helper::strings::ToInt(arguments.threads, 0) < 1 || helper::strings::ToInt(arguments.threads, 0) > 0xffff)
+      throw "Invalid amount of threads given.";
+    query.amount_threads = static_cast<unsigned short>(helper::strings::ToInt(arguments.threads, 1));
+  }
+  if (!arguments.top.empty()) {
+    if (!helper::strings::IsNumeric(arguments.top) || arguments.top.length() > 5 ||
+        helper::strings::ToInt(arguments.top, 0) < 1 || helper::strings::ToInt(arguments.top, 0) > 0xffff)
+      throw "Invalid amount of top colors given.";
+    if (query.mode_id!=kModeIdTraceMainColor) throw "Top colors are only available in trace main color mode.";
+    query.amount_top = static_cast<unsigned short>(helper::strings::ToInt(arguments.top, 1));
+  }
+  if (!arguments.max_results.empty()) {
+    if (!helper::strings::IsNumeric(arguments.max_results) || arguments.max_results.length() > 9 ||
+        helper::strings::ToInt(arguments.max_results, 0) < 1)
+      throw "Invalid max. amount of results given.";
+    if (query.mode_id!=kModeIdFindAllBitmask)
+      throw "Max. amount of results is only available in find all bitmask mode.";
+    query.max_results = static_cast<unsigned int>(helper::strings::ToInt(arguments.max_results, 0));
+  }
+  if (!arguments.strips.empty()) {
+    if (!helper::strings::IsNumeric(arguments.strips) || arguments.strips.length() > 5 ||
+        helper::strings::ToInt(arguments.strips, 0) < 1 || helper::strings::ToInt(arguments.strips, 0) > 0xffff)
+      throw "Invalid strip height given.";
+    if (query.mode_id!=kModeIdFindBitmask) throw "Strip capture is only available in find bitmask mode.";
+    query.strip_height = static_cast<unsigned short>(helper::strings::ToInt(arguments.strips, 1));
+  }
+  if (!arguments.max_age.empty()) {
+    if (!helper::strings::IsNumeric(arguments.max_age) || arguments.max_age.length() > 9 ||
+        helper::strings::ToInt(arguments.max_age, 0) < 1)
+      throw "Invalid max. age given.";
+    if (!source.GetDisplay()) throw "Max. age is only available when scanning the live screen.";
+    if (query.strip_height > 0) throw "Max. age is not available w/ strip capture.";
+    query.max_age_ms = helper::strings::ToInt(arguments.max_age, 0);
+  }
+  if (!arguments.format.empty()) {
+    if (arguments.format=="text") query.output_format = OutputBuffer::kFormatText;
+    else if (arguments.format=="jsonl") query.output_format = OutputBuffer::kFormatJsonl;
+    else if (arguments.format=="raw") query.output_format = OutputBuffer::kFormatRaw;
+    else throw "Invalid output format given.";
+
+    if (query.mode_id!=kModeIdTraceHorizontal && query.mode_id!=kModeIdTraceVertical &&
+        query.mode_id!=kModeIdTraceBitmask)
+      throw "Output formats are only available in trace horizontal, vertical and bitmask modes.";
+  }
+  if (arguments.perceptual) {
+    if (query.mode_id!=kModeIdFingerprint) throw "Perceptual fingerprints are only available in fingerprint mode.";
+    query.fingerprint_kind = Fingerprint::kKindPerceptual;
+  }
+  if (!arguments.compare.empty()) {
+    if (!Fingerprint::Parse(arguments.compare, query.compared_fingerprint))
+      throw "Invalid fingerprint to compare given, 16 hex digits are required.";
+    if (query.mode_id!=kModeIdFingerprint) throw "Comparing is only available in fingerprint mode.";
+    query.is_fingerprint_compared = true;
+  }
+  if (query.mode_id==kModeIdFingerprint && !arguments.tolerance.empty()) {
+    // Compared perceptual fingerprints may differ in up to the tolerance's amount of bits
+    if (!query.is_fingerprint_compared || query.fingerprint_kind!=Fingerprint::kKindPerceptual)
+      throw "Tolerance is only available when comparing perceptual fingerprints.";
+    if (!helper::strings::IsNumeric(arguments.tolerance) || arguments.tolerance.length() > 2 ||
+        helper::strings::ToInt(arguments.tolerance, 0) > 64)
+      throw "Invalid tolerance of fingerprints given, max. amount of differing bits (0..64) is required.";
+    query.max_differing_bits = static_cast<unsigned short>(helper::strings::ToInt(arguments.tolerance, 0));
+  }
+}
+
 unsigned short GetModeIdFromName(const std::string &mode) {
   if (mode.empty()) throw "No mode given.";
 
   if (strcmp(mode.c_str(), kModeNameFindBitmask)==0) return kModeIdFindBitmask;
+  if (strcmp(mode.c_str(), kModeNameFindAllBitmask)==0) return kModeIdFindAllBitmask;
+  if (strcmp(mode.c_str(), kModeNameFindImage)==0) return kModeIdFindImage;
+  if (strcmp(mode.c_str(), kModeNameFindLibrary)==0) return kModeIdFindLibrary;
   if (strcmp(mode.c_str(), kModeNameFindConsecutiveHorizontal)==0) return kModeIdFindConsecutiveHorizontal;
   if (strcmp(mode.c_str(), kModeNameFindConsecutiveVertical)==0) return kModeIdFindConsecutiveVertical;
   if (strcmp(mode.c_str(), kModeNameTraceBitmask)==0) return kModeIdTraceBitmask;
@@ -46,6 +293,7 @@ unsigned short GetModeIdFromName(const std::string &mode) {
   if (strcmp(mode.c_str(), kModeNameTraceMainColor)==0) return kModeIdTraceMainColor;
   if (strcmp(mode.c_str(), kModeNameTraceMouse)==0) return kModeIdTraceMouse;
   if (strcmp(mode.c_str(), kModeNameTraceVertical)==0) return kModeIdTraceVertical;
+  if (strcmp(mode.c_str(), kModeNameFingerprint)==0) return kModeIdFingerprint;
 
   throw "Valid mode is required.";
 }
@@ -54,7 +302,11 @@ bool IsTupelRangeMode(int mode_id) {
   return
       mode_id==kModeIdTraceBitmask ||
       mode_id==kModeIdFindBitmask ||
-      mode_id==kModeIdTraceMainColor;
+      mode_id==kModeIdFindAllBitmask ||
+      mode_id==kModeIdFindImage ||
+      mode_id==kModeIdFindLibrary ||
+      mode_id==kModeIdTraceMainColor ||
+      mode_id==kModeIdFingerprint;
 }
 
 bool IsHorizontalMode(int mode_id) {
@@ -69,8 +321,17 @@ bool IsTraceMode(int mode_id) {
          mode_id==kModeIdTraceMouse;
 }
 
+bool IsFindMode(int mode_id) {
+  return mode_id==kModeIdFindBitmask ||
+         mode_id==kModeIdFindAllBitmask ||
+         mode_id==kModeIdFindImage ||
+         mode_id==kModeIdFindLibrary ||
+         mode_id==kModeIdFindConsecutiveHorizontal ||
+         mode_id==kModeIdFindConsecutiveVertical;
+}
+
 bool IsBitmaskMode(int mode_id) {
-  return mode_id==kModeIdTraceBitmask || mode_id==kModeIdFindBitmask;
+  return mode_id==kModeIdTraceBitmask || mode_id==kModeIdFindBitmask || mode_id==kModeIdFindAllBitmask;
 }
 
 bool ModeRequiresAmountPx(int mode_id) {
@@ -78,11 +339,12 @@ bool ModeRequiresAmountPx(int mode_id) {
 }
 
 bool ModeRequiresBitmask(int mode_id) {
-  return mode_id==kModeIdFindBitmask;
+  return mode_id==kModeIdFindBitmask || mode_id==kModeIdFindAllBitmask;
 }
 
 bool ModeRequiresColor(int mode_id) {
   return mode_id==kModeIdFindBitmask ||
+         mode_id==kModeIdFindAllBitmask ||
          mode_id==kModeIdFindConsecutiveHorizontal ||
          mode_id==kModeIdFindConsecutiveVertical ||
          mode_id==kModeIdTraceBitmask;
@@ -100,9 +362,19 @@ bool IsValidColor(const std::string &color) {
 
 void ValidateBitmask(const std::string &bitmask_px, int range_width, int range_height) {
   if (bitmask_px.empty()) throw "Bitmask is empty";
-  if (bitmask_px.length() > range_width * range_height + range_height)
+  if (bitmask_px.length() > static_cast<std::string::size_type>(range_width + 1)*range_height)
     throw "Bitmask dimension must be smaller than scanning range.";
   if (!std::regex_match(bitmask_px, std::regex("[\\*_,]+"))) throw "Valid bitmask to find is required.";
+
+  std::vector<std::string> rows = helper::strings::Explode(bitmask_px, ',');
+  for (const auto &row : rows) {
+    if (row.empty() || row.length()!=rows[0].length()) throw "All rows of bitmask must be of same width.";
+  }
+}
+
+void ValidateImage(const Image &image, int range_width, int range_height) {
+  if (image.GetWidth() > range_width || image.GetHeight() > range_height)
+    throw "Image dimension must be smaller than scanning range.";
 }
 
 void ResolveScanningRange(int mode_id, const std::string &range, int &range_x, int &range_y) {
@@ -131,10 +403,9 @@ void ResolveScanningRange(int mode_id, const std::string &range, int &range_x, i
   if (range_y == -1) throw "Valid scanning range value is required.";
 }
 
-void ValidateScanningRectangle(int from_x, int from_y, int range_x, int range_y, Display *display) {
-  Screen*  screen = DefaultScreenOfDisplay(display);
-  if (from_x + range_x > screen->width ||
-      from_y + range_y > screen->height) throw "Given scanning rectangle exceeds available screen size";
+void ValidateScanningRectangle(int from_x, int from_y, int range_x, int range_y, const FrameSource &source) {
+  if (from_x + range_x > source.GetWidth() ||
+      from_y + range_y > source.GetHeight()) throw "Given scanning rectangle exceeds available screen size";
 }
 
 void ResolveRgbColor(const std::string &color, int &red, int &green, int &blue) {
@@ -148,5 +419,74 @@ void ResolveRgbColor(const std::string &color, int &red, int &green, int &blue)
 
   if (red == -1 || green == -1 || blue == -1) throw "Valid color is required.";
 }
+
+// Resolve ;-separated list of colors, each w/ optional /tolerance, e.g. "188,188,188;210,210,210/8".
+// Colors w/o own tolerance use given tolerance
+void ResolveColors(const std::string &color_list,
+                   const std::string &distance,
+                   const ColorTolerance &tolerance,
+                   std::vector<MatchColor> &colors) {
+  if (color_list.empty()) throw "Valid color is required.";
+
+  for (const auto &entry : helper::strings::Explode(color_list, ';')) {
+    std::vector<std::string> parts = helper::strings::Explode(entry, '/');
+    if (parts.empty() || parts.size() > 2) throw "Valid color is required.";
+    if (parts.size()==1 && entry[entry.length() - 1]=='/') throw "Invalid color tolerance value given.";
+
+    int red, green, blue;
+    ResolveRgbColor(parts[0], red, green, blue);
+    if (red > ColorMatcher::kMaxChannelValue || green > ColorMatcher::kMaxChannelValue ||
+        blue > ColorMatcher::kMaxChannelValue)
+      throw "Valid color is required.";
+
+    MatchColor color(static_cast<unsigned short>(red), static_cast<unsigned short>(green),
+                     static_cast<unsigned short>(blue), tolerance);
+    if (parts.size()==2) {
+      if (parts[1].empty()) throw "Invalid color tolerance value given.";
+      ResolveColorTolerance(parts[1], distance, color.tolerance);
+    }
+
+    colors.push_back(color);
+  }
+}
+
+// Resolve tolerance: n or r,g,b per channel, or a single max. distance of weighted RGB / CIE76 distance
+void ResolveColorTolerance(const std::string &tolerance, const std::string &distance, ColorTolerance &color_tolerance) {
+  if (distance.empty() || distance=="channel") {
+    color_tolerance.distance = ColorTolerance::kDistanceChannel;
+  } else if (distance=="weighted") {
+    color_tolerance.distance = ColorTolerance::kDistanceWeighted;
+  } else if (distance=="cie76") {
+    color_tolerance.distance = ColorTolerance::kDistanceCie76;
+  } else {
+    throw "Invalid color distance given.";
+  }
+
+  if (tolerance.empty()) return;
+
+  std::vector<std::string> values = helper::strings::Explode(tolerance, ',');
+  if (values.size()!=1 && values.size()!=3) throw "Invalid color tolerance value given.";
+
+  // Max. per channel, resp. max. distance: beyond every distance between two colors of weighted RGB and CIE76
+  int max_value = color_tolerance.distance==ColorTolerance::kDistanceChannel
+                  ? ColorMatcher::kMaxChannelValue
+                  : ColorTolerance::kMaxDistance;
+  for (const auto &value : values) {
+    if (!helper::strings::IsNumeric(value) || value.length() > 3 || helper::strings::ToInt(value, 0) > max_value)
+      throw "Invalid color tolerance value given.";
+  }
+
+  if (color_tolerance.distance!=ColorTolerance::kDistanceChannel) {
+    if (values.size()!=1) throw "Per-channel color tolerances are only available w/ channel distance.";
+
+    color_tolerance.max_distance = static_cast<unsigned short>(helper::strings::ToInt(values[0], 0));
+
+    return;
+  }
+
+  color_tolerance.red = static_cast<unsigned short>(helper::strings::ToInt(values[0], 0));
+  color_tolerance.green = static_cast<unsigned short>(helper::strings::ToInt(values[values.size()==3 ? 1 : 0], 0));
+  color_tolerance.blue = static_cast<unsigned short>(helper::strings::ToInt(values[values.size()==3 ? 2 : 0], 0));
+}
 } // namespace cli
 } // namespace pixloc
@@ -30,11 +30,19 @@
 #ifndef CLASS_PIXLOC_CLI
 #define CLASS_PIXLOC_CLI
 
-#include <X11/Xlib.h>
-#include <X11/Xutil.h>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pixloc/models/color_matcher.h"
+#include "pixloc/models/fingerprint.h"
+#include "pixloc/models/frame_source.h"
+#include "pixloc/models/image.h"
+#include "pixloc/models/output_buffer.h"
+#include "pixloc/models/template_library.h"
 
 namespace pixloc {
 namespace clioptions {
@@ -44,14 +52,38 @@ static const char *const kUsageExamples = "\nusage examples:"
     "\npixloc --mode \"trace vertical\" --from 0,60 --range 100"
     "\npixloc --mode \"trace bitmask\" --from 0,60 --range 64,64 --color 188,188,188"
     "\npixloc --mode \"trace main color\" --from 0,60 --range 64,64"
+    "\npixloc --mode \"trace main color\" --from 0,60 --range 64,64 --top 3"
     "\npixloc --mode \"trace mouse\""
     "\npixloc --mode \"find horizontal\" --from 0,60 --range 100 --color 188,188,188 --amount 8"
     "\npixloc --mode \"find horizontal\" --from mouse --range 100 --color 188,188,188 --amount 8"
     "\npixloc --mode \"find vertical\" --from 0,60 --range 100 --color 188,188,188 --amount 8"
     "\npixloc --mode \"find bitmask\" --from 0,60 --range 128,32 --color 188,188,188 --bitmask *__,**_,***,**_,*__"
+    "\npixloc --mode \"find bitmask\" --from 0,60 --range 128,32 --color 188,188,188 --bitmask *__,**_,*__ --wait 5000"
+    "\npixloc --mode \"find bitmask\" --from 1,1 --range 1920,1080 --color 188,188,188 --bitmask *__,**_,*__ --strips 64"
+    "\npixloc --mode \"trace main color\" --from 10,10 --range 16,16 --max-age 300"
+    "\npixloc --mode \"trace bitmask\" --from 1,1 --range 1919,1079 --color 188,188,188 --format raw"
+    "\npixloc --mode fingerprint --from 0,60 --range 1000,800"
+    "\npixloc --mode fingerprint --from 0,60 --range 1000,800 --compare 9f2c61e04b7a3d58"
+    "\npixloc --mode fingerprint --from 0,60 --range 1000,800 --perceptual --compare 00ff00ff3c3c0000 --tolerance 2"
+    "\npixloc --mode \"find all bitmask\" --from 0,60 --range 128,32 --color 188,188,188 --bitmask *__,**_,*__ --max-results 10"
+    "\npixloc --mode \"find bitmask\" --from 0,60 --range 128,32 --color 188,188,188 --bitmask *__,**_,*__ --tolerance 8,4,16"
+    "\npixloc --mode \"find bitmask\" --from 0,60 --range 128,32 --color 188,188,188 --bitmask *__,**_,*__ --distance cie76 --tolerance 5"
+    "\npixloc --mode \"find bitmask\" --from 0,60 --range 128,32 --color \"188,188,188;210,210,210/8\" --bitmask *__,**_,*__ --matched-color"
+    "\npixloc --mode \"find image\" --from 0,60 --range 640,480 --image icon.ppm --tolerance 16"
+    "\npixloc --mode \"find library\" --from 0,60 --range 640,480 --library templates.txt"
+    "\npixloc --mode \"trace main color\" --from 0,60 --range 64,64 --input screenshot.ppm"
+    "\npixloc --mode \"find bitmask\" --from 0,60 --range 128,32 --color 188,188,188 --bitmask *__,**_,*__"
+    " --input raw:bgra:1920x1080:framebuffer.raw"
+    "\npixloc --batch queries.txt"
+    "\npixloc --mode \"find bitmask\" --from 0,60 --range 64,64 --color 188,188,188 --bitmask *__,**_,*__ --stats"
+    "\npixloc --serve /tmp/pixloc.sock"
+    "\npixloc --client /tmp/pixloc.sock --mode \"trace main color\" --from 0,60 --range 64,64"
     "\n\nsee https://github.com/kstenschke/pixloc for more detailed information\n\n";
 
 static const char *const kModeNameFindBitmask = "find bitmask";
+static const char *const kModeNameFindAllBitmask = "find all bitmask";
+static const char *const kModeNameFindImage = "find image";
+static const char *const kModeNameFindLibrary = "find library";
 static const char *const kModeNameFindConsecutiveHorizontal = "find horizontal";
 static const char *const kModeNameFindConsecutiveVertical = "find vertical";
 static const char *const kModeNameTraceBitmask = "trace bitmask";
@@ -59,6 +91,7 @@ static const char *const kModeNameTraceHorizontal = "trace horizontal";
 static const char *const kModeNameTraceMainColor = "trace main color";
 static const char *const kModeNameTraceMouse = "trace mouse";
 static const char *const kModeNameTraceVertical = "trace vertical";
+static const char *const kModeNameFingerprint = "fingerprint";
 
 static const int kModeIdFindBitmask = 1;
 static const int kModeIdFindConsecutiveHorizontal = 2;
@@ -68,22 +101,121 @@ static const int kModeIdTraceHorizontal = 5;
 static const int kModeIdTraceMainColor = 6;
 static const int kModeIdTraceMouse = 7;
 static const int kModeIdTraceVertical = 8;
+static const int kModeIdFindAllBitmask = 9;
+static const int kModeIdFindImage = 10;
+static const int kModeIdFindLibrary = 11;
+static const int kModeIdFingerprint = 12;
+
+// Raw values of given command line options
+struct Arguments {
+  std::string mode;
+  std::string from;
+  std::string range;
+  std::string color;
+  std::string amount;
+  std::string bitmask;
+  std::string image;
+  std::string library;
+  std::string tolerance;
+  std::string distance;
+  std::string step;
+  std::string wait;
+  std::string threads;
+  std::string top;
+  std::string max_results;
+  std::string strips;
+  std::string max_age;
+  std::string format;
+  std::string compare;
+  std::string input;
+  std::string serve;
+  std::string client;
+  std::string batch;
+
+  bool matched_color = false;
+  bool perceptual = false;
+  bool stats = false;
+  bool show_help = false;
+};
+
+// Scanning query, resolved and validated from arguments
+struct Query {
+  unsigned short mode_id = 0;
+  unsigned short amount_px = 1;
+  ColorTolerance color_tolerance;
+  unsigned short step_size = 1;
+  // Milliseconds to wait for a match to appear, 0 = don't wait
+  long wait_ms = 0;
+  // Amount of threads searching bitmasks / tracing main color, 0 = hardware concurrency
+  unsigned short amount_threads = 0;
+  // Amount of most common colors to output w/ their amount of pixels, 0 = output only the main color
+  unsigned short amount_top = 0;
+  // Max. amount of bitmask occurrences to output, 0 = all
+  unsigned int max_results = 0;
+  // Rows per strip of pipelined capture, 0 = capture the scanning rectangle at once
+  unsigned short strip_height = 0;
+  // Max. age in milliseconds of a frame captured by an earlier process, to be scanned instead of capturing, 0 = capture
+  long max_age_ms = 0;
+  OutputBuffer::Format output_format = OutputBuffer::kFormatText;
+
+  // Fingerprint mode: coarse perceptual fingerprint instead of exact hash of all pixels
+  Fingerprint::Kind fingerprint_kind = Fingerprint::kKindExact;
+  // Fingerprint to compare the computed one with, and max. amount of bits they may differ in
+  bool is_fingerprint_compared = false;
+  uint64_t compared_fingerprint = 0;
+  unsigned short max_differing_bits = 0;
+
+  int from_x = -1, from_y = -1,
+      range_x = -1, range_y = -1;
+
+  // Sought colors, each w/ its own tolerance
+  std::vector<MatchColor> colors;
+
+  std::string bitmask;
+  // Template of find image mode, loaded once per query
+  std::shared_ptr<const Image> image;
+  // Templates of find library mode, loaded once per query
+  std::shared_ptr<const TemplateLibrary> library;
+
+  bool is_bitmask_mode = false;
+  bool is_trace_mode = false;
+  bool use_mouse_for_from = false;
+  // Output index of the matched sought color along w/ found coordinates
+  bool report_matched_color = false;
+};
+
+// Parse given argv into arguments. Returns false and sets error message if given arguments are invalid
+bool ParseArguments(int argc, const char *const *argv, Arguments &arguments, std::string &error_message);
+// Parse given line of options (quoted like in a shell) into arguments
+bool ParseArgumentsLine(const std::string &line, Arguments &arguments, std::string &error_message);
+void WriteHelp(std::ostream &stream);
+
+// Format given arguments into a single line of (quoted) options, parseable again by ParseArguments
+std::string FormatArguments(const Arguments &arguments);
+
+// Resolve and validate query from given arguments, throws on invalid arguments
+void ResolveQuery(const Arguments &arguments, const FrameSource &source, Query &query);
 
 unsigned short GetModeIdFromName(const std::string &mode);
 
 bool IsTupelRangeMode(int mode_id);
 bool IsHorizontalMode(int mode_id);
 bool IsTraceMode(int mode_id);
+bool IsFindMode(int mode_id);
 bool IsBitmaskMode(int mode_id);
 bool IsValidColor(const std::string &color);
 void ValidateBitmask(const std::string &bitmask_px, int range_width, int range_height);
+void ValidateImage(const Image &image, int range_width, int range_height);
 bool IsValidRangeForMode(int mode_id, const std::string &range);
 bool ModeRequiresAmountPx(int mode_id);
 bool ModeRequiresBitmask(int mode_id);
 bool ModeRequiresColor(int mode_id);
 void ResolveScanningRange(int mode_id, const std::string &range, int &number_1, int &number_2);
-void ValidateScanningRectangle(int from_x, int from_y, int range_x, int range_y, Display *display);
+void ValidateScanningRectangle(int from_x, int from_y, int range_x, int range_y, const FrameSource &source);
 void ResolveRgbColor(const std::string &color, int &red, int &green, int &blue);
+void ResolveColorTolerance(const std::string &tolerance, const std::string &distance, ColorTolerance &color_tolerance);
+void ResolveColors(const std::string &color_list, const std::string &distance, const ColorTolerance &tolerance,
+                   std::vector<MatchColor> &colors);
 
 } // namespace clioptions
 } // namespace pixloc
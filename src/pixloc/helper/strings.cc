@@ -34,7 +34,6 @@
 #include <vector>
 #include <sstream>
 #include <iostream>
-#include <map>
 #include <regex>
 
 #include "strings.h"
@@ -88,16 +87,53 @@ bool ResolveNumericTupel(const std::string &str, int &number_1, int &number_2) {
   return number_1 >= 0 && number_2 >= 0;
 }
 
-std::string FindMostCommon(const std::vector<std::string> &vec) {
-  std::map<std::string,unsigned long> str_map;
-  for (const auto &str : vec)
-    ++str_map[str];
+/**
+ * Split given line into arguments like a shell does: separated by whitespace,
+ * w/ single or double quotes grouping arguments and backslash escaping the following character
+ */
+std::vector<std::string> SplitArguments(const std::string &line) {
+  std::vector<std::string> arguments;
+  std::string argument;
+  bool has_argument = false;
+  char quote = 0;
+
+  for (std::string::size_type index = 0; index < line.length(); ++index) {
+    char character = line[index];
+
+    if (character=='\\' && quote!='\'' && index + 1 < line.length()) {
+      argument += line[++index];
+      has_argument = true;
+    } else if (quote) {
+      if (character==quote) quote = 0;
+      else argument += character;
+    } else if (character=='"' || character=='\'') {
+      quote = character;
+      has_argument = true;
+    } else if (std::isspace(static_cast<unsigned char>(character))) {
+      if (has_argument) arguments.push_back(argument);
+      argument.clear();
+      has_argument = false;
+    } else {
+      argument += character;
+      has_argument = true;
+    }
+  }
+  if (has_argument) arguments.push_back(argument);
+
+  return arguments;
+}
 
-  typedef decltype(std::pair<std::string,unsigned long>()) pair_type;
+/**
+ * Wrap given argument into double quotes, escaping contained quotes and backslashes
+ */
+std::string QuoteArgument(const std::string &argument) {
+  std::string quoted = "\"";
+  for (char character : argument) {
+    if (character=='"' || character=='\\') quoted += '\\';
+    quoted += character;
+  }
 
-  auto comp = [](const pair_type &pair1, const pair_type &pair2) -> bool {
-    return pair1.second < pair2.second; };
-  return std::max_element(str_map.cbegin(), str_map.cend(), comp)->first;
+  return quoted + "\"";
 }
 
 } // namespace strings
@@ -30,6 +30,7 @@
 #ifndef CLASS_PIXLOC_STRINGS
 #define CLASS_PIXLOC_STRINGS
 
+#include <string>
 #include <vector>
 
 namespace helper {
@@ -40,7 +41,8 @@ extern bool IsNumeric(const std::string &str, bool allow_negative = false);
 extern int ToInt(std::string str, int defaultValue = 0);
 bool IsValidNumericTupel(std::string &str);
 bool ResolveNumericTupel(const std::string &str, int &number_1, int &number_2);
-std::string FindMostCommon(const std::vector<std::string> &vec);
+std::vector<std::string> SplitArguments(const std::string &line);
+std::string QuoteArgument(const std::string &argument);
 
 } // namespace strings
 } // namespace pixloc
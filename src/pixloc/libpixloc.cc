@@ -0,0 +1,361 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "libpixloc.h"
+#include "pixloc/cli_options.h"
+#include "pixloc/models/pixel_scanner.h"
+#include "pixloc/models/rectangle.h"
+#include "pixloc/models/session.h"
+
+struct pixloc_session {
+  pixloc::Session *session;
+};
+
+struct pixloc_frame {
+  pixloc_session *session;
+  // Copy of the captured pixels, so frames stay valid while others are captured
+  std::vector<unsigned char> pixels;
+  pixloc::Frame frame;
+  pixloc::Rectangle rectangle;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+// Run given function, return its result or -1 if it threw, exceptions must not pass the C API
+template<typename Function>
+int Call(Function function) {
+  try {
+    return function();
+  } catch (char const *exception) {
+    last_error = exception;
+  } catch (const std::exception &exception) {
+    last_error = exception.what();
+  }
+
+  return -1;
+}
+
+pixloc::Rectangle ToRectangle(const pixloc_rect *rect) {
+  if (!rect) throw "Scanning rectangle is required.";
+
+  return pixloc::Rectangle(rect->x, rect->y, rect->width, rect->height);
+}
+
+std::vector<pixloc::MatchColor> ToMatchColors(const pixloc_color *colors, int amount_colors) {
+  if (!colors || amount_colors < 1) throw "Valid color is required.";
+
+  std::vector<pixloc::MatchColor> match_colors;
+  for (int index = 0; index < amount_colors; ++index)
+    match_colors.emplace_back(colors[index].red, colors[index].green, colors[index].blue,
+                              pixloc::ColorTolerance(colors[index].tolerance));
+
+  return match_colors;
+}
+
+// Scanner of given scanning rectangle, which must lie within the captured rectangle of given frame
+pixloc::PixelScanner *CreateScanner(const pixloc_frame *frame, const pixloc_rect *rect,
+                                    const std::vector<pixloc::MatchColor> &colors) {
+  if (!frame) throw "Frame is required.";
+
+  pixloc::Rectangle rectangle = ToRectangle(rect);
+  if (frame->rectangle.IsEmpty()) throw "Frame is not captured.";
+  if (rectangle.IsEmpty() || !frame->rectangle.Contains(rectangle))
+    throw "Scanning rectangle must lie within the captured rectangle.";
+
+  return new pixloc::PixelScanner(
+      frame->frame.Crop(static_cast<unsigned short>(rectangle.x - frame->rectangle.x),
+                        static_cast<unsigned short>(rectangle.y - frame->rectangle.y),
+                        static_cast<unsigned short>(rectangle.width),
+                        static_cast<unsigned short>(rectangle.height)),
+      frame->session->session->GetSource()->GetDecoder(),
+      static_cast<unsigned short>(rectangle.x), static_cast<unsigned short>(rectangle.y),
+      static_cast<unsigned short>(rectangle.width), static_cast<unsigned short>(rectangle.height),
+      pixloc::ColorMatcher(colors));
+}
+
+void ToPixlocMatch(const pixloc::Match &match, pixloc_match &result) {
+  result.x = match.x;
+  result.y = match.y;
+  result.index_color = match.index_color;
+}
+
+void ToPixlocColor(unsigned int rgb, pixloc_color &color) {
+  color.red = pixloc::PixelDecoder::GetRed(rgb);
+  color.green = pixloc::PixelDecoder::GetGreen(rgb);
+  color.blue = pixloc::PixelDecoder::GetBlue(rgb);
+  color.tolerance = 0;
+}
+
+} // namespace
+
+int pixloc_get_api_version(void) {
+  return PIXLOC_API_VERSION;
+}
+
+const char *pixloc_get_error(void) {
+  return last_error.c_str();
+}
+
+pixloc_session *pixloc_open(const char *input) {
+  pixloc_session *session = nullptr;
+
+  Call([&]() {
+    std::unique_ptr<pixloc::Session> opened(new pixloc::Session(input ? input : ""));
+    session = new pixloc_session;
+    session->session = opened.release();
+
+    return 0;
+  });
+
+  return session;
+}
+
+void pixloc_close(pixloc_session *session) {
+  if (!session) return;
+
+  delete session->session;
+  delete session;
+}
+
+int pixloc_get_screen_size(const pixloc_session *session, int *width, int *height) {
+  return Call([&]() {
+    if (!session || !width || !height) throw "Session and size are required.";
+
+    *width = session->session->GetSource()->GetWidth();
+    *height = session->session->GetSource()->GetHeight();
+
+    return 0;
+  });
+}
+
+pixloc_frame *pixloc_frame_create(pixloc_session *session) {
+  pixloc_frame *frame = nullptr;
+
+  Call([&]() {
+    if (!session) throw "Session is required.";
+
+    frame = new pixloc_frame;
+    frame->session = session;
+
+    return 0;
+  });
+
+  return frame;
+}
+
+void pixloc_frame_release(pixloc_frame *frame) {
+  delete frame;
+}
+
+int pixloc_capture(pixloc_frame *frame, const pixloc_rect *rect) {
+  return Call([&]() {
+    if (!frame) throw "Frame is required.";
+
+    pixloc::Rectangle rectangle = ToRectangle(rect);
+    pixloc::FrameSource *source = frame->session->session->GetSource();
+    if (rectangle.x < 0 || rectangle.y < 0 || rectangle.IsEmpty()) throw "Valid rectangle to capture is required.";
+    pixloc::clioptions::ValidateScanningRectangle(rectangle.x, rectangle.y, rectangle.width, rectangle.height,
+                                                  *source);
+
+    pixloc::Frame captured = source->Capture(static_cast<unsigned short>(rectangle.x),
+                                             static_cast<unsigned short>(rectangle.y),
+                                             static_cast<unsigned short>(rectangle.width),
+                                             static_cast<unsigned short>(rectangle.height));
+
+    auto row_size = static_cast<unsigned int>(captured.width)*(captured.bits_per_pixel/8);
+    frame->pixels.resize(static_cast<unsigned long>(row_size)*captured.height);
+    for (unsigned short y = 0; y < captured.height; ++y)
+      memcpy(&frame->pixels[static_cast<unsigned long>(y)*row_size], captured.Row(y), row_size);
+
+    frame->frame = captured;
+    frame->frame.data = frame->pixels.data();
+    frame->frame.stride = row_size;
+    frame->rectangle = rectangle;
+
+    return 0;
+  });
+}
+
+int pixloc_find_bitmask(const pixloc_frame *frame,
+                        const pixloc_rect *rect,
+                        const pixloc_color *colors,
+                        int amount_colors,
+                        const char *bitmask,
+                        pixloc_match *match) {
+  return Call([&]() {
+    if (!bitmask || !match) throw "Bitmask and match are required.";
+    pixloc::clioptions::ValidateBitmask(bitmask, ToRectangle(rect).width, ToRectangle(rect).height);
+
+    std::unique_ptr<pixloc::PixelScanner> scanner(CreateScanner(frame, rect, ToMatchColors(colors, amount_colors)));
+    scanner->SetReportMatchedColor(true);
+
+    pixloc::Match found{};
+    if (!scanner->FindBitmask(bitmask, 0, found)) return 0;
+
+    ToPixlocMatch(found, *match);
+
+    return 1;
+  });
+}
+
+int pixloc_find_all_bitmask(const pixloc_frame *frame,
+                            const pixloc_rect *rect,
+                            const pixloc_color *colors,
+                            int amount_colors,
+                            const char *bitmask,
+                            pixloc_match *matches,
+                            int max_matches) {
+  return Call([&]() {
+    if (!bitmask || !matches || max_matches < 1) throw "Bitmask and matches are required.";
+    pixloc::clioptions::ValidateBitmask(bitmask, ToRectangle(rect).width, ToRectangle(rect).height);
+
+    std::unique_ptr<pixloc::PixelScanner> scanner(CreateScanner(frame, rect, ToMatchColors(colors, amount_colors)));
+    scanner->SetReportMatchedColor(true);
+
+    std::vector<pixloc::Match> found;
+    scanner->FindAllBitmasks(bitmask, static_cast<unsigned int>(max_matches), 0, found);
+
+    for (unsigned long index = 0; index < found.size(); ++index) ToPixlocMatch(found[index], matches[index]);
+
+    return static_cast<int>(found.size());
+  });
+}
+
+int pixloc_find_consecutive(const pixloc_frame *frame,
+                            const pixloc_rect *rect,
+                            const pixloc_color *colors,
+                            int amount_colors,
+                            int amount,
+                            int step,
+                            int *offset) {
+  return Call([&]() {
+    pixloc::Rectangle rectangle = ToRectangle(rect);
+    if (rectangle.width!=1 && rectangle.height!=1) throw "Scanning rectangle must be a single row or column.";
+    if (amount < 1 || amount > 0xffff) throw "Valid amount of pixels to find is required.";
+    if (step < 1 || step > 0xffff) throw "Valid step size is required.";
+    if (!offset) throw "Offset is required.";
+
+    std::unique_ptr<pixloc::PixelScanner> scanner(CreateScanner(frame, rect, ToMatchColors(colors, amount_colors)));
+
+    *offset = scanner->ScanUniaxial(static_cast<unsigned short>(amount), static_cast<unsigned short>(step));
+
+    return *offset > -1 ? 1 : 0;
+  });
+}
+
+int pixloc_trace_main_color(const pixloc_frame *frame, const pixloc_rect *rect, pixloc_color *color) {
+  return Call([&]() {
+    if (!color) throw "Color is required.";
+
+    std::unique_ptr<pixloc::PixelScanner> scanner(
+        CreateScanner(frame, rect, std::vector<pixloc::MatchColor>{pixloc::MatchColor()}));
+
+    auto most_common = scanner->GetMostCommonColors(1, 0);
+    if (most_common.empty()) throw "Scanning rectangle is empty.";
+
+    ToPixlocColor(most_common[0].first, *color);
+
+    return 0;
+  });
+}
+
+int pixloc_fingerprint(const pixloc_frame *frame, const pixloc_rect *rect, int is_perceptual,
+                       unsigned long long *fingerprint) {
+  return Call([&]() {
+    if (!fingerprint) throw "Fingerprint is required.";
+
+    std::unique_ptr<pixloc::PixelScanner> scanner(
+        CreateScanner(frame, rect, std::vector<pixloc::MatchColor>{pixloc::MatchColor()}));
+
+    *fingerprint = scanner->GetFingerprint(is_perceptual ? pixloc::Fingerprint::kKindPerceptual
+                                                         : pixloc::Fingerprint::kKindExact);
+
+    return 0;
+  });
+}
+
+int pixloc_get_pixel(const pixloc_frame *frame, int x, int y, pixloc_color *color) {
+  return Call([&]() {
+    if (!frame || !color) throw "Frame and color are required.";
+    if (!frame->rectangle.Contains(pixloc::Rectangle(x, y, 1, 1)))
+      throw "Pixel must lie within the captured rectangle.";
+
+    unsigned long pixel = frame->frame.GetPixel(static_cast<unsigned short>(x - frame->rectangle.x),
+                                                static_cast<unsigned short>(y - frame->rectangle.y));
+    ToPixlocColor(frame->session->session->GetSource()->GetDecoder()->Decode(pixel), *color);
+
+    return 0;
+  });
+}
+
+int pixloc_query(pixloc_session *session, const char *options, char *output, size_t output_size) {
+  // Empty output on any failure, so the buffer never holds stale text of a previous call
+  if (output && output_size > 0) output[0] = '\0';
+
+  return Call([&]() {
+    if (!session || !options) throw "Session and options are required.";
+
+    pixloc::clioptions::Arguments arguments;
+    std::string error_message;
+    if (!pixloc::clioptions::ParseArgumentsLine(options, arguments, error_message)) {
+      last_error = "Error in command line: " + error_message;
+      return -1;
+    }
+    if (!arguments.input.empty()) throw "Input is not available in queries, it is given when opening the session.";
+    if (arguments.show_help || !arguments.serve.empty() || !arguments.client.empty() || !arguments.batch.empty() ||
+        arguments.stats)
+      throw "Option not available in queries.";
+    // Raw output is binary and can contain 0 bytes, which a C string cannot hold
+    if (arguments.format=="raw") throw "Raw output is not available in queries.";
+
+    pixloc::clioptions::Query query;
+    pixloc::clioptions::ResolveQuery(arguments, *session->session->GetSource(), query);
+
+    std::ostringstream out;
+    bool is_found = session->session->Run(query, out);
+
+    if (output && output_size > 0) {
+      std::string text = out.str();
+      size_t length = text.length() < output_size ? text.length() : output_size - 1;
+      memcpy(output, text.data(), length);
+      output[length] = '\0';
+    }
+
+    return is_found ? 1 : 0;
+  });
+}
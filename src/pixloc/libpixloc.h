@@ -0,0 +1,141 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_LIBPIXLOC
+#define CLASS_PIXLOC_LIBPIXLOC
+
+/*
+ * C API of libpixloc: keep a session (display connection and capture buffers) open, capture rectangles into
+ * reusable frames and run queries on them, w/o starting a pixloc process per query.
+ *
+ * Coordinates are those of the command line: scanning rectangles are given like --from and --range, found
+ * coordinates are those pixloc outputs as "x=..; y=..;". Functions returning int return -1 on failure, the message
+ * of the last failure of the calling thread is available via pixloc_get_error().
+ * A session and its frames must not be used by multiple threads at once.
+ */
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define PIXLOC_API __attribute__((visibility("default")))
+#else
+#define PIXLOC_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremented on incompatible changes of the API */
+#define PIXLOC_API_VERSION 1
+
+typedef struct pixloc_session pixloc_session;
+typedef struct pixloc_frame pixloc_frame;
+
+typedef struct pixloc_rect {
+  int x;
+  int y;
+  int width;
+  int height;
+} pixloc_rect;
+
+/* Sought color, matching colors whose channels differ from it by up to the tolerance */
+typedef struct pixloc_color {
+  unsigned char red;
+  unsigned char green;
+  unsigned char blue;
+  unsigned char tolerance;
+} pixloc_color;
+
+typedef struct pixloc_match {
+  int x;
+  int y;
+  /* Index of the sought color matched by the 1st set pixel of the bitmask */
+  int index_color;
+} pixloc_match;
+
+PIXLOC_API int pixloc_get_api_version(void);
+
+/* Message of the last failed call of the calling thread, empty if there was none */
+PIXLOC_API const char *pixloc_get_error(void);
+
+/* Open session on given input, see --input. NULL or "" = live screen. Returns NULL on failure */
+PIXLOC_API pixloc_session *pixloc_open(const char *input);
+PIXLOC_API void pixloc_close(pixloc_session *session);
+
+PIXLOC_API int pixloc_get_screen_size(const pixloc_session *session, int *width, int *height);
+
+/* Create frame of given session, to be (re-)captured via pixloc_capture(). Returns NULL on failure */
+PIXLOC_API pixloc_frame *pixloc_frame_create(pixloc_session *session);
+PIXLOC_API void pixloc_frame_release(pixloc_frame *frame);
+
+/* Capture given rectangle into given frame, reusing its memory. Returns 0 on success */
+PIXLOC_API int pixloc_capture(pixloc_frame *frame, const pixloc_rect *rect);
+
+/* Queries on a captured frame, within given scanning rectangle inside the captured one.
+ * Find functions return 1 if found, 0 if not found */
+
+/* Find 1st occurrence of given bitmask (see --bitmask), of pixels matching any of given colors */
+PIXLOC_API int pixloc_find_bitmask(const pixloc_frame *frame, const pixloc_rect *rect,
+                                   const pixloc_color *colors, int amount_colors,
+                                   const char *bitmask, pixloc_match *match);
+
+/* Find up to given max. amount of occurrences of given bitmask, row by row. Returns amount found */
+PIXLOC_API int pixloc_find_all_bitmask(const pixloc_frame *frame, const pixloc_rect *rect,
+                                       const pixloc_color *colors, int amount_colors,
+                                       const char *bitmask, pixloc_match *matches, int max_matches);
+
+/* Find given amount of consecutive matching pixels within a scanning rectangle of a single row (find horizontal) or
+ * column (find vertical), checking every step-th pixel.
+ * Found: offset within the row or column, like x:..; resp. y:..; */
+PIXLOC_API int pixloc_find_consecutive(const pixloc_frame *frame, const pixloc_rect *rect,
+                                       const pixloc_color *colors, int amount_colors,
+                                       int amount, int step, int *offset);
+
+/* Get most common color */
+PIXLOC_API int pixloc_trace_main_color(const pixloc_frame *frame, const pixloc_rect *rect, pixloc_color *color);
+
+/* Get fingerprint of the pixels (see fingerprint mode): exact if is_perceptual is 0, coarse perceptual otherwise */
+PIXLOC_API int pixloc_fingerprint(const pixloc_frame *frame, const pixloc_rect *rect, int is_perceptual,
+                                  unsigned long long *fingerprint);
+
+/* Get color of pixel at given coordinate (given like --from) within the captured rectangle, tolerance is set to 0 */
+PIXLOC_API int pixloc_get_pixel(const pixloc_frame *frame, int x, int y, pixloc_color *color);
+
+/* Run query of any mode, given as line of command line options (quoted like in a shell), on a new capture.
+ * Its output (as printed by pixloc) is written into given buffer, truncated to its size incl. terminating 0.
+ * Returns 1 if a match was found (trace modes: always, fingerprint mode: unless differing from --compare), 0 if not.
+ * Not available: --input, --format raw, --stats, --batch, --serve, --client and help. On failure output is empty */
+PIXLOC_API int pixloc_query(pixloc_session *session, const char *options, char *output, size_t output_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLASS_PIXLOC_LIBPIXLOC
@@ -27,146 +27,78 @@
   POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <X11/Xlib.h>
-#include <cstdio>
-#include <cstring>
+#include <fstream>
 #include <iostream>
 
-#include "config.h"
-#include "external/clara.hpp"
-#include "pixloc/helper/strings.h"
 #include "cli_options.h"
-#include "pixloc/models/pixel_scanner.h"
+#include "server.h"
+#include "pixloc/models/session.h"
 
-using namespace clara;
+/**
+ * Run query lines of given batch file, or of stdin if given "-"
+ */
+static int RunBatch(pixloc::Session *session, const std::string &path) {
+  if (path=="-") return session->RunBatch(std::cin, std::cout, std::cerr);
+
+  std::ifstream batch_file(path);
+  if (!batch_file) {
+    std::cerr << "Error: Failed to open batch file " << path << "\n";
+    return -1;
+  }
+
+  return session->RunBatch(batch_file, std::cout, std::cerr);
+}
 
 /**
  * @param argc Amount of arguments received
  * @param argv Array of arguments received, argv[0] is name and path of executable
  */
 int main(int argc, char **argv) {
-  std::string mode;
-  std::string from;
-  std::string range;
-  std::string color;
-  std::string amount;
-  std::string bitmask;
-  std::string tolerance;
-  std::string step;
-
-  bool show_help = false;
-
-  // Use clara CLI options parser
-  auto clara_parser =
-      Opt(mode, "mode")["-m"]["--mode"]("see usage examples for available modes").required() |
-          Opt(from, "from")["-f"]["--from"]("starting coordinate").required() |
-          Opt(range, "range")["-r"]["--range"]("amount of pixels to be scanned").required() |
-          Opt(color, "color")["-c"]["--color"]("rgb color value to find").optional() |
-          Opt(amount, "amount")["-a"]["--amount"]("amount of consecutive pixels of given color to find").optional() |
-          Opt(bitmask,
-              "bitmask")["-b"]["--bitmask"]("pixel mask to find (* = given color, _ = other colors)").optional() |
-          Opt(tolerance, "tolerance")["-t"]["--tolerance"]("optional: color tolerance").optional() |
-          Opt(step, "step")["-s"]["--step"]("optional: interval step size of horizontal/vertical find mode").optional() |
-          Help(show_help);
-  auto clara_result = clara_parser.parse(Args(argc, reinterpret_cast<const char *const *>(argv)));
-  if (!clara_result) {
-    std::cerr << "Error in command line: " << clara_result.errorMessage() << std::endl;
+  pixloc::ScanStats stats;
+  uint64_t start = pixloc::ScanStats::Now();
+
+  pixloc::clioptions::Arguments arguments;
+  std::string error_message;
+
+  if (!pixloc::clioptions::ParseArguments(argc, argv, arguments, error_message)) {
+    std::cerr << "Error in command line: " << error_message << std::endl;
     return 1;
   }
 
-  if (show_help) {
-    std::cout << "pixloc version " <<
-              Pixloc_VERSION_MAJOR << "." << Pixloc_VERSION_MINOR << "\n"
-                  "Copyright (c) 2019 Kay Stenschke\n\n";
-    clara_parser.writeToStream(std::cout);
-    std::cout << pixloc::clioptions::kUsageExamples;
+  if (arguments.show_help) {
+    pixloc::clioptions::WriteHelp(std::cout);
     return 0;
   }
 
-  // Resolve options
-  Display *display;
-
-  unsigned short mode_id, amount_px = 1, color_tolerance = 0, step_size = 1;
-
-  int from_x = -1, from_y = -1,
-      range_x = -1, range_y = -1,
-      red = -1, green = -1, blue = -1;
-
-  bool is_bitmask_mode, is_trace_mode;
+  if (!arguments.client.empty()) return pixloc::Server::RunClient(arguments.client, arguments);
 
+  pixloc::Session *session;
   try {
-    display = XOpenDisplay(nullptr);
-    if (!display) throw "Failed to open default display.\n";
-
-    mode_id = pixloc::clioptions::GetModeIdFromName(mode);
-    is_trace_mode = pixloc::clioptions::IsTraceMode(mode_id);
-
-    bool use_mouse_for_from = strcmp(from.c_str(), "mouse")==0;
-    if (use_mouse_for_from || mode_id==pixloc::clioptions::kModeIdTraceMouse) {
-      // Get current mouse position
-      XEvent event{};
-      XQueryPointer(display, RootWindow(display, DefaultScreen(display)),
-                    &event.xbutton.root, &event.xbutton.window,
-                    &event.xbutton.x_root, &event.xbutton.y_root,
-                    &from_x, &from_y,
-                    &event.xbutton.state);
-      if (is_trace_mode) {
-        printf("x=%d; y=%d;\n", from_x, from_y);
-        if (mode_id==pixloc::clioptions::kModeIdTraceMouse) return 0;
-      }
-    }
-
-    if (!use_mouse_for_from && !helper::strings::ResolveNumericTupel(from, from_x, from_y))
-      throw "Valid from coordinate is required.";
-    pixloc::clioptions::ResolveScanningRange(mode_id, range, range_x, range_y);
-    pixloc::clioptions::ValidateScanningRectangle(from_x, from_y, range_x, range_y, display);
-
-    if (pixloc::clioptions::ModeRequiresAmountPx(mode_id) &&
-        (amount_px = static_cast<unsigned short>(helper::strings::ToInt(amount, 0)))==0)
-      throw "Valid amount of pixels to find is required.";
-
-    is_bitmask_mode = pixloc::clioptions::IsBitmaskMode(mode_id);
-    if (pixloc::clioptions::ModeRequiresBitmask(mode_id))
-      pixloc::clioptions::ValidateBitmask(bitmask, range_x, range_y);
-
-    if (pixloc::clioptions::ModeRequiresColor(mode_id)) pixloc::clioptions::ResolveRgbColor(color, red, green, blue);
-
-    if (!tolerance.empty()) {
-      if (!helper::strings::IsNumeric(tolerance)) throw "Invalid color tolerance value given.";
-      color_tolerance = static_cast<unsigned short>(helper::strings::ToInt(tolerance, 0));
-    }
-    if (!step.empty()) {
-      if (!helper::strings::IsNumeric(step)) throw "Invalid step size given.";
-      step_size = static_cast<unsigned short>(helper::strings::ToInt(step, 1));
-      if (step_size < 1) step_size = 1;
-      if (step_size > ((range_x > 1) ? range_x : range_y)) throw "Step size exceeds range.";
-    }
+    pixloc::ScanStats::Timer timer(&stats, pixloc::ScanStats::kPhaseOpenDisplay);
+    session = new pixloc::Session(arguments.input);
   } catch (char const *exception) {
     std::cerr << "Error: " << exception << "\nFor help run: pixloc -h\n\n";
     return -1;
   }
 
-  // Scan pixels
-  auto *scanner = new pixloc::PixelScanner(
-      display,
-      static_cast<unsigned short>(from_x), static_cast<unsigned short>(from_y),
-      static_cast<unsigned short>(range_x), static_cast<unsigned short>(range_y),
-      static_cast<unsigned short>(red * 256),
-      static_cast<unsigned short>(green * 256),
-      static_cast<unsigned short>(blue * 256),
-      static_cast<unsigned short>(color_tolerance * 256));
-
-  if (mode_id == pixloc::clioptions::kModeIdTraceMainColor) {
-    scanner->TraceMainColor();
-  } else if (is_bitmask_mode) {
-    if (is_trace_mode) scanner->TraceBitmask();
-    else std::cout << scanner->FindBitmask(bitmask);
+  if (arguments.stats) session->SetStats(&stats);
+
+  int exit_code;
+  if (!arguments.serve.empty()) {
+    exit_code = pixloc::Server(session, arguments.serve).Run();
+  } else if (!arguments.batch.empty()) {
+    exit_code = RunBatch(session, arguments.batch);
   } else {
-    int location = scanner->ScanUniaxial(amount_px, step_size, is_trace_mode);
-    if (!is_trace_mode) std::cout << (range_y < 2 ? "x:" : "y:" ) << location << ";";
+    exit_code = session->Run(arguments, std::cout, std::cerr);
+  }
+
+  if (arguments.stats) {
+    session->FinishStats();
+    stats.Add(pixloc::ScanStats::kPhaseTotal, pixloc::ScanStats::Now() - start);
+    std::cerr << stats.FormatJson() << std::endl;
   }
 
-  delete scanner;
+  delete session;
 
-  return 0;
-}
\ No newline at end of file
+  return exit_code;
+}
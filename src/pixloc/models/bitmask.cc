@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "bitmask.h"
+#include "pixloc/helper/strings.h"
+
+namespace pixloc {
+
+// Constructor
+Bitmask::Bitmask(unsigned short width, unsigned short height) {
+  this->width = width;
+  this->height = height;
+  this->words_per_row = GetAmountWords(width);
+  this->words.assign(static_cast<unsigned long>(words_per_row)*height, 0);
+}
+
+// Constructor
+Bitmask::Bitmask(const std::string &pattern) : Bitmask(0, 0) {
+  std::vector<std::string> rows = helper::strings::Explode(pattern, kRowSeparator);
+  if (rows.empty()) return;
+
+  this->width = static_cast<unsigned short>(rows[0].length());
+  this->height = static_cast<unsigned short>(rows.size());
+  this->words_per_row = GetAmountWords(width);
+  this->words.assign(static_cast<unsigned long>(words_per_row)*height, 0);
+
+  for (unsigned short y = 0; y < height; ++y) {
+    const std::string &row = rows[y];
+    for (unsigned short x = 0; x < width && x < row.length(); ++x) {
+      if (row[x]==kCharSet) Set(x, y);
+    }
+  }
+}
+
+std::string Bitmask::FormatRow(unsigned short y) const {
+  std::string row(width, kCharUnset);
+  for (unsigned short x = 0; x < width; ++x) {
+    if (Get(x, y)) row[x] = kCharSet;
+  }
+
+  return row;
+}
+
+bool Bitmask::FindFirstSet(unsigned short &x, unsigned short &y) const {
+  for (y = 0; y < height; ++y) {
+    const uint64_t *row = GetRow(y);
+
+    for (unsigned short index_word = 0; index_word < words_per_row; ++index_word) {
+      if (!row[index_word]) continue;
+
+      x = static_cast<unsigned short>(index_word*64 + __builtin_ctzll(row[index_word]));
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+int Bitmask::FindRun(const uint64_t *row, unsigned short width, unsigned short amount) {
+  unsigned short amount_found = 0;
+
+  for (unsigned short x = 0; x < width;) {
+    uint64_t word = row[x >> 6];
+
+    if ((x & 63)==0 && x + 64 <= width && (word==0 || word==~static_cast<uint64_t>(0))) {
+      // Skip words w/o any or w/ only set bits at once
+      if (word==0) {
+        amount_found = 0;
+      } else if (amount_found + 64 >= amount) {
+        return x + (amount - amount_found) - 1;
+      } else {
+        amount_found = static_cast<unsigned short>(amount_found + 64);
+      }
+      x = static_cast<unsigned short>(x + 64);
+      continue;
+    }
+
+    if ((word >> (x & 63)) & 1) {
+      if (++amount_found==amount) return x;
+    } else {
+      amount_found = 0;
+    }
+    ++x;
+  }
+
+  return -1;
+}
+
+} // namespace pixloc
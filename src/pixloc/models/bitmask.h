@@ -0,0 +1,88 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_BITMASK
+#define CLASS_PIXLOC_BITMASK
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pixloc {
+
+// 1-bit pixel mask, bit-packed: 64 pixels per word, bit x%64 of word x/64 of a row represents pixel x
+class Bitmask {
+
+ public:
+  static const char kCharSet = '*';
+  static const char kCharUnset = '_';
+  static const char kRowSeparator = ',';
+
+  // Constructor: empty (all bits unset) mask of given dimension
+  Bitmask(unsigned short width, unsigned short height);
+
+  // Constructor: parse given mask pattern, e.g. "*__,**_,*__"
+  explicit Bitmask(const std::string &pattern);
+
+  inline unsigned short GetWidth() const { return width; }
+  inline unsigned short GetHeight() const { return height; }
+  inline unsigned short GetWordsPerRow() const { return words_per_row; }
+
+  inline uint64_t *GetRow(unsigned short y) { return &words[static_cast<unsigned long>(y)*words_per_row]; }
+  inline const uint64_t *GetRow(unsigned short y) const {
+    return &words[static_cast<unsigned long>(y)*words_per_row];
+  }
+
+  inline bool Get(unsigned short x, unsigned short y) const { return (GetRow(y)[x >> 6] >> (x & 63)) & 1; }
+  inline void Set(unsigned short x, unsigned short y) { GetRow(y)[x >> 6] |= static_cast<uint64_t>(1) << (x & 63); }
+
+  // Format given row into string of * and _ characters
+  std::string FormatRow(unsigned short y) const;
+
+  // Get coordinate of the 1st set bit, in row order. Returns false if no bit is set
+  bool FindFirstSet(unsigned short &x, unsigned short &y) const;
+
+  // Get index of the last bit of the 1st run of given amount of consecutive set bits within given row, or -1
+  static int FindRun(const uint64_t *row, unsigned short width, unsigned short amount);
+
+  static inline unsigned short GetAmountWords(unsigned long amount_bits) {
+    return static_cast<unsigned short>((amount_bits + 63)/64);
+  }
+
+ private:
+  unsigned short width;
+  unsigned short height;
+  unsigned short words_per_row;
+
+  std::vector<uint64_t> words;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_BITMASK
@@ -0,0 +1,146 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <queue>
+#include <utility>
+
+#include "bitmask_automaton.h"
+
+namespace pixloc {
+
+// Constructor
+BitmaskAutomaton::BitmaskAutomaton(const Bitmask &needle) {
+  Build(std::vector<const Bitmask *>{&needle});
+}
+
+BitmaskAutomaton::BitmaskAutomaton(const std::vector<const Bitmask *> &needles) {
+  Build(needles);
+}
+
+// Build trie of all needle rows, than complete it into a deterministic automaton by following failure links.
+// All rows of a needle are of same width, so they can only end at states of that depth
+void BitmaskAutomaton::Build(const std::vector<const Bitmask *> &needles) {
+  const unsigned int kNoState = 0xffffffff;
+  typedef std::pair<unsigned short, unsigned short> needle_row;
+
+  transitions.assign(2, kNoState);
+  std::vector<std::vector<needle_row>> outputs(1);
+
+  for (unsigned short index_needle = 0; index_needle < needles.size(); ++index_needle) {
+    const Bitmask &needle = *needles[index_needle];
+    widths.push_back(needle.GetWidth());
+    heights.push_back(needle.GetHeight());
+    column_offsets.push_back(column_patterns.size());
+
+    for (unsigned short y = 0; y < needle.GetHeight(); ++y) {
+      unsigned int state = 0;
+
+      for (unsigned short x = 0; x < needle.GetWidth(); ++x) {
+        unsigned int index_transition = state*2 + (needle.Get(x, y) ? 1 : 0);
+        if (transitions[index_transition]==kNoState) {
+          transitions[index_transition] = static_cast<unsigned int>(outputs.size());
+          transitions.push_back(kNoState);
+          transitions.push_back(kNoState);
+          outputs.emplace_back();
+        }
+        state = transitions[index_transition];
+      }
+
+      // Identical rows of a needle end at the same state and share the ID of their first occurrence
+      if (outputs[state].empty() || outputs[state].back().first!=index_needle)
+        outputs[state].emplace_back(index_needle, y);
+
+      column_patterns.push_back(outputs[state].back().second);
+    }
+
+    column_failures.resize(column_patterns.size());
+    BuildColumnFailures(index_needle);
+  }
+
+  // Breadth-first: failure state of each state is complete before its children are
+  std::vector<unsigned int> failures(outputs.size(), 0);
+  std::queue<unsigned int> states;
+
+  for (unsigned int bit = 0; bit < 2; ++bit) {
+    if (transitions[bit]==kNoState) {
+      transitions[bit] = 0;
+    } else {
+      states.push(transitions[bit]);
+    }
+  }
+
+  while (!states.empty()) {
+    unsigned int state = states.front();
+    states.pop();
+
+    // Rows ending at the failure state (a suffix of this state's bits) end here as well
+    if (state!=0) {
+      const std::vector<needle_row> &suffix_outputs = outputs[failures[state]];
+      outputs[state].insert(outputs[state].end(), suffix_outputs.begin(), suffix_outputs.end());
+    }
+
+    for (unsigned int bit = 0; bit < 2; ++bit) {
+      unsigned int index_transition = state*2 + bit;
+      unsigned int fallback = transitions[failures[state]*2 + bit];
+
+      if (transitions[index_transition]==kNoState) {
+        transitions[index_transition] = fallback;
+      } else {
+        failures[transitions[index_transition]] = fallback;
+        states.push(transitions[index_transition]);
+      }
+    }
+  }
+
+  output_offsets.push_back(0);
+  for (const auto &state_outputs : outputs) {
+    for (const auto &output : state_outputs) {
+      output_needles.push_back(output.first);
+      output_row_ids.push_back(output.second);
+    }
+    output_offsets.push_back(static_cast<unsigned int>(output_needles.size()));
+  }
+}
+
+void BitmaskAutomaton::BuildColumnFailures(unsigned short index_needle) {
+  const unsigned short *pattern = &column_patterns[column_offsets[index_needle]];
+  unsigned short *failures = &column_failures[column_offsets[index_needle]];
+
+  if (heights[index_needle] > 0) failures[0] = 0;
+
+  unsigned short length_prefix = 0;
+  for (unsigned short index = 1; index < heights[index_needle]; ++index) {
+    while (length_prefix > 0 && pattern[index]!=pattern[length_prefix]) length_prefix = failures[length_prefix - 1];
+
+    if (pattern[index]==pattern[length_prefix]) ++length_prefix;
+    failures[index] = length_prefix;
+  }
+}
+
+} // namespace pixloc
@@ -0,0 +1,106 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_BITMASK_AUTOMATON
+#define CLASS_PIXLOC_BITMASK_AUTOMATON
+
+#include <cstdint>
+#include <vector>
+
+#include "pixloc/models/bitmask.h"
+
+namespace pixloc {
+
+// Baker-Bird matcher of one or more bitmask needles: an Aho-Corasick automaton over all needle rows identifies which
+// needle rows end at each column of a haystack row, KMP over each needle's sequence of row IDs then runs down the
+// columns. Every haystack pixel is examined once, so finding all occurrences takes linear time whatever the needles
+// look like, and many needles are searched in a single pass
+class BitmaskAutomaton {
+
+ public:
+  // Constructor
+  explicit BitmaskAutomaton(const Bitmask &needle);
+  explicit BitmaskAutomaton(const std::vector<const Bitmask *> &needles);
+
+  inline unsigned short GetAmountNeedles() const { return static_cast<unsigned short>(widths.size()); }
+  inline unsigned short GetWidth(unsigned short index_needle = 0) const { return widths[index_needle]; }
+  inline unsigned short GetHeight(unsigned short index_needle = 0) const { return heights[index_needle]; }
+
+  // Run given haystack row through the row automaton, call visitor(x, index_needle, row_id) for each needle row
+  // ending at column x. IDs of identical rows of a needle are the same
+  template<typename Visitor>
+  inline void ScanRow(const uint64_t *haystack_row, unsigned short haystack_width, Visitor visitor) const {
+    unsigned int state = 0;
+
+    for (unsigned short x = 0; x < haystack_width; ++x) {
+      state = transitions[state*2 + ((haystack_row[x >> 6] >> (x & 63)) & 1)];
+
+      for (unsigned int index = output_offsets[state]; index < output_offsets[state + 1]; ++index)
+        visitor(x, output_needles[index], output_row_ids[index]);
+    }
+  }
+
+  // Advance given column state (= amount of matched rows of given needle) by the row ID found in the next haystack
+  // row. Returns the needle's height if all rows of the needle are matched, ending at that haystack row
+  inline unsigned short AdvanceColumn(unsigned short index_needle, unsigned short state, unsigned short row_id) const {
+    const unsigned short *pattern = &column_patterns[column_offsets[index_needle]];
+    const unsigned short *failures = &column_failures[column_offsets[index_needle]];
+
+    if (state==heights[index_needle]) state = failures[state - 1];
+
+    while (state > 0 && pattern[state]!=row_id) state = failures[state - 1];
+
+    return pattern[state]==row_id ? static_cast<unsigned short>(state + 1) : state;
+  }
+
+ private:
+  std::vector<unsigned short> widths;
+  std::vector<unsigned short> heights;
+
+  // Row automaton: two transitions (unset / set bit) per state
+  std::vector<unsigned int> transitions;
+
+  // Needle rows ending at each state (incl. those ending at its failure states): from output_offsets[state]
+  // to output_offsets[state + 1]
+  std::vector<unsigned int> output_offsets;
+  std::vector<unsigned short> output_needles;
+  std::vector<unsigned short> output_row_ids;
+
+  // Per needle, from column_offsets[index_needle]: sequence of row IDs, w/ its KMP failure function
+  std::vector<unsigned long> column_offsets;
+  std::vector<unsigned short> column_patterns;
+  std::vector<unsigned short> column_failures;
+
+  void Build(const std::vector<const Bitmask *> &needles);
+  void BuildColumnFailures(unsigned short index_needle);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_BITMASK_AUTOMATON
@@ -0,0 +1,75 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "bitmask_needle.h"
+
+namespace pixloc {
+
+// Constructor
+BitmaskNeedle::BitmaskNeedle(const Bitmask &bitmask) {
+  this->width = bitmask.GetWidth();
+  this->height = bitmask.GetHeight();
+  this->words_per_shifted_row = Bitmask::GetAmountWords(63 + static_cast<unsigned long>(width));
+
+  shifted_rows.assign(64UL*height*words_per_shifted_row, 0);
+  shifted_masks.assign(64UL*words_per_shifted_row, 0);
+
+  // Mask of all bits within the needle's width, unshifted
+  Bitmask mask(width, 1);
+  for (unsigned short x = 0; x < width; ++x) mask.Set(x, 0);
+
+  for (unsigned short alignment = 0; alignment < 64; ++alignment) {
+    amount_words_per_alignment[alignment] = Bitmask::GetAmountWords(static_cast<unsigned long>(alignment) + width);
+
+    unsigned long index_alignment = static_cast<unsigned long>(alignment)*words_per_shifted_row;
+    ShiftBits(mask.GetRow(0), mask.GetWordsPerRow(), alignment, &shifted_masks[index_alignment], words_per_shifted_row);
+
+    for (unsigned short y = 0; y < height; ++y) {
+      ShiftBits(bitmask.GetRow(y), bitmask.GetWordsPerRow(), alignment,
+                &shifted_rows[index_alignment*height + static_cast<unsigned long>(y)*words_per_shifted_row],
+                words_per_shifted_row);
+    }
+  }
+}
+
+// Copy given bits into destination, shifted towards higher bit indices by given amount (< 64)
+void BitmaskNeedle::ShiftBits(const uint64_t *source,
+                              unsigned short amount_source_words,
+                              unsigned short shift,
+                              uint64_t *destination,
+                              unsigned short amount_destination_words) {
+  for (unsigned short index = 0; index < amount_destination_words; ++index) {
+    uint64_t word = index < amount_source_words ? source[index] << shift : 0;
+    if (shift > 0 && index > 0 && index - 1 < amount_source_words) word |= source[index - 1] >> (64 - shift);
+
+    destination[index] = word;
+  }
+}
+
+} // namespace pixloc
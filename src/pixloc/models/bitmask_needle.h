@@ -0,0 +1,95 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_BITMASK_NEEDLE
+#define CLASS_PIXLOC_BITMASK_NEEDLE
+
+#include <cstdint>
+#include <vector>
+
+#include "pixloc/models/bitmask.h"
+
+namespace pixloc {
+
+// Bitmask to be found within a (bit-packed) haystack bitmask. Rows are pre-shifted for each of the 64 possible
+// bit alignments of a haystack offset, so comparing a row at any offset takes a few AND/XOR operations per word
+class BitmaskNeedle {
+
+ public:
+  // Constructor
+  explicit BitmaskNeedle(const Bitmask &bitmask);
+
+  inline unsigned short GetWidth() const { return width; }
+  inline unsigned short GetHeight() const { return height; }
+
+  // Whether given row of the needle equals the bits of given haystack row, starting at given x offset
+  inline bool MatchesRow(const uint64_t *haystack_row, unsigned short x, unsigned short needle_y) const {
+    unsigned short alignment = x & 63;
+    unsigned long index_alignment = static_cast<unsigned long>(alignment)*words_per_shifted_row;
+    const uint64_t *pattern =
+        &shifted_rows[index_alignment*height + static_cast<unsigned long>(needle_y)*words_per_shifted_row];
+    const uint64_t *mask = &shifted_masks[index_alignment];
+
+    haystack_row += x >> 6;
+    for (unsigned short index_word = 0; index_word < amount_words_per_alignment[alignment]; ++index_word) {
+      if ((haystack_row[index_word] ^ pattern[index_word]) & mask[index_word]) return false;
+    }
+
+    return true;
+  }
+
+  // Whether all rows of the needle are contained in given haystack, w/ the needle's top-left at given coordinate
+  inline bool Matches(const Bitmask &haystack, unsigned short x, unsigned short y) const {
+    for (unsigned short needle_y = 0; needle_y < height; ++needle_y) {
+      if (!MatchesRow(haystack.GetRow(static_cast<unsigned short>(y + needle_y)), x, needle_y)) return false;
+    }
+
+    return true;
+  }
+
+ private:
+  unsigned short width;
+  unsigned short height;
+  unsigned short words_per_shifted_row;
+
+  // Amount of words spanned by a shifted row, per alignment
+  unsigned short amount_words_per_alignment[64];
+
+  // Per alignment: all rows, shifted left by the alignment
+  std::vector<uint64_t> shifted_rows;
+  // Per alignment: bits covered by the needle's width, shifted left by the alignment
+  std::vector<uint64_t> shifted_masks;
+
+  static void ShiftBits(const uint64_t *source, unsigned short amount_source_words, unsigned short shift,
+                        uint64_t *destination, unsigned short amount_destination_words);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_BITMASK_NEEDLE
@@ -0,0 +1,152 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+
+#include "color_histogram.h"
+
+namespace pixloc {
+
+// Constructor
+ColorHistogram::ColorHistogram() {
+  this->amount_colors = 0;
+  this->hash_shift = 24;
+  this->sparse_keys.assign(kInitialSparseCapacity, static_cast<unsigned int>(kEmptyKey));
+  this->sparse_counts.assign(kInitialSparseCapacity, 0);
+}
+
+void ColorHistogram::AddRow(const unsigned int *rgb_row, unsigned short width) {
+  unsigned short x = 0;
+  while (x < width) {
+    unsigned int rgb = rgb_row[x];
+    unsigned short offset_run_end = x + 1;
+    while (offset_run_end < width && rgb_row[offset_run_end]==rgb) ++offset_run_end;
+
+    Add(rgb, offset_run_end - x);
+    x = offset_run_end;
+  }
+}
+
+void ColorHistogram::Merge(const ColorHistogram &other) {
+  other.ForEachColor([this](unsigned int rgb, unsigned int count) { Add(rgb, count); });
+}
+
+// Double capacity of hash table, or switch to flat array when having many distinct colors
+void ColorHistogram::Grow() {
+  if (amount_colors > kMaxSparseColors) {
+    ConvertToDense();
+    return;
+  }
+
+  std::vector<unsigned int> keys;
+  std::vector<unsigned int> counts;
+  keys.swap(sparse_keys);
+  counts.swap(sparse_counts);
+
+  sparse_keys.assign(keys.size()*2, static_cast<unsigned int>(kEmptyKey));
+  sparse_counts.assign(keys.size()*2, 0);
+  --hash_shift;
+  amount_colors = 0;
+
+  for (unsigned long index = 0; index < keys.size(); ++index) {
+    if (keys[index]!=kEmptyKey) Add(keys[index], counts[index]);
+  }
+}
+
+void ColorHistogram::ConvertToDense() {
+  dense_counts.assign(kAmountRgbColors, 0);
+
+  for (unsigned long index = 0; index < sparse_keys.size(); ++index) {
+    if (sparse_keys[index]!=kEmptyKey) dense_counts[sparse_keys[index]] += sparse_counts[index];
+  }
+
+  std::vector<unsigned int>().swap(sparse_keys);
+  std::vector<unsigned int>().swap(sparse_counts);
+}
+
+template<typename Visitor>
+void ColorHistogram::ForEachColor(Visitor visitor) const {
+  if (!dense_counts.empty()) {
+    for (unsigned int rgb = 0; rgb < kAmountRgbColors; ++rgb) {
+      if (dense_counts[rgb]) visitor(rgb, dense_counts[rgb]);
+    }
+    return;
+  }
+
+  for (unsigned long index = 0; index < sparse_keys.size(); ++index) {
+    if (sparse_keys[index]!=kEmptyKey) visitor(sparse_keys[index], sparse_counts[index]);
+  }
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> ColorHistogram::GetMostCommon(unsigned short amount) const {
+  typedef std::pair<unsigned int, unsigned int> color_count;
+
+  std::vector<color_count> colors;
+  ForEachColor([&colors](unsigned int rgb, unsigned int count) { colors.emplace_back(rgb, count); });
+
+  const std::vector<unsigned int> &ranks = GetFormattedOrderRanks();
+  auto formatted_order_key = [&ranks](unsigned int rgb) -> unsigned int {
+    return (ranks[(rgb >> 16) & 0xff] << 16) | (ranks[(rgb >> 8) & 0xff] << 8) | ranks[rgb & 0xff];
+  };
+
+  auto is_more_common = [&formatted_order_key](const color_count &color_1, const color_count &color_2) -> bool {
+    if (color_1.second!=color_2.second) return color_1.second > color_2.second;
+
+    return formatted_order_key(color_1.first) < formatted_order_key(color_2.first);
+  };
+
+  if (amount > colors.size()) amount = static_cast<unsigned short>(colors.size());
+  std::partial_sort(colors.begin(), colors.begin() + amount, colors.end(), is_more_common);
+  colors.resize(amount);
+
+  return colors;
+}
+
+// Get rank of every channel value 0..255 within the lexicographic order of their decimal strings ("0", "1", "10", ..),
+// so comparing colors by their ranks equals comparing their formatted "r,g,b" strings
+const std::vector<unsigned int> &ColorHistogram::GetFormattedOrderRanks() {
+  static const std::vector<unsigned int> ranks = []() {
+    std::vector<std::string> values;
+    for (unsigned int value = 0; value < 256; ++value) values.push_back(std::to_string(value));
+    std::sort(values.begin(), values.end());
+
+    std::vector<unsigned int> value_ranks(256);
+    for (unsigned int rank = 0; rank < 256; ++rank) value_ranks[std::stoul(values[rank])] = rank;
+
+    return value_ranks;
+  }();
+
+  return ranks;
+}
+
+std::string ColorHistogram::FormatRgb(unsigned int rgb) {
+  return std::to_string((rgb >> 16) & 0xff) + "," + std::to_string((rgb >> 8) & 0xff) + "," + std::to_string(rgb & 0xff);
+}
+
+} // namespace pixloc
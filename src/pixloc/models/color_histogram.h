@@ -0,0 +1,108 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_COLOR_HISTOGRAM
+#define CLASS_PIXLOC_COLOR_HISTOGRAM
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pixloc {
+
+// Amount of pixels per packed 0xRRGGBB color.
+// Starts as small open-addressing hash table, switches to a flat counting array over all 2^24 colors once
+// the amount of distinct colors makes hashing more expensive than the array
+class ColorHistogram {
+
+ public:
+  // Constructor
+  ColorHistogram();
+
+  // Count given amount of pixels of given color
+  inline void Add(unsigned int rgb, unsigned int amount = 1) {
+    if (!dense_counts.empty()) {
+      dense_counts[rgb] += amount;
+      return;
+    }
+
+    unsigned long index = Hash(rgb);
+    while (true) {
+      if (sparse_keys[index]==rgb) {
+        sparse_counts[index] += amount;
+        return;
+      }
+      if (sparse_keys[index]==kEmptyKey) break;
+
+      index = (index + 1) & (sparse_keys.size() - 1);
+    }
+
+    sparse_keys[index] = rgb;
+    sparse_counts[index] = amount;
+    if (++amount_colors*2 > sparse_keys.size()) Grow();
+  }
+
+  // Count all pixels of given row of packed 0xRRGGBB values, runs of same color are counted at once
+  void AddRow(const unsigned int *rgb_row, unsigned short width);
+
+  void Merge(const ColorHistogram &other);
+
+  // Get given amount of most common colors w/ their amount of pixels, most common first.
+  // Ties are ordered like their formatted "r,g,b" strings
+  std::vector<std::pair<unsigned int, unsigned int>> GetMostCommon(unsigned short amount) const;
+
+  static std::string FormatRgb(unsigned int rgb);
+
+ private:
+  static const unsigned int kEmptyKey = 0xffffffff;
+  static const unsigned long kInitialSparseCapacity = 256;
+  static const unsigned long kMaxSparseColors = 1UL << 18;
+  static const unsigned long kAmountRgbColors = 1UL << 24;
+
+  unsigned long amount_colors;
+  unsigned short hash_shift;
+
+  std::vector<unsigned int> sparse_keys;
+  std::vector<unsigned int> sparse_counts;
+  std::vector<unsigned int> dense_counts;
+
+  inline unsigned long Hash(unsigned int rgb) const { return (rgb*2654435761u) >> hash_shift; }
+
+  void Grow();
+  void ConvertToDense();
+
+  static const std::vector<unsigned int> &GetFormattedOrderRanks();
+
+  template<typename Visitor>
+  void ForEachColor(Visitor visitor) const;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_COLOR_HISTOGRAM
@@ -27,7 +27,18 @@
   POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PIXLOC_HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
 #include "color_matcher.h"
+#include "pixloc/models/bitmask.h"
 
 namespace pixloc {
 
@@ -35,16 +46,52 @@ namespace pixloc {
 ColorMatcher::ColorMatcher(unsigned short find_red,
                            unsigned short find_green,
                            unsigned short find_blue,
-                           unsigned short tolerance) {
-  // @todo test needed minimum tolerance for color values (that are a multiple of 256)
-//  if (tolerance == 0) tolerance = 128;
+                           unsigned short tolerance)
+    : ColorMatcher(find_red, find_green, find_blue, ColorTolerance(tolerance)) {}
+
+// Constructor
+ColorMatcher::ColorMatcher(unsigned short find_red,
+                           unsigned short find_green,
+                           unsigned short find_blue,
+                           const ColorTolerance &tolerance)
+    : ColorMatcher(std::vector<MatchColor>{MatchColor(find_red, find_green, find_blue, tolerance)}) {}
+
+// Constructor
+ColorMatcher::ColorMatcher(const std::vector<MatchColor> &colors) {
+  this->colors = colors;
+
+  if (colors.size()==1 && colors[0].tolerance.distance==ColorTolerance::kDistanceChannel) {
+    const MatchColor &color = colors[0];
+    InitChannelBounds(color.red, color.green, color.blue,
+                      color.tolerance.red, color.tolerance.green, color.tolerance.blue);
+
+    return;
+  }
+
+  // Bounds are unused by the lookup kernel
+  InitChannelBounds(0, 0, 0, 0, 0, 0);
+
+  this->lookup = BuildLookup(colors);
+  this->match_row_kernel = MatchRowLookup;
+}
 
-  this->red_min = CalculateChannelMin(find_red, tolerance);
-  this->red_max = CalculateChannelMax(find_red, tolerance);
-  this->green_min = CalculateChannelMin(find_green, tolerance);
-  this->green_max = CalculateChannelMax(find_green, tolerance);
-  this->blue_min = CalculateChannelMin(find_blue, tolerance);
-  this->blue_max = CalculateChannelMax(find_blue, tolerance);
+void ColorMatcher::InitChannelBounds(unsigned short find_red,
+                                     unsigned short find_green,
+                                     unsigned short find_blue,
+                                     unsigned short tolerance_red,
+                                     unsigned short tolerance_green,
+                                     unsigned short tolerance_blue) {
+  this->red_min = CalculateChannelMin(find_red, tolerance_red);
+  this->red_max = CalculateChannelMax(find_red, tolerance_red);
+  this->green_min = CalculateChannelMin(find_green, tolerance_green);
+  this->green_max = CalculateChannelMax(find_green, tolerance_green);
+  this->blue_min = CalculateChannelMin(find_blue, tolerance_blue);
+  this->blue_max = CalculateChannelMax(find_blue, tolerance_blue);
+
+  this->packed_min = (static_cast<unsigned int>(red_min) << 16) | (green_min << 8) | blue_min;
+  this->packed_max = (static_cast<unsigned int>(red_max) << 16) | (green_max << 8) | blue_max;
+
+  this->match_row_kernel = GetMatchRowKernel(GetBestMatchRowKernelName());
 }
 
 unsigned short ColorMatcher::CalculateChannelMin(unsigned short value, unsigned short tolerance) {
@@ -53,16 +100,346 @@ unsigned short ColorMatcher::CalculateChannelMin(unsigned short value, unsigned
 }
 
 unsigned short ColorMatcher::CalculateChannelMax(unsigned short value, unsigned short tolerance) {
-  return value + tolerance > kXColorMaxChannelValue
-         ? kXColorMaxChannelValue
+  return value + tolerance > kMaxChannelValue
+         ? kMaxChannelValue
          : value + tolerance;
 }
 
-bool ColorMatcher::Matches(unsigned short red, unsigned short green, unsigned short blue) {
-  return
-      red >= this->red_min && red <= this->red_max &&
-      green >= this->green_min && green <= this->green_max &&
-      blue >= this->blue_min && blue <= this->blue_max;
+void ColorMatcher::Lookup::Add(unsigned int rgb) {
+  uint16_t &cell = cells[((rgb >> 9) & 0x7c00) | ((rgb >> 6) & 0x3e0) | ((rgb >> 3) & 0x1f)];
+
+  if (!cell) {
+    blocks.resize(blocks.size() + 8, 0);
+    cell = static_cast<uint16_t>(blocks.size()/8);
+  }
+
+  unsigned int bit = ((rgb >> 10) & 0x1c0) | ((rgb >> 5) & 0x38) | (rgb & 7);
+
+  blocks[(cell - 1u)*8 + (bit >> 6)] |= static_cast<uint64_t>(1) << (bit & 63);
+}
+
+namespace {
+
+// CIE L*a*b* of sRGB color, D65 white point
+struct LabColor {
+  double l;
+  double a;
+  double b;
+};
+
+double LinearizeSrgb(unsigned int value) {
+  double channel = value/255.0;
+
+  return channel <= 0.04045 ? channel/12.92 : std::pow((channel + 0.055)/1.055, 2.4);
+}
+
+// Linear light of all 8-bit sRGB channel values, computed once per process
+const double *GetLinearSrgbTable() {
+  static const std::vector<double> table = []() {
+    std::vector<double> values(256);
+    for (unsigned int value = 0; value < 256; ++value) values[value] = LinearizeSrgb(value);
+
+    return values;
+  }();
+
+  return table.data();
+}
+
+double LabCompand(double value) {
+  return value > 216.0/24389.0 ? std::cbrt(value) : (24389.0/27.0*value + 16.0)/116.0;
+}
+
+LabColor RgbToLab(unsigned int rgb, const double *linear) {
+  double red = linear[(rgb >> 16) & 0xff];
+  double green = linear[(rgb >> 8) & 0xff];
+  double blue = linear[rgb & 0xff];
+
+  double x = LabCompand((0.4124564*red + 0.3575761*green + 0.1804375*blue)/0.95047);
+  double y = LabCompand(0.2126729*red + 0.7151522*green + 0.0721750*blue);
+  double z = LabCompand((0.0193339*red + 0.1191920*green + 0.9503041*blue)/1.08883);
+
+  return LabColor{116.0*y - 16.0, 500.0*(x - y), 200.0*(y - z)};
+}
+
+double GetCie76DistanceSquare(const LabColor &lab_a, const LabColor &lab_b) {
+  return (lab_a.l - lab_b.l)*(lab_a.l - lab_b.l) +
+      (lab_a.a - lab_b.a)*(lab_a.a - lab_b.a) +
+      (lab_a.b - lab_b.b)*(lab_a.b - lab_b.b);
+}
+
+// Squared "redmean" distance, divided by 9: a difference of n in every channel scores about n
+double GetWeightedDistanceSquare(unsigned int rgb_a, unsigned int rgb_b) {
+  int red_a = (rgb_a >> 16) & 0xff;
+  int red_b = (rgb_b >> 16) & 0xff;
+  int delta_red = red_a - red_b;
+  int delta_green = static_cast<int>((rgb_a >> 8) & 0xff) - static_cast<int>((rgb_b >> 8) & 0xff);
+  int delta_blue = static_cast<int>(rgb_a & 0xff) - static_cast<int>(rgb_b & 0xff);
+  double red_mean = (red_a + red_b)/2.0;
+
+  return ((2.0 + red_mean/256.0)*delta_red*delta_red +
+      4.0*delta_green*delta_green +
+      (2.0 + (255.0 - red_mean)/256.0)*delta_blue*delta_blue)/9.0;
+}
+
+int GetChannelDifference(unsigned int rgb_a, unsigned int rgb_b, unsigned int shift) {
+  return std::abs(static_cast<int>((rgb_a >> shift) & 0xff) - static_cast<int>((rgb_b >> shift) & 0xff));
+}
+
+} // namespace
+
+// Compile union of the colors matching any of given colors. The last lookup is kept, for queries repeated while
+// waiting
+std::shared_ptr<const ColorMatcher::Lookup> ColorMatcher::BuildLookup(const std::vector<MatchColor> &colors) {
+  static std::mutex mutex;
+  static std::vector<MatchColor> last_colors;
+  static std::shared_ptr<const Lookup> last_lookup;
+
+  auto lookup = std::make_shared<Lookup>();
+  lookup->cells.assign(32768, 0);
+  if (colors.empty()) return lookup;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (last_lookup && colors==last_colors) return last_lookup;
+
+  for (const auto &color : colors) AddToLookup(color, *lookup);
+
+  last_colors = colors;
+  last_lookup = lookup;
+
+  return lookup;
+}
+
+// Add colors matching given color to given lookup. Channel tolerances span a box of colors. Perceptual distances are
+// flood-filled, starting at the sought color, so distances are evaluated only for matching colors and their direct
+// neighbours, not for all 16.7M colors. This requires matching colors to form a connected region: for redmean, every
+// matching color is reached by stepping its blue, then green, then red value towards the sought one, and no such
+// step increases the distance: the weights of blue and green don't depend on their values, and the red term still
+// shrinks w/ the red difference, its weight varying only between 2 and 3. For CIE76 there is no such argument, the
+// fill was checked against all colors instead
+void ColorMatcher::AddToLookup(const MatchColor &color, Lookup &lookup) {
+  const ColorTolerance &tolerance = color.tolerance;
+
+  if (tolerance.distance==ColorTolerance::kDistanceChannel) {
+    for (unsigned int red = CalculateChannelMin(color.red, tolerance.red);
+         red <= CalculateChannelMax(color.red, tolerance.red); ++red)
+      for (unsigned int green = CalculateChannelMin(color.green, tolerance.green);
+           green <= CalculateChannelMax(color.green, tolerance.green); ++green)
+        for (unsigned int blue = CalculateChannelMin(color.blue, tolerance.blue);
+             blue <= CalculateChannelMax(color.blue, tolerance.blue); ++blue)
+          lookup.Add((red << 16) | (green << 8) | blue);
+
+    return;
+  }
+
+  const double *linear = GetLinearSrgbTable();
+  const unsigned int find_rgb = color.GetRgb();
+  const bool is_cie76 = tolerance.distance==ColorTolerance::kDistanceCie76;
+  const LabColor find_lab = RgbToLab(find_rgb, linear);
+  const double max_distance_square = static_cast<double>(tolerance.max_distance)*tolerance.max_distance;
+
+  auto matches = [&](unsigned int rgb) {
+    return is_cie76
+           ? GetCie76DistanceSquare(RgbToLab(rgb, linear), find_lab) <= max_distance_square
+           : GetWeightedDistanceSquare(rgb, find_rgb) <= max_distance_square;
+  };
+
+  std::vector<uint64_t> visited((1 << 24)/64, 0);
+  std::vector<unsigned int> pending;
+
+  visited[find_rgb >> 6] |= static_cast<uint64_t>(1) << (find_rgb & 63);
+  pending.push_back(find_rgb);
+
+  while (!pending.empty()) {
+    unsigned int rgb = pending.back();
+    pending.pop_back();
+
+    lookup.Add(rgb);
+
+    for (unsigned int shift = 0; shift < 24; shift += 8) {
+      unsigned int channel = (rgb >> shift) & 0xff;
+
+      for (int direction = -1; direction <= 1; direction += 2) {
+        if ((direction < 0 && channel==0) || (direction > 0 && channel==kMaxChannelValue)) continue;
+
+        unsigned int neighbour = direction < 0 ? rgb - (1u << shift) : rgb + (1u << shift);
+        uint64_t &word = visited[neighbour >> 6];
+        uint64_t bit = static_cast<uint64_t>(1) << (neighbour & 63);
+
+        if (word & bit) continue;
+
+        word |= bit;
+        if (matches(neighbour)) pending.push_back(neighbour);
+      }
+    }
+  }
+}
+
+bool ColorMatcher::IsWithinTolerance(const MatchColor &color, unsigned int rgb) {
+  const ColorTolerance &tolerance = color.tolerance;
+  const unsigned int find_rgb = color.GetRgb();
+  const double max_distance_square = static_cast<double>(tolerance.max_distance)*tolerance.max_distance;
+
+  if (tolerance.distance==ColorTolerance::kDistanceWeighted)
+    return GetWeightedDistanceSquare(rgb, find_rgb) <= max_distance_square;
+
+  if (tolerance.distance==ColorTolerance::kDistanceCie76) {
+    const double *linear = GetLinearSrgbTable();
+
+    return GetCie76DistanceSquare(RgbToLab(rgb, linear), RgbToLab(find_rgb, linear)) <= max_distance_square;
+  }
+
+  return GetChannelDifference(rgb, find_rgb, 16) <= tolerance.red &&
+      GetChannelDifference(rgb, find_rgb, 8) <= tolerance.green &&
+      GetChannelDifference(rgb, find_rgb, 0) <= tolerance.blue;
+}
+
+int ColorMatcher::GetIndexOfMatchingColor(unsigned int rgb) const {
+  for (unsigned int index = 0; index < colors.size(); ++index) {
+    if (IsWithinTolerance(colors[index], rgb)) return static_cast<int>(index);
+  }
+
+  return -1;
+}
+
+const char *ColorMatcher::GetKernelName() const {
+  return lookup ? "lookup" : GetBestMatchRowKernelName();
+}
+
+int ColorMatcher::FindFirstMatch(const unsigned int *rgb_row, unsigned short width) const {
+  uint64_t bitmap[4];
+
+  // Classify in chunks of 256 pixels, to stop early on matches near the start of long rows
+  for (unsigned short offset = 0; offset < width; offset += 256) {
+    auto amount_pixels = static_cast<unsigned short>(width - offset < 256 ? width - offset : 256);
+    MatchRow(rgb_row + offset, amount_pixels, bitmap);
+
+    for (unsigned short index_word = 0; index_word < Bitmask::GetAmountWords(amount_pixels); ++index_word) {
+      if (bitmap[index_word]) return offset + index_word*64 + __builtin_ctzll(bitmap[index_word]);
+    }
+  }
+
+  return -1;
+}
+
+// Scalar reference kernel
+void ColorMatcher::MatchRowScalar(const ColorMatcher &matcher,
+                                  const unsigned int *rgb_row,
+                                  unsigned short width,
+                                  uint64_t *bitmap) {
+  memset(bitmap, 0, Bitmask::GetAmountWords(width)*sizeof(uint64_t));
+
+  for (unsigned short x = 0; x < width; ++x) {
+    if (matcher.Matches(rgb_row[x])) bitmap[x >> 6] |= static_cast<uint64_t>(1) << (x & 63);
+  }
+}
+
+// Lookup kernel, used for perceptual distances
+void ColorMatcher::MatchRowLookup(const ColorMatcher &matcher,
+                                  const unsigned int *rgb_row,
+                                  unsigned short width,
+                                  uint64_t *bitmap) {
+  const Lookup &lookup = *matcher.lookup;
+
+  memset(bitmap, 0, Bitmask::GetAmountWords(width)*sizeof(uint64_t));
+
+  for (unsigned short x = 0; x < width; ++x) {
+    if (lookup.Contains(rgb_row[x])) bitmap[x >> 6] |= static_cast<uint64_t>(1) << (x & 63);
+  }
+}
+
+#ifdef PIXLOC_HAS_X86_KERNELS
+
+// Per byte: min <= value <= max, via unsigned byte min/max. A pixel matches if all 4 of its bytes are within range,
+// the unused high byte is 0 in values and bounds
+__attribute__((target("sse2")))
+void ColorMatcher::MatchRowSse2(const ColorMatcher &matcher,
+                                const unsigned int *rgb_row,
+                                unsigned short width,
+                                uint64_t *bitmap) {
+  const __m128i min = _mm_set1_epi32(static_cast<int>(matcher.packed_min));
+  const __m128i max = _mm_set1_epi32(static_cast<int>(matcher.packed_max));
+  const __m128i all_set = _mm_set1_epi32(-1);
+
+  memset(bitmap, 0, Bitmask::GetAmountWords(width)*sizeof(uint64_t));
+
+  unsigned short x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb_row + x));
+    __m128i in_range = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(pixels, min), pixels),
+                                     _mm_cmpeq_epi8(_mm_min_epu8(pixels, max), pixels));
+    auto bits = static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(in_range, all_set))));
+
+    bitmap[x >> 6] |= bits << (x & 63);
+  }
+
+  for (; x < width; ++x) {
+    if (matcher.Matches(rgb_row[x])) bitmap[x >> 6] |= static_cast<uint64_t>(1) << (x & 63);
+  }
+}
+
+__attribute__((target("avx2")))
+void ColorMatcher::MatchRowAvx2(const ColorMatcher &matcher,
+                                const unsigned int *rgb_row,
+                                unsigned short width,
+                                uint64_t *bitmap) {
+  const __m256i min = _mm256_set1_epi32(static_cast<int>(matcher.packed_min));
+  const __m256i max = _mm256_set1_epi32(static_cast<int>(matcher.packed_max));
+  const __m256i all_set = _mm256_set1_epi32(-1);
+
+  memset(bitmap, 0, Bitmask::GetAmountWords(width)*sizeof(uint64_t));
+
+  unsigned short x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rgb_row + x));
+    __m256i in_range = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(pixels, min), pixels),
+                                        _mm256_cmpeq_epi8(_mm256_min_epu8(pixels, max), pixels));
+    auto bits = static_cast<uint64_t>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(in_range, all_set))));
+
+    bitmap[x >> 6] |= bits << (x & 63);
+  }
+
+  for (; x < width; ++x) {
+    if (matcher.Matches(rgb_row[x])) bitmap[x >> 6] |= static_cast<uint64_t>(1) << (x & 63);
+  }
+}
+
+#else
+
+void ColorMatcher::MatchRowSse2(const ColorMatcher &matcher,
+                                const unsigned int *rgb_row,
+                                unsigned short width,
+                                uint64_t *bitmap) {
+  MatchRowScalar(matcher, rgb_row, width, bitmap);
+}
+
+void ColorMatcher::MatchRowAvx2(const ColorMatcher &matcher,
+                                const unsigned int *rgb_row,
+                                unsigned short width,
+                                uint64_t *bitmap) {
+  MatchRowScalar(matcher, rgb_row, width, bitmap);
+}
+
+#endif //PIXLOC_HAS_X86_KERNELS
+
+// Get kernel by name: "scalar", "sse2" or "avx2". Returns the scalar kernel for unknown names
+ColorMatcher::MatchRowKernel ColorMatcher::GetMatchRowKernel(const char *name) {
+  if (strcmp(name, "avx2")==0) return MatchRowAvx2;
+  if (strcmp(name, "sse2")==0) return MatchRowSse2;
+
+  return MatchRowScalar;
+}
+
+// Runtime CPU dispatch: detected once per process
+const char *ColorMatcher::GetBestMatchRowKernelName() {
+#ifdef PIXLOC_HAS_X86_KERNELS
+  static const char *const name = __builtin_cpu_supports("avx2")
+                                  ? "avx2"
+                                  : (__builtin_cpu_supports("sse2") ? "sse2" : "scalar");
+  return name;
+#else
+  return "scalar";
+#endif
 }
 
-} // namespace pixloc
\ No newline at end of file
+} // namespace pixloc
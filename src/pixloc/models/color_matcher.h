@@ -30,22 +30,147 @@
 #ifndef CLASS_PIXLOC_COLOR_MATCHER
 #define CLASS_PIXLOC_COLOR_MATCHER
 
-#include "color_matcher.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace pixloc {
 
+// Tolerance of matching colors: max. difference per channel, or max. perceptual distance
+struct ColorTolerance {
+  enum Distance {
+    kDistanceChannel,   // Max. difference per channel
+    kDistanceWeighted,  // Max. weighted ("redmean") RGB distance, scaled to channel units
+    kDistanceCie76      // Max. CIE76 delta E, in L*a*b* space
+  };
+
+  // Max. distance: weighted RGB and CIE76 distances of any two colors are smaller
+  static const unsigned short kMaxDistance = 500;
+
+  Distance distance = kDistanceChannel;
+
+  unsigned short red = 0;
+  unsigned short green = 0;
+  unsigned short blue = 0;
+
+  // Max. distance, if not matching by channel
+  unsigned short max_distance = 0;
+
+  ColorTolerance() = default;
+
+  // Constructor: same tolerance for all channels
+  explicit ColorTolerance(unsigned short tolerance) : red(tolerance), green(tolerance), blue(tolerance) {}
+
+  inline bool operator==(const ColorTolerance &other) const {
+    return distance==other.distance && red==other.red && green==other.green && blue==other.blue &&
+        max_distance==other.max_distance;
+  }
+};
+
+// Sought color w/ its own tolerance
+struct MatchColor {
+  unsigned short red = 0;
+  unsigned short green = 0;
+  unsigned short blue = 0;
+
+  ColorTolerance tolerance;
+
+  MatchColor() = default;
+
+  // Constructor
+  MatchColor(unsigned short red, unsigned short green, unsigned short blue, const ColorTolerance &tolerance)
+      : red(red), green(green), blue(blue), tolerance(tolerance) {}
+
+  inline unsigned int GetRgb() const { return (static_cast<unsigned int>(red) << 16) | (green << 8) | blue; }
+
+  inline bool operator==(const MatchColor &other) const {
+    return red==other.red && green==other.green && blue==other.blue && tolerance==other.tolerance;
+  }
+};
+
 class ColorMatcher {
 
  public:
-  // @see Xlib manual - https://www.x.org/releases/X11R7.7/doc/libX11/libX11/libX11.html#Color_Structures
-  static const unsigned short kXColorMaxChannelValue = 65535;
+  static const unsigned short kMaxChannelValue = 255;
+
+  // Signature of row kernels: set bit x%64 of bitmap word x/64 for every matching pixel x of given row
+  typedef void (*MatchRowKernel)(const ColorMatcher &matcher, const unsigned int *rgb_row, unsigned short width,
+                                 uint64_t *bitmap);
 
   // Constructor
   ColorMatcher(unsigned short find_red, unsigned short find_green, unsigned short find_blue, unsigned short tolerance);
 
-  bool Matches(unsigned short red, unsigned short green, unsigned short blue);
+  // Constructor: per-channel tolerances are matched via channel bounds, perceptual distances are compiled into a
+  // lookup table, so matching a pixel costs the same for every metric
+  ColorMatcher(unsigned short find_red, unsigned short find_green, unsigned short find_blue,
+               const ColorTolerance &tolerance);
+
+  // Constructor: match any of given colors. Several colors (or none) are compiled into one lookup table,
+  // pixels are classified in a single pass for all of them
+  explicit ColorMatcher(const std::vector<MatchColor> &colors);
+
+  inline bool Matches(unsigned short red, unsigned short green, unsigned short blue) const {
+    if (lookup) return lookup->Contains((static_cast<unsigned int>(red) << 16) | (green << 8) | blue);
+
+    return
+        red >= this->red_min && red <= this->red_max &&
+        green >= this->green_min && green <= this->green_max &&
+        blue >= this->blue_min && blue <= this->blue_max;
+  }
+
+  // Match packed 0xRRGGBB value, as output by PixelDecoder
+  inline bool Matches(unsigned int rgb) const {
+    if (lookup) return lookup->Contains(rgb);
+
+    return Matches(static_cast<unsigned short>((rgb >> 16) & 0xff),
+                   static_cast<unsigned short>((rgb >> 8) & 0xff),
+                   static_cast<unsigned short>(rgb & 0xff));
+  }
+
+  // Classify given row of packed 0xRRGGBB pixels into given bitmap (of GetAmountWords(width) words),
+  // using the fastest kernel supported by the CPU
+  inline void MatchRow(const unsigned int *rgb_row, unsigned short width, uint64_t *bitmap) const {
+    match_row_kernel(*this, rgb_row, width, bitmap);
+  }
+
+  // Get index of 1st matching pixel within given row, or -1 if there is none
+  int FindFirstMatch(const unsigned int *rgb_row, unsigned short width) const;
+
+  // Kernels, exposed for verification and benchmarking against the scalar reference
+  static void MatchRowScalar(const ColorMatcher &matcher, const unsigned int *rgb_row, unsigned short width,
+                             uint64_t *bitmap);
+  static MatchRowKernel GetMatchRowKernel(const char *name);
+  static const char *GetBestMatchRowKernelName();
+
+  // Name of kernel used by MatchRow(): lookup, or the best kernel matching by channel bounds
+  const char *GetKernelName() const;
+
+  // Get index of 1st of the sought colors that given packed 0xRRGGBB value matches, or -1 if there is none
+  int GetIndexOfMatchingColor(unsigned int rgb) const;
 
  private:
+  // Reads the channel bounds and lookup, to match by them in its kernels
+  friend class ScanKernel;
+
+  // Matching colors, exactly: 32768 cells of 8x8x8 colors (5 most significant bits per channel) refer to blocks
+  // of 512 bits, one per color. Cells w/o matching colors share no block
+  struct Lookup {
+    // Per cell: 0 = no matching color, else 1 + index of block
+    std::vector<uint16_t> cells;
+    std::vector<uint64_t> blocks;
+
+    inline bool Contains(unsigned int rgb) const {
+      uint16_t cell = cells[((rgb >> 9) & 0x7c00) | ((rgb >> 6) & 0x3e0) | ((rgb >> 3) & 0x1f)];
+      if (!cell) return false;
+
+      unsigned int bit = ((rgb >> 10) & 0x1c0) | ((rgb >> 5) & 0x38) | (rgb & 7);
+
+      return (blocks[(cell - 1u)*8 + (bit >> 6)] >> (bit & 63)) & 1;
+    }
+
+    void Add(unsigned int rgb);
+  };
+
   unsigned short red_min;
   unsigned short red_max;
   unsigned short green_min;
@@ -53,10 +178,35 @@ class ColorMatcher {
   unsigned short blue_min;
   unsigned short blue_max;
 
-  unsigned short CalculateChannelMin(unsigned short value, unsigned short tolerance);
-  unsigned short CalculateChannelMax(unsigned short value, unsigned short tolerance);
+  // Channel bounds packed like the pixels: 0x00RRGGBB
+  unsigned int packed_min;
+  unsigned int packed_max;
+
+  MatchRowKernel match_row_kernel;
+
+  // Shared by copies of the matcher, nullptr if matching by channel bounds
+  std::shared_ptr<const Lookup> lookup;
+
+  std::vector<MatchColor> colors;
+
+  void InitChannelBounds(unsigned short find_red, unsigned short find_green, unsigned short find_blue,
+                         unsigned short tolerance_red, unsigned short tolerance_green, unsigned short tolerance_blue);
+
+  static std::shared_ptr<const Lookup> BuildLookup(const std::vector<MatchColor> &colors);
+  static void AddToLookup(const MatchColor &color, Lookup &lookup);
+  static bool IsWithinTolerance(const MatchColor &color, unsigned int rgb);
+
+  static unsigned short CalculateChannelMin(unsigned short value, unsigned short tolerance);
+  static unsigned short CalculateChannelMax(unsigned short value, unsigned short tolerance);
+
+  static void MatchRowLookup(const ColorMatcher &matcher, const unsigned int *rgb_row, unsigned short width,
+                             uint64_t *bitmap);
+  static void MatchRowSse2(const ColorMatcher &matcher, const unsigned int *rgb_row, unsigned short width,
+                           uint64_t *bitmap);
+  static void MatchRowAvx2(const ColorMatcher &matcher, const unsigned int *rgb_row, unsigned short width,
+                           uint64_t *bitmap);
 };
 
 } // namespace pixloc
 
-#endif //PIXLOC_COLOR_MATCHER
\ No newline at end of file
+#endif //PIXLOC_COLOR_MATCHER
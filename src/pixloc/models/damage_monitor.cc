@@ -0,0 +1,120 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sys/select.h>
+#include <chrono>
+#include <thread>
+
+#include "damage_monitor.h"
+
+namespace pixloc {
+
+// Constructor
+DamageMonitor::DamageMonitor(Display *display, const Rectangle &rectangle) {
+  this->display = display;
+  this->rectangle = rectangle;
+  this->is_using_xdamage = false;
+  this->poll_interval_ms = kPollIntervalMinMs;
+
+#ifdef PIXLOC_HAS_XDAMAGE
+  this->damage = 0;
+
+  int damage_error_base;
+  if (XDamageQueryExtension(display, &damage_event_base, &damage_error_base)) {
+    damage = XDamageCreate(display, RootWindow(display, DefaultScreen(display)), XDamageReportRawRectangles);
+    XFlush(display);
+    is_using_xdamage = damage!=0;
+  }
+#endif
+}
+
+// Destructor
+DamageMonitor::~DamageMonitor() {
+#ifdef PIXLOC_HAS_XDAMAGE
+  if (damage) {
+    XDamageDestroy(display, damage);
+    XFlush(display);
+  }
+#endif
+}
+
+void DamageMonitor::Wait(long timeout_ms) {
+  if (timeout_ms <= 0) return;
+
+  if (!is_using_xdamage) {
+    // Poll w/ exponential backoff: react fast to changes right after start, spare CPU on static screens
+    Sleep(poll_interval_ms < timeout_ms ? poll_interval_ms : timeout_ms);
+    poll_interval_ms = poll_interval_ms*2 > kPollIntervalMaxMs ? kPollIntervalMaxMs : poll_interval_ms*2;
+    return;
+  }
+
+#ifdef PIXLOC_HAS_XDAMAGE
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  int connection = ConnectionNumber(display);
+
+  while (!HasPendingDamage()) {
+    auto remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    if (remaining_ms <= 0) return;
+
+    fd_set file_descriptors;
+    FD_ZERO(&file_descriptors);
+    FD_SET(connection, &file_descriptors);
+    struct timeval timeout{};
+    timeout.tv_sec = static_cast<time_t>(remaining_ms/1000);
+    timeout.tv_usec = static_cast<suseconds_t>((remaining_ms%1000)*1000);
+
+    select(connection + 1, &file_descriptors, nullptr, nullptr, &timeout);
+  }
+#endif
+}
+
+#ifdef PIXLOC_HAS_XDAMAGE
+bool DamageMonitor::HasPendingDamage() {
+  bool is_damaged = false;
+
+  while (XPending(display)) {
+    XEvent event;
+    XNextEvent(display, &event);
+    if (event.type!=damage_event_base + XDamageNotify) continue;
+
+    auto *damage_event = reinterpret_cast<XDamageNotifyEvent *>(&event);
+    Rectangle area(damage_event->area.x, damage_event->area.y, damage_event->area.width, damage_event->area.height);
+    if (area.Intersects(rectangle)) is_damaged = true;
+  }
+
+  return is_damaged;
+}
+#endif
+
+void DamageMonitor::Sleep(long duration_ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+}
+
+} // namespace pixloc
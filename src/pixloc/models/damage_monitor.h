@@ -0,0 +1,80 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_DAMAGE_MONITOR
+#define CLASS_PIXLOC_DAMAGE_MONITOR
+
+#include <X11/Xlib.h>
+
+#ifdef PIXLOC_HAS_XDAMAGE
+#include <X11/extensions/Xdamage.h>
+#endif
+
+#include "pixloc/models/rectangle.h"
+
+namespace pixloc {
+
+// Wait for changes of the screen content within a rectangle.
+// Uses XDamage events on the root window if available, adaptive polling w/ backoff otherwise
+class DamageMonitor {
+
+ public:
+  // Constructor
+  DamageMonitor(Display *display, const Rectangle &rectangle);
+
+  // Block until the rectangle was (possibly) damaged or given amount of milliseconds passed
+  void Wait(long timeout_ms);
+
+  bool IsUsingXDamage() const { return is_using_xdamage; }
+
+  virtual ~DamageMonitor();
+
+ private:
+  static const long kPollIntervalMinMs = 5;
+  static const long kPollIntervalMaxMs = 100;
+
+  Display *display;
+  Rectangle rectangle;
+  bool is_using_xdamage;
+  long poll_interval_ms;
+
+#ifdef PIXLOC_HAS_XDAMAGE
+  Damage damage;
+  int damage_event_base;
+
+  // Consume pending events, return whether any damaged area overlaps the rectangle
+  bool HasPendingDamage();
+#endif
+
+  void Sleep(long duration_ms);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_DAMAGE_MONITOR
@@ -0,0 +1,239 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+
+#include "fingerprint.h"
+
+namespace pixloc {
+
+namespace {
+
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t RotateLeft(uint64_t value, unsigned int amount) {
+  return (value << amount) | (value >> (64 - amount));
+}
+
+// Read 64 resp. 32 bits in host byte order (little-endian on the x86 machines pixloc runs on)
+inline uint64_t Read64(const unsigned char *data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+
+  return value;
+}
+
+inline uint32_t Read32(const unsigned char *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+
+  return value;
+}
+
+inline uint64_t Round(uint64_t accumulator, uint64_t input) {
+  return RotateLeft(accumulator + input*kPrime2, 31)*kPrime1;
+}
+
+inline uint64_t MergeRound(uint64_t hash, uint64_t accumulator) {
+  return (hash ^ Round(0, accumulator))*kPrime1 + kPrime4;
+}
+
+} // namespace
+
+// Constructor
+Fingerprint::Fingerprint(Kind kind, unsigned short width, unsigned short height) {
+  this->kind = kind;
+  this->width = width;
+  this->height = height;
+  this->index_row = 0;
+
+  // Seeded w/ the size, so equal pixels wrapped into different rectangles differ
+  uint64_t seed = (static_cast<uint64_t>(width) << 16) | height;
+  this->accumulators[0] = seed + kPrime1 + kPrime2;
+  this->accumulators[1] = seed + kPrime2;
+  this->accumulators[2] = seed;
+  this->accumulators[3] = seed - kPrime1;
+  this->amount_bytes = 0;
+  this->amount_pending = 0;
+
+  memset(this->luminance_sums, 0, sizeof(this->luminance_sums));
+  if (kind==kKindPerceptual) {
+    this->columns.resize(width);
+    for (unsigned long x = 0; x < width; ++x) this->columns[x] = static_cast<unsigned char>(x*kGridSize/width);
+  }
+}
+
+void Fingerprint::AddRow(const unsigned int *rgb_row) {
+  if (index_row >= height) return;
+
+  if (kind==kKindPerceptual)
+    AddLuminance(rgb_row);
+  else
+    AddBytes(reinterpret_cast<const unsigned char *>(rgb_row), width*sizeof(unsigned int));
+
+  ++index_row;
+}
+
+void Fingerprint::AddBytes(const unsigned char *data, unsigned long length) {
+  amount_bytes += length;
+
+  if (amount_pending > 0) {
+    unsigned long amount = kStripeSize - amount_pending < length ? kStripeSize - amount_pending : length;
+    memcpy(pending + amount_pending, data, amount);
+    amount_pending += amount;
+    data += amount;
+    length -= amount;
+
+    if (amount_pending < kStripeSize) return;
+
+    for (int lane = 0; lane < 4; ++lane) accumulators[lane] = Round(accumulators[lane], Read64(pending + lane*8));
+    amount_pending = 0;
+  }
+
+  // Independent accumulators, so consecutive rounds can run in parallel
+  uint64_t accumulator_1 = accumulators[0], accumulator_2 = accumulators[1],
+      accumulator_3 = accumulators[2], accumulator_4 = accumulators[3];
+
+  for (; length >= kStripeSize; data += kStripeSize, length -= kStripeSize) {
+    accumulator_1 = Round(accumulator_1, Read64(data));
+    accumulator_2 = Round(accumulator_2, Read64(data + 8));
+    accumulator_3 = Round(accumulator_3, Read64(data + 16));
+    accumulator_4 = Round(accumulator_4, Read64(data + 24));
+  }
+
+  accumulators[0] = accumulator_1;
+  accumulators[1] = accumulator_2;
+  accumulators[2] = accumulator_3;
+  accumulators[3] = accumulator_4;
+
+  memcpy(pending, data, length);
+  amount_pending = length;
+}
+
+void Fingerprint::AddLuminance(const unsigned int *rgb_row) {
+  uint64_t *sums = luminance_sums + static_cast<unsigned long>(index_row)*kGridSize/height*kGridSize;
+
+  for (unsigned short x = 0; x < width; ++x) {
+    unsigned int rgb = rgb_row[x];
+    // Luminance (ITU-R BT.601), scaled by 256
+    sums[columns[x]] += 77*(rgb >> 16) + 150*((rgb >> 8) & 0xff) + 29*(rgb & 0xff);
+  }
+}
+
+uint64_t Fingerprint::GetValue() const {
+  return kind==kKindPerceptual ? GetPerceptualHash() : GetHash();
+}
+
+uint64_t Fingerprint::GetHash() const {
+  uint64_t hash;
+
+  if (amount_bytes >= kStripeSize) {
+    hash = RotateLeft(accumulators[0], 1) + RotateLeft(accumulators[1], 7) +
+        RotateLeft(accumulators[2], 12) + RotateLeft(accumulators[3], 18);
+    for (auto accumulator : accumulators) hash = MergeRound(hash, accumulator);
+  } else {
+    // accumulators[2] holds the seed until a stripe was consumed
+    hash = accumulators[2] + kPrime5;
+  }
+
+  hash += amount_bytes;
+
+  const unsigned char *data = pending;
+  unsigned long length = amount_pending;
+
+  for (; length >= 8; data += 8, length -= 8) hash = RotateLeft(hash ^ Round(0, Read64(data)), 27)*kPrime1 + kPrime4;
+  if (length >= 4) {
+    hash = RotateLeft(hash ^ (Read32(data)*kPrime1), 23)*kPrime2 + kPrime3;
+    data += 4;
+    length -= 4;
+  }
+  for (; length > 0; ++data, --length) hash = RotateLeft(hash ^ (*data*kPrime5), 11)*kPrime1;
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+
+  return hash;
+}
+
+uint64_t Fingerprint::GetPerceptualHash() const {
+  unsigned long widths[kGridSize] = {0}, heights[kGridSize] = {0};
+  for (unsigned long x = 0; x < width; ++x) ++widths[columns[x]];
+  for (unsigned long y = 0; y < height; ++y) ++heights[y*kGridSize/height];
+
+  uint64_t total_sum = 0;
+  for (auto sum : luminance_sums) total_sum += sum;
+  double mean = static_cast<double>(total_sum)/(static_cast<double>(width)*height);
+
+  uint64_t hash = 0;
+  for (unsigned int index_cell = 0; index_cell < kGridSize*kGridSize; ++index_cell) {
+    unsigned long amount_pixels = widths[index_cell%kGridSize]*heights[index_cell/kGridSize];
+
+    // Rectangles narrower or lower than the grid leave cells w/o pixels
+    if (amount_pixels > 0 && static_cast<double>(luminance_sums[index_cell])/amount_pixels > mean)
+      hash |= 1ULL << index_cell;
+  }
+
+  return hash;
+}
+
+std::string Fingerprint::Format(uint64_t fingerprint) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  std::string text(16, '0');
+
+  for (int index = 15; index >= 0; --index, fingerprint >>= 4) text[index] = kHexDigits[fingerprint & 0xf];
+
+  return text;
+}
+
+bool Fingerprint::Parse(const std::string &text, uint64_t &fingerprint) {
+  if (text.length()!=16) return false;
+
+  fingerprint = 0;
+  for (char digit : text) {
+    if (digit >= '0' && digit <= '9') fingerprint = (fingerprint << 4) | static_cast<uint64_t>(digit - '0');
+    else if (digit >= 'a' && digit <= 'f') fingerprint = (fingerprint << 4) | static_cast<uint64_t>(digit - 'a' + 10);
+    else if (digit >= 'A' && digit <= 'F') fingerprint = (fingerprint << 4) | static_cast<uint64_t>(digit - 'A' + 10);
+    else return false;
+  }
+
+  return true;
+}
+
+unsigned short Fingerprint::CountDifferingBits(uint64_t fingerprint_1, uint64_t fingerprint_2) {
+  return static_cast<unsigned short>(__builtin_popcountll(fingerprint_1 ^ fingerprint_2));
+}
+
+} // namespace pixloc
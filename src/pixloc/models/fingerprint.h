@@ -0,0 +1,97 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_FINGERPRINT
+#define CLASS_PIXLOC_FINGERPRINT
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pixloc {
+
+// 64-bit hash of the pixels of a rectangle, fed row by row w/ decoded packed 0xRRGGBB values.
+// Exact fingerprints are the XXH64 hash of the rows, perceptual fingerprints the "average hash" of a grid of 8x8 cells:
+// a bit per cell, set if the cell's mean luminance is above the rectangle's, so slight noise within cells
+// (e.g. anti-aliasing) changes no or only a few bits
+class Fingerprint {
+
+ public:
+  enum Kind {
+    kKindExact,
+    kKindPerceptual
+  };
+
+  // Constructor: fingerprint of a rectangle of given size
+  Fingerprint(Kind kind, unsigned short width, unsigned short height);
+
+  // Add next row, rows are added top-down
+  void AddRow(const unsigned int *rgb_row);
+
+  uint64_t GetValue() const;
+
+  // Format given fingerprint as 16 hex digits
+  static std::string Format(uint64_t fingerprint);
+
+  // Parse fingerprint of 16 hex digits, returns false if given text is no fingerprint
+  static bool Parse(const std::string &text, uint64_t &fingerprint);
+
+  static unsigned short CountDifferingBits(uint64_t fingerprint_1, uint64_t fingerprint_2);
+
+ private:
+  static const unsigned short kGridSize = 8;
+  // Bytes per stripe of the XXH64 hash, consumed by 4 independent accumulators
+  static const unsigned long kStripeSize = 32;
+
+  Kind kind;
+
+  unsigned short width;
+  unsigned short height;
+  unsigned short index_row;
+
+  // XXH64 state: accumulators, total amount of bytes added, bytes not filling a stripe yet
+  uint64_t accumulators[4];
+  uint64_t amount_bytes;
+  unsigned char pending[kStripeSize];
+  unsigned long amount_pending;
+
+  // Perceptual fingerprint: grid column of every pixel of a row, sums of luminance of the grid's cells
+  std::vector<unsigned char> columns;
+  uint64_t luminance_sums[kGridSize*kGridSize];
+
+  void AddBytes(const unsigned char *data, unsigned long length);
+  void AddLuminance(const unsigned int *rgb_row);
+
+  uint64_t GetHash() const;
+  uint64_t GetPerceptualHash() const;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_FINGERPRINT
@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_FRAME
+#define CLASS_PIXLOC_FRAME
+
+#include <X11/Xlib.h>
+
+namespace pixloc {
+
+// Typed view onto the pixel memory of a captured ZPixmap image: rows of raw pixel values
+struct Frame {
+  const unsigned char *data = nullptr;
+
+  unsigned short width = 0;
+  unsigned short height = 0;
+
+  // Bytes per row, incl. padding
+  unsigned int stride = 0;
+  unsigned short bits_per_pixel = 0;
+  // Byte order of multi-byte pixel values: least significant byte first?
+  bool is_lsb_first = true;
+
+  Frame() = default;
+
+  explicit Frame(const XImage *image) {
+    data = reinterpret_cast<const unsigned char *>(image->data);
+    width = static_cast<unsigned short>(image->width);
+    height = static_cast<unsigned short>(image->height);
+    stride = static_cast<unsigned int>(image->bytes_per_line);
+    bits_per_pixel = static_cast<unsigned short>(image->bits_per_pixel);
+    is_lsb_first = image->byte_order==LSBFirst;
+  }
+
+  inline const unsigned char *Row(unsigned short y) const { return data + static_cast<unsigned long>(y)*stride; }
+
+  // Read raw value of pixel at given address within a row of given bits per pixel and byte order
+  static inline unsigned long ReadPixel(const unsigned char *p, unsigned short bits_per_pixel, bool is_lsb_first) {
+    switch (bits_per_pixel) {
+      case 32:
+        return is_lsb_first
+               ? static_cast<unsigned long>(p[0] | (p[1] << 8) | (p[2] << 16)) | (static_cast<unsigned long>(p[3]) << 24)
+               : static_cast<unsigned long>(p[3] | (p[2] << 8) | (p[1] << 16)) | (static_cast<unsigned long>(p[0]) << 24);
+      case 24:
+        return static_cast<unsigned long>(is_lsb_first
+                                          ? p[0] | (p[1] << 8) | (p[2] << 16)
+                                          : p[2] | (p[1] << 8) | (p[0] << 16));
+      case 16:return static_cast<unsigned long>(is_lsb_first ? p[0] | (p[1] << 8) : p[1] | (p[0] << 8));
+      case 8:return p[0];
+      default:return 0;
+    }
+  }
+
+  // Get view onto given sub-rectangle of this frame, sharing its pixel memory
+  inline Frame Crop(unsigned short x, unsigned short y, unsigned short crop_width, unsigned short crop_height) const {
+    Frame cropped = *this;
+    cropped.data = Row(y) + x*(bits_per_pixel/8);
+    cropped.width = crop_width;
+    cropped.height = crop_height;
+
+    return cropped;
+  }
+
+  // Get raw pixel value at given coordinate, for random access. Whole rows are decoded via PixelDecoder::DecodeRow
+  inline unsigned long GetPixel(unsigned short x, unsigned short y) const {
+    return ReadPixel(Row(y) + x*(bits_per_pixel/8), bits_per_pixel, is_lsb_first);
+  }
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_FRAME
@@ -0,0 +1,261 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "frame_cache.h"
+
+namespace pixloc {
+
+// Constructor
+FrameCache::FrameCache(Display *display) {
+  static_assert(sizeof(Header) <= kDataOffset, "Header of cached frames must fit before their pixel data.");
+
+  this->file_descriptor = -1;
+  this->mapped_data = nullptr;
+  this->mapped_size = 0;
+  this->is_locked = false;
+
+  std::string display_name = DisplayString(display);
+  int screen = DefaultScreen(display);
+  Visual *visual = DefaultVisual(display, screen);
+
+  memset(&this->signature, 0, sizeof(this->signature));
+  this->signature.magic = kMagic;
+  this->signature.version = kVersion;
+  this->signature.display_hash = HashString(display_name);
+  this->signature.screen_width = static_cast<uint16_t>(DisplayWidth(display, screen));
+  this->signature.screen_height = static_cast<uint16_t>(DisplayHeight(display, screen));
+  this->signature.depth = static_cast<uint16_t>(DefaultDepth(display, screen));
+  this->signature.red_mask = static_cast<uint32_t>(visual->red_mask);
+  this->signature.green_mask = static_cast<uint32_t>(visual->green_mask);
+  this->signature.blue_mask = static_cast<uint32_t>(visual->blue_mask);
+
+  int file_descriptor = open(GetPath(display_name).c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+  if (file_descriptor==-1) return;
+
+  // Never share frames w/ other users
+  struct stat file_status{};
+  if (fstat(file_descriptor, &file_status)==-1 || !S_ISREG(file_status.st_mode) || file_status.st_uid!=getuid()
+      || (file_status.st_mode & 077)!=0) {
+    close(file_descriptor);
+    return;
+  }
+
+  this->file_descriptor = file_descriptor;
+}
+
+// Destructor
+FrameCache::~FrameCache() {
+  Release();
+  UnmapFile();
+  if (this->file_descriptor!=-1) close(this->file_descriptor);
+}
+
+bool FrameCache::Lookup(unsigned short x,
+                        unsigned short y,
+                        unsigned short width,
+                        unsigned short height,
+                        long max_age_ms,
+                        Frame &frame) {
+  Release();
+  if (file_descriptor==-1 || max_age_ms <= 0 || !Lock(LOCK_SH)) return false;
+
+  struct stat file_status{};
+  if (fstat(file_descriptor, &file_status)==-1 || static_cast<unsigned long>(file_status.st_size) < kDataOffset
+      || !MapFile(static_cast<unsigned long>(file_status.st_size))) {
+    Release();
+    return false;
+  }
+
+  const auto *header = reinterpret_cast<const Header *>(mapped_data);
+  uint64_t now = Now();
+
+  bool is_hit = IsMatchingSignature(*header)
+      && header->captured_ns!=0 && header->captured_ns <= now
+      && now - header->captured_ns <= static_cast<uint64_t>(max_age_ms)*1000000
+      && x >= header->x && y >= header->y
+      && x + width <= header->x + header->width && y + height <= header->y + header->height
+      && kDataOffset + static_cast<unsigned long>(header->stride)*header->height <= mapped_size;
+  if (!is_hit) {
+    Release();
+    return false;
+  }
+
+  Frame cached;
+  cached.data = mapped_data + kDataOffset;
+  cached.width = header->width;
+  cached.height = header->height;
+  cached.stride = header->stride;
+  cached.bits_per_pixel = header->bits_per_pixel;
+  cached.is_lsb_first = header->is_lsb_first!=0;
+
+  frame = cached.Crop(static_cast<unsigned short>(x - header->x), static_cast<unsigned short>(y - header->y),
+                      width, height);
+
+  return true;
+}
+
+void FrameCache::Publish(const Frame &frame, unsigned short x, unsigned short y, uint64_t captured_ns) {
+  Release();
+  // Readers scan the cached frame while holding their lock: rather skip publishing than wait for them
+  if (file_descriptor==-1 || !Lock(LOCK_EX | LOCK_NB)) return;
+
+  auto row_size = static_cast<unsigned int>(frame.width)*(frame.bits_per_pixel/8);
+  unsigned long size = kDataOffset + static_cast<unsigned long>(row_size)*frame.height;
+
+  // The file only grows: reserve its memory up-front, so writing into the mapping cannot fail on a full /dev/shm
+  struct stat file_status{};
+  if (fstat(file_descriptor, &file_status)==-1
+      || (static_cast<unsigned long>(file_status.st_size) < size
+          && posix_fallocate(file_descriptor, 0, static_cast<off_t>(size))!=0)
+      || !MapFile(static_cast<unsigned long>(file_status.st_size) < size
+                  ? size
+                  : static_cast<unsigned long>(file_status.st_size))) {
+    Release();
+    return;
+  }
+
+  auto *header = reinterpret_cast<Header *>(mapped_data);
+  // Invalid until completely written, e.g. if this process dies meanwhile
+  header->captured_ns = 0;
+
+  for (unsigned short row = 0; row < frame.height; ++row)
+    memcpy(mapped_data + kDataOffset + static_cast<unsigned long>(row)*row_size, frame.Row(row), row_size);
+
+  Header published = signature;
+  published.x = x;
+  published.y = y;
+  published.width = frame.width;
+  published.height = frame.height;
+  published.stride = row_size;
+  published.bits_per_pixel = frame.bits_per_pixel;
+  published.is_lsb_first = frame.is_lsb_first ? 1 : 0;
+  published.captured_ns = captured_ns;
+  *header = published;
+
+  Release();
+}
+
+void FrameCache::Invalidate() {
+  Release();
+  if (file_descriptor==-1 || !Lock(LOCK_EX)) return;
+
+  struct stat file_status{};
+  if (fstat(file_descriptor, &file_status)!=-1 && static_cast<unsigned long>(file_status.st_size) >= kDataOffset
+      && MapFile(static_cast<unsigned long>(file_status.st_size)))
+    reinterpret_cast<Header *>(mapped_data)->captured_ns = 0;
+
+  Release();
+}
+
+void FrameCache::Release() {
+  if (!is_locked) return;
+
+  flock(file_descriptor, LOCK_UN);
+  is_locked = false;
+}
+
+bool FrameCache::Lock(int operation) {
+  while (flock(file_descriptor, operation)==-1) {
+    if (errno!=EINTR) return false;
+  }
+
+  is_locked = true;
+
+  return true;
+}
+
+// Map given size of the file, reusing the current mapping if the file didn't change in size
+bool FrameCache::MapFile(unsigned long size) {
+  if (mapped_data && mapped_size==size) return true;
+
+  UnmapFile();
+
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+  if (data==MAP_FAILED) return false;
+
+  mapped_data = static_cast<unsigned char *>(data);
+  mapped_size = size;
+
+  return true;
+}
+
+void FrameCache::UnmapFile() {
+  if (!mapped_data) return;
+
+  munmap(mapped_data, mapped_size);
+  mapped_data = nullptr;
+  mapped_size = 0;
+}
+
+bool FrameCache::IsMatchingSignature(const Header &header) const {
+  return header.magic==signature.magic && header.version==signature.version
+      && header.display_hash==signature.display_hash
+      && header.screen_width==signature.screen_width && header.screen_height==signature.screen_height
+      && header.depth==signature.depth
+      && header.red_mask==signature.red_mask && header.green_mask==signature.green_mask
+      && header.blue_mask==signature.blue_mask;
+}
+
+// Path of the cache file of the current user and given display, e.g. /dev/shm/pixloc-frame-1000-_0
+std::string FrameCache::GetPath(const std::string &display_name) {
+  std::string path = "/dev/shm/pixloc-frame-" + std::to_string(getuid()) + "-";
+
+  for (char character : display_name)
+    path += isalnum(static_cast<unsigned char>(character)) ? character : '_';
+
+  return path;
+}
+
+// FNV-1a
+uint64_t FrameCache::HashString(const std::string &value) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char character : value) {
+    hash ^= static_cast<unsigned char>(character);
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+uint64_t FrameCache::Now() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace pixloc
@@ -0,0 +1,119 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_FRAME_CACHE
+#define CLASS_PIXLOC_FRAME_CACHE
+
+#include <X11/Xlib.h>
+#include <cstdint>
+#include <string>
+
+#include "pixloc/models/frame.h"
+
+namespace pixloc {
+
+// Frame captured by an earlier pixloc process, shared via a memory-mapped file in /dev/shm: one per user and display.
+// Holds the last published rectangle w/ its capture time, geometry and pixel format. Readers hold a shared lock on
+// the file while scanning the mapped frame, publishers an exclusive one while writing it.
+// Failing to open, lock or map the file is not an error: lookups then miss and publishing is skipped
+class FrameCache {
+
+ public:
+  // Constructor: cache of frames of the default screen of given display
+  explicit FrameCache(Display *display);
+
+  // Get frame of given rectangle, if it is covered by a cached frame captured at most max_age_ms ago.
+  // The returned frame remains valid (and the cache locked for publishing) until Release() or the next call
+  bool Lookup(unsigned short x, unsigned short y, unsigned short width, unsigned short height, long max_age_ms,
+              Frame &frame);
+
+  // Publish given frame of the rectangle at given position, captured at given steady clock time in nanoseconds.
+  // Skipped while other processes read the cache
+  void Publish(const Frame &frame, unsigned short x, unsigned short y, uint64_t captured_ns);
+
+  // Mark cached frame outdated, e.g. after the screen content changed
+  void Invalidate();
+
+  // Release frame returned by Lookup()
+  void Release();
+
+  virtual ~FrameCache();
+
+ private:
+  static const uint32_t kMagic = 0x50584643;  // "PXFC"
+  static const uint32_t kVersion = 1;
+
+  // Start of the file, followed by the pixel data at kDataOffset
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    // Steady clock time the frame was captured at, 0 = invalidated or being written
+    uint64_t captured_ns;
+    // Display, screen geometry and visual the frame was captured from
+    uint64_t display_hash;
+    uint16_t screen_width;
+    uint16_t screen_height;
+    uint16_t depth;
+    uint16_t bits_per_pixel;
+    uint32_t red_mask;
+    uint32_t green_mask;
+    uint32_t blue_mask;
+    uint32_t is_lsb_first;
+    // Cached rectangle
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    uint32_t stride;
+  };
+
+  static const unsigned long kDataOffset = 64;
+
+  int file_descriptor;
+  unsigned char *mapped_data;
+  unsigned long mapped_size;
+  bool is_locked;
+
+  // Header fields identifying the display and visual of this process, compared on lookup
+  Header signature;
+
+  static uint64_t Now();
+
+  bool Lock(int operation);
+  bool MapFile(unsigned long min_size);
+  void UnmapFile();
+  bool IsMatchingSignature(const Header &header) const;
+
+  static std::string GetPath(const std::string &display_name);
+  static uint64_t HashString(const std::string &value);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_FRAME_CACHE
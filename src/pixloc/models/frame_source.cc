@@ -0,0 +1,97 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "frame_source.h"
+#include "pixloc/helper/strings.h"
+#include "pixloc/models/image_frame_source.h"
+#include "pixloc/models/raw_frame_source.h"
+#include "pixloc/models/x_frame_source.h"
+
+namespace pixloc {
+
+namespace {
+
+bool IsValidDimension(const std::string &value) {
+  return helper::strings::IsNumeric(value) && value.length() <= 5 && helper::strings::ToInt(value, 0) <= 0xffff;
+}
+
+} // namespace
+
+FrameSource *FrameSource::Create(const std::string &input) {
+  if (input.empty() || input=="x11") return new XFrameSource();
+  if (input.compare(0, 4, "x11:")==0) return new XFrameSource(input.substr(4));
+
+  if (input.compare(0, 4, "raw:")!=0) return new ImageFrameSource(input);
+
+  // raw:<format>:<width>x<height>[:<stride>]:<path>, the path being last may contain colons
+  unsigned long offset_format_end = input.find(':', 4);
+  unsigned long offset_dimension_end =
+      offset_format_end==std::string::npos ? std::string::npos : input.find(':', offset_format_end + 1);
+  if (offset_dimension_end==std::string::npos) throw "Raw input must be given as raw:<format>:<width>x<height>:<path>.";
+
+  std::string format = input.substr(4, offset_format_end - 4);
+  std::vector<std::string> dimension =
+      helper::strings::Explode(input.substr(offset_format_end + 1, offset_dimension_end - offset_format_end - 1), 'x');
+  std::string path = input.substr(offset_dimension_end + 1);
+
+  unsigned int stride = 0;
+  unsigned long offset_stride_end = path.find(':');
+  if (offset_stride_end!=std::string::npos && offset_stride_end < 10 &&
+      helper::strings::IsNumeric(path.substr(0, offset_stride_end))) {
+    stride = static_cast<unsigned int>(helper::strings::ToInt(path.substr(0, offset_stride_end), 0));
+    path = path.substr(offset_stride_end + 1);
+  }
+
+  if (dimension.size()!=2 || !IsValidDimension(dimension[0]) || !IsValidDimension(dimension[1]))
+    throw "Raw input must be given as raw:<format>:<width>x<height>:<path>.";
+
+  return new RawFrameSource(path, format,
+                            static_cast<unsigned short>(helper::strings::ToInt(dimension[0], 0)),
+                            static_cast<unsigned short>(helper::strings::ToInt(dimension[1], 0)),
+                            stride);
+}
+
+void FrameSource::CaptureStrips(unsigned short x,
+                                unsigned short y,
+                                unsigned short width,
+                                unsigned short height,
+                                unsigned short strip_height,
+                                const StripConsumer &consume) {
+  Frame frame = Capture(x, y, width, height);
+
+  for (unsigned int strip_y = 0; strip_y < height; strip_y += strip_height) {
+    auto amount_rows = static_cast<unsigned short>(height - strip_y < strip_height ? height - strip_y : strip_height);
+
+    if (!consume(frame.Crop(0, static_cast<unsigned short>(strip_y), width, amount_rows),
+                 static_cast<unsigned short>(strip_y)))
+      return;
+  }
+}
+
+} // namespace pixloc
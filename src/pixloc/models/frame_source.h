@@ -0,0 +1,84 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_FRAME_SOURCE
+#define CLASS_PIXLOC_FRAME_SOURCE
+
+#include <X11/Xlib.h>
+#include <functional>
+#include <string>
+
+#include "pixloc/models/frame.h"
+#include "pixloc/models/pixel_decoder.h"
+
+namespace pixloc {
+
+// Interface of sources of the frames being scanned: the live screen or recorded frames
+class FrameSource {
+
+ public:
+  // Consumer of strips of a captured rectangle: gets a frame of the strip's rows and the offset of its 1st row within
+  // the rectangle. Returns false to stop capturing
+  typedef std::function<bool(const Frame &strip, unsigned short strip_y)> StripConsumer;
+
+  // Create source of given input:
+  // "x11" or empty = live screen of the default display,
+  // "raw:<format>:<width>x<height>[:<stride>]:<path>" = memory-mapped raw dump, format: rgb, bgr, rgba, bgra,
+  // any other = path of PPM, PGM or PAM file
+  static FrameSource *Create(const std::string &input);
+
+  // Capture given rectangle. The returned frame remains valid until the next capture or destruction of the source
+  virtual Frame Capture(unsigned short x, unsigned short y, unsigned short width, unsigned short height) = 0;
+
+  // Capture given rectangle in horizontal strips of given amount of rows, top-down, handing each strip to given
+  // consumer until it returns false. Default: capture the whole rectangle at once, hand it over in strips
+  virtual void CaptureStrips(unsigned short x, unsigned short y, unsigned short width, unsigned short height,
+                             unsigned short strip_height, const StripConsumer &consume);
+
+  // Decoder of the raw pixel values of captured frames
+  virtual const PixelDecoder *GetDecoder() const = 0;
+
+  // Dimension of the screen or recorded frame
+  virtual unsigned short GetWidth() const = 0;
+  virtual unsigned short GetHeight() const = 0;
+
+  // Get current mouse position, throws if the source has no mouse pointer
+  virtual void GetMousePosition(int &x, int &y) const = 0;
+
+  // Display of live sources, whose content can change while waiting. Recorded frames: nullptr
+  virtual Display *GetDisplay() const { return nullptr; }
+
+  virtual const char *GetName() const = 0;
+
+  virtual ~FrameSource() = default;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_FRAME_SOURCE
@@ -0,0 +1,179 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "image.h"
+
+namespace pixloc {
+
+namespace {
+
+// Skip whitespace and comments (# until end of line) of a Netpbm header
+void SkipHeaderSpace(const std::string &content, unsigned long &offset) {
+  while (offset < content.length()) {
+    if (content[offset]=='#') {
+      while (offset < content.length() && content[offset]!='\n') ++offset;
+    } else if (isspace(static_cast<unsigned char>(content[offset]))) {
+      ++offset;
+    } else {
+      return;
+    }
+  }
+}
+
+unsigned long ReadHeaderNumber(const std::string &content, unsigned long &offset) {
+  SkipHeaderSpace(content, offset);
+  if (offset >= content.length() || !isdigit(static_cast<unsigned char>(content[offset])))
+    throw "Invalid image header.";
+
+  unsigned long number = 0;
+  while (offset < content.length() && isdigit(static_cast<unsigned char>(content[offset]))) {
+    number = number*10 + static_cast<unsigned long>(content[offset++] - '0');
+    if (number > 0xffffff) throw "Invalid image header.";
+  }
+
+  return number;
+}
+
+} // namespace
+
+// Constructor
+Image::Image(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) throw "Failed to open image file.";
+
+  std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (content.length() < 2 || content[0]!='P') throw "Image must be a PPM, PGM or PAM file.";
+
+  char format = content[1];
+  unsigned long offset = 2;
+  unsigned long image_width = 0, image_height = 0, max_value = 0;
+  unsigned short depth;
+
+  if (format=='3' || format=='5' || format=='6') {
+    image_width = ReadHeaderNumber(content, offset);
+    image_height = ReadHeaderNumber(content, offset);
+    max_value = ReadHeaderNumber(content, offset);
+    depth = format=='5' ? 1 : 3;
+    // Single whitespace character separates header from binary samples
+    ++offset;
+  } else if (format=='7') {
+    depth = 0;
+    std::istringstream header(content.substr(offset, content.find("ENDHDR", offset) - offset));
+    std::string line;
+
+    while (std::getline(header, line)) {
+      std::istringstream tokens(line);
+      std::string key;
+      tokens >> key;
+
+      if (key=="WIDTH") tokens >> image_width;
+      else if (key=="HEIGHT") tokens >> image_height;
+      else if (key=="DEPTH") tokens >> depth;
+      else if (key=="MAXVAL") tokens >> max_value;
+    }
+
+    offset = content.find("ENDHDR", offset);
+    if (offset==std::string::npos) throw "Invalid image header.";
+    offset = content.find('\n', offset);
+    if (offset==std::string::npos) throw "Invalid image header.";
+    ++offset;
+  } else {
+    throw "Image must be a PPM, PGM or PAM file.";
+  }
+
+  if (image_width==0 || image_height==0 || image_width > 0xffff || image_height > 0xffff ||
+      max_value==0 || max_value > 0xffff || depth < 1 || depth > 4)
+    throw "Invalid image header.";
+
+  this->width = static_cast<unsigned short>(image_width);
+  this->height = static_cast<unsigned short>(image_height);
+
+  unsigned long amount_samples = image_width*image_height*depth;
+  std::vector<unsigned int> samples;
+  samples.reserve(amount_samples);
+
+  if (format=='3') {
+    while (samples.size() < amount_samples)
+      samples.push_back(static_cast<unsigned int>(ReadHeaderNumber(content, offset)));
+  } else {
+    // Binary samples: 1 byte each, or 2 bytes (most significant first) if max. value exceeds 255
+    unsigned long bytes_per_sample = max_value > 255 ? 2 : 1;
+    if (content.length() < offset + amount_samples*bytes_per_sample) throw "Image file is truncated.";
+
+    const auto *bytes = reinterpret_cast<const unsigned char *>(content.data() + offset);
+    for (unsigned long index = 0; index < amount_samples; ++index) {
+      samples.push_back(bytes_per_sample==2
+                        ? static_cast<unsigned int>((bytes[index*2] << 8) | bytes[index*2 + 1])
+                        : bytes[index]);
+    }
+  }
+
+  LoadPixels(samples, depth, static_cast<unsigned int>(max_value));
+}
+
+// Constructor
+Image::Image(unsigned short width, unsigned short height, const unsigned int *pixels) {
+  if (width==0 || height==0) throw "Image must not be empty.";
+
+  this->width = width;
+  this->height = height;
+
+  auto amount_pixels = static_cast<unsigned long>(width)*height;
+  this->pixels.assign(pixels, pixels + amount_pixels);
+  masks.assign(amount_pixels, 0x00ffffff);
+}
+
+// Convert samples of given depth: 1 = gray, 2 = gray + alpha, 3 = RGB, 4 = RGB + alpha, into 8-bit channels
+void Image::LoadPixels(const std::vector<unsigned int> &samples, unsigned short depth, unsigned int max_value) {
+  auto amount_pixels = static_cast<unsigned long>(width)*height;
+  pixels.resize(amount_pixels);
+  masks.resize(amount_pixels);
+
+  auto scale = [max_value](unsigned int sample) -> unsigned int {
+    if (sample > max_value) sample = max_value;
+    return (sample*255 + max_value/2)/max_value;
+  };
+
+  bool has_alpha = depth==2 || depth==4;
+  for (unsigned long index = 0; index < amount_pixels; ++index) {
+    const unsigned int *sample = &samples[index*depth];
+
+    pixels[index] = depth < 3
+                    ? scale(sample[0])*0x010101
+                    : (scale(sample[0]) << 16) | (scale(sample[1]) << 8) | scale(sample[2]);
+    masks[index] = !has_alpha || sample[depth - 1]*2 >= max_value ? 0x00ffffff : 0;
+  }
+}
+
+} // namespace pixloc
@@ -0,0 +1,73 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_IMAGE
+#define CLASS_PIXLOC_IMAGE
+
+#include <string>
+#include <vector>
+
+namespace pixloc {
+
+// RGB image of packed 0x00RRGGBB pixels, w/ per-pixel opacity. Loaded from Netpbm files, which need no dependencies:
+// PPM (P3, P6), PGM (P5) and PAM (P7, w/ optional alpha channel)
+class Image {
+
+ public:
+  // Constructor: load image from file at given path
+  explicit Image(const std::string &path);
+
+  // Constructor: copy given opaque pixels, e.g. a synthetic or cropped image
+  Image(unsigned short width, unsigned short height, const unsigned int *pixels);
+
+  inline unsigned short GetWidth() const { return width; }
+  inline unsigned short GetHeight() const { return height; }
+
+  inline const unsigned int *GetRow(unsigned short y) const {
+    return &pixels[static_cast<unsigned long>(y)*width];
+  }
+
+  // Per pixel: 0x00ffffff if opaque, 0 if transparent (alpha below half of max. value)
+  inline const unsigned int *GetMaskRow(unsigned short y) const {
+    return &masks[static_cast<unsigned long>(y)*width];
+  }
+
+ private:
+  unsigned short width;
+  unsigned short height;
+
+  std::vector<unsigned int> pixels;
+  std::vector<unsigned int> masks;
+
+  void LoadPixels(const std::vector<unsigned int> &samples, unsigned short depth, unsigned int max_value);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_IMAGE
@@ -0,0 +1,166 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PIXLOC_HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#include "image_needle.h"
+#include "pixloc/models/color_matcher.h"
+
+namespace pixloc {
+
+// Constructor
+ImageNeedle::ImageNeedle(const Image &image, const ColorTolerance &tolerance) {
+  this->width = image.GetWidth();
+  this->height = image.GetHeight();
+
+  for (unsigned short y = 0; y < height; ++y) {
+    pixels.insert(pixels.end(), image.GetRow(y), image.GetRow(y) + width);
+    masks.insert(masks.end(), image.GetMaskRow(y), image.GetMaskRow(y) + width);
+  }
+
+  if (tolerance.distance!=ColorTolerance::kDistanceChannel)
+    throw "Color distances are not available in find image mode.";
+
+  this->packed_tolerance = (ClampTolerance(tolerance.red) << 16) |
+      (ClampTolerance(tolerance.green) << 8) |
+      ClampTolerance(tolerance.blue);
+
+  this->match_row_kernel = GetMatchRowKernel(ColorMatcher::GetBestMatchRowKernelName());
+}
+
+unsigned int ImageNeedle::ClampTolerance(unsigned short tolerance) {
+  return tolerance > ColorMatcher::kMaxChannelValue ? ColorMatcher::kMaxChannelValue : tolerance;
+}
+
+// Scalar reference kernel
+bool ImageNeedle::MatchRowScalar(const unsigned int *haystack,
+                                 const unsigned int *needle,
+                                 const unsigned int *masks,
+                                 unsigned short width,
+                                 unsigned int packed_tolerance) {
+  for (unsigned short x = 0; x < width; ++x) {
+    if (!masks[x]) continue;
+
+    unsigned int pixel = haystack[x];
+    unsigned int needle_pixel = needle[x];
+    for (unsigned short shift = 0; shift < 24; shift += 8) {
+      int difference = static_cast<int>((pixel >> shift) & 0xff) - static_cast<int>((needle_pixel >> shift) & 0xff);
+      auto tolerance = static_cast<int>((packed_tolerance >> shift) & 0xff);
+      if (difference > tolerance || -difference > tolerance) return false;
+    }
+  }
+
+  return true;
+}
+
+#ifdef PIXLOC_HAS_X86_KERNELS
+
+// Per byte: absolute difference via two saturating subtractions, masked, minus the tolerance (saturating).
+// A chunk matches if nothing remains
+__attribute__((target("sse2")))
+bool ImageNeedle::MatchRowSse2(const unsigned int *haystack,
+                               const unsigned int *needle,
+                               const unsigned int *masks,
+                               unsigned short width,
+                               unsigned int packed_tolerance) {
+  const __m128i tolerance = _mm_set1_epi32(static_cast<int>(packed_tolerance));
+  const __m128i zero = _mm_setzero_si128();
+
+  unsigned short x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + x));
+    __m128i needle_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(needle + x));
+    __m128i difference = _mm_or_si128(_mm_subs_epu8(pixels, needle_pixels), _mm_subs_epu8(needle_pixels, pixels));
+    difference = _mm_and_si128(difference, _mm_loadu_si128(reinterpret_cast<const __m128i *>(masks + x)));
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(difference, tolerance), zero))!=0xffff) return false;
+  }
+
+  return MatchRowScalar(haystack + x, needle + x, masks + x, static_cast<unsigned short>(width - x), packed_tolerance);
+}
+
+__attribute__((target("avx2")))
+bool ImageNeedle::MatchRowAvx2(const unsigned int *haystack,
+                               const unsigned int *needle,
+                               const unsigned int *masks,
+                               unsigned short width,
+                               unsigned int packed_tolerance) {
+  const __m256i tolerance = _mm256_set1_epi32(static_cast<int>(packed_tolerance));
+  const __m256i zero = _mm256_setzero_si256();
+
+  unsigned short x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + x));
+    __m256i needle_pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(needle + x));
+    __m256i difference =
+        _mm256_or_si256(_mm256_subs_epu8(pixels, needle_pixels), _mm256_subs_epu8(needle_pixels, pixels));
+    difference = _mm256_and_si256(difference, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(masks + x)));
+
+    if (static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(difference, tolerance),
+                                                                         zero)))!=0xffffffffu)
+      return false;
+  }
+
+  return MatchRowSse2(haystack + x, needle + x, masks + x, static_cast<unsigned short>(width - x), packed_tolerance);
+}
+
+#else
+
+bool ImageNeedle::MatchRowSse2(const unsigned int *haystack,
+                               const unsigned int *needle,
+                               const unsigned int *masks,
+                               unsigned short width,
+                               unsigned int packed_tolerance) {
+  return MatchRowScalar(haystack, needle, masks, width, packed_tolerance);
+}
+
+bool ImageNeedle::MatchRowAvx2(const unsigned int *haystack,
+                               const unsigned int *needle,
+                               const unsigned int *masks,
+                               unsigned short width,
+                               unsigned int packed_tolerance) {
+  return MatchRowScalar(haystack, needle, masks, width, packed_tolerance);
+}
+
+#endif //PIXLOC_HAS_X86_KERNELS
+
+// Get kernel by name: "scalar", "sse2" or "avx2". Returns the scalar kernel for unknown names
+ImageNeedle::MatchRowKernel ImageNeedle::GetMatchRowKernel(const char *name) {
+  if (strcmp(name, "avx2")==0) return MatchRowAvx2;
+  if (strcmp(name, "sse2")==0) return MatchRowSse2;
+
+  return MatchRowScalar;
+}
+
+} // namespace pixloc
@@ -0,0 +1,90 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_IMAGE_NEEDLE
+#define CLASS_PIXLOC_IMAGE_NEEDLE
+
+#include <vector>
+
+#include "pixloc/models/color_matcher.h"
+#include "pixloc/models/image.h"
+
+namespace pixloc {
+
+// Full-color image to be found within decoded haystack rows. A pixel matches if each of its channels differs from the
+// needle's by no more than its channel's tolerance, like in ColorMatcher. Transparent needle pixels match any color
+class ImageNeedle {
+
+ public:
+  // Signature of row kernels: whether given row of needle pixels (w/ masks) matches given haystack pixels
+  typedef bool (*MatchRowKernel)(const unsigned int *haystack, const unsigned int *needle, const unsigned int *masks,
+                                 unsigned short width, unsigned int packed_tolerance);
+
+  // Constructor
+  ImageNeedle(const Image &image, const ColorTolerance &tolerance);
+
+  inline unsigned short GetWidth() const { return width; }
+  inline unsigned short GetHeight() const { return height; }
+
+  // Whether given row of the needle matches the haystack row, starting at given x offset.
+  // The kernel exits at the first mismatching chunk of pixels
+  inline bool MatchesRow(const unsigned int *haystack_row, unsigned short x, unsigned short needle_y) const {
+    unsigned long offset_row = static_cast<unsigned long>(needle_y)*width;
+
+    return match_row_kernel(haystack_row + x, &pixels[offset_row], &masks[offset_row], width, packed_tolerance);
+  }
+
+  // Kernels, exposed for verification and benchmarking against the scalar reference
+  static bool MatchRowScalar(const unsigned int *haystack, const unsigned int *needle, const unsigned int *masks,
+                             unsigned short width, unsigned int packed_tolerance);
+  static MatchRowKernel GetMatchRowKernel(const char *name);
+
+ private:
+  unsigned short width;
+  unsigned short height;
+
+  std::vector<unsigned int> pixels;
+  std::vector<unsigned int> masks;
+
+  // Tolerance per channel byte: 0x00RRGGBB
+  unsigned int packed_tolerance;
+
+  MatchRowKernel match_row_kernel;
+
+  static unsigned int ClampTolerance(unsigned short tolerance);
+
+  static bool MatchRowSse2(const unsigned int *haystack, const unsigned int *needle, const unsigned int *masks,
+                           unsigned short width, unsigned int packed_tolerance);
+  static bool MatchRowAvx2(const unsigned int *haystack, const unsigned int *needle, const unsigned int *masks,
+                           unsigned short width, unsigned int packed_tolerance);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_IMAGE_NEEDLE
@@ -0,0 +1,92 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+
+#include "output_buffer.h"
+
+namespace pixloc {
+
+// Constructor
+OutputBuffer::OutputBuffer(std::ostream &out, unsigned long capacity) : out(out) {
+  this->buffer.resize(capacity > kMinCapacity ? capacity : kMinCapacity);
+  this->size = 0;
+}
+
+// Destructor
+OutputBuffer::~OutputBuffer() {
+  Flush();
+}
+
+void OutputBuffer::Append(const char *data, unsigned long length) {
+  while (length > 0) {
+    if (size==buffer.size()) Flush();
+
+    unsigned long amount = buffer.size() - size < length ? buffer.size() - size : length;
+    memcpy(&buffer[size], data, amount);
+    size += amount;
+    data += amount;
+    length -= amount;
+  }
+}
+
+void OutputBuffer::AppendNumber(long value) {
+  char digits[24];
+  unsigned long offset = sizeof(digits);
+  bool is_negative = value < 0;
+  unsigned long remaining = is_negative ? 0UL - static_cast<unsigned long>(value) : static_cast<unsigned long>(value);
+
+  do {
+    digits[--offset] = static_cast<char>('0' + remaining%10);
+    remaining /= 10;
+  } while (remaining > 0);
+
+  if (is_negative) digits[--offset] = '-';
+
+  Append(&digits[offset], sizeof(digits) - offset);
+}
+
+void OutputBuffer::AppendRawHeader(char type, unsigned short width, unsigned short height) {
+  const char header[] = {
+      'P', 'X', 'L', type,
+      static_cast<char>(width & 0xff), static_cast<char>(width >> 8),
+      static_cast<char>(height & 0xff), static_cast<char>(height >> 8)
+  };
+
+  Append(header, sizeof(header));
+}
+
+void OutputBuffer::Flush() {
+  if (size==0) return;
+
+  out.write(buffer.data(), static_cast<std::streamsize>(size));
+  size = 0;
+}
+
+} // namespace pixloc
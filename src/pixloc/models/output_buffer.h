@@ -0,0 +1,95 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_OUTPUT_BUFFER
+#define CLASS_PIXLOC_OUTPUT_BUFFER
+
+#include <iostream>
+#include <vector>
+
+namespace pixloc {
+
+// Output collected in a large preallocated buffer and written to a stream in few large chunks, instead of formatting
+// and writing every traced pixel or row via the stream
+class OutputBuffer {
+
+ public:
+  enum Format {
+    kFormatText,   // Lines of text, as printed by pixloc by default
+    kFormatJsonl,  // A JSON object per line
+    kFormatRaw     // Header (see AppendRawHeader), followed by packed pixels or bits
+  };
+
+  // Types of raw output
+  static const char kRawTypeRgb = 'C';
+  static const char kRawTypeBitmask = 'B';
+
+  static const unsigned long kDefaultCapacity = 1 << 20;
+  // Large enough for any row of a screen, see Extend()
+  static const unsigned long kMinCapacity = 1 << 16;
+
+  // Constructor
+  explicit OutputBuffer(std::ostream &out, unsigned long capacity = kDefaultCapacity);
+
+  inline void Append(char character) {
+    if (size==buffer.size()) Flush();
+    buffer[size++] = character;
+  }
+
+  void Append(const char *data, unsigned long length);
+
+  // Reserve given amount of bytes (at most the capacity) at the end of the buffer, to be filled by the caller
+  inline char *Extend(unsigned long length) {
+    if (size + length > buffer.size()) Flush();
+    char *data = &buffer[size];
+    size += length;
+    return data;
+  }
+
+  // Append decimal digits of given value
+  void AppendNumber(long value);
+
+  // Append header of raw output: "PXL", type, width and height as 16-bit little-endian values
+  void AppendRawHeader(char type, unsigned short width, unsigned short height);
+
+  // Write buffered output into the stream
+  void Flush();
+
+  // Destructor: flushes
+  virtual ~OutputBuffer();
+
+ private:
+  std::ostream &out;
+  std::vector<char> buffer;
+  unsigned long size;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_OUTPUT_BUFFER
@@ -0,0 +1,206 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "pixel_decoder.h"
+
+namespace pixloc {
+
+// Constructor
+PixelDecoder::PixelDecoder(Display *display) {
+  Visual *visual = DefaultVisual(display, DefaultScreen(display));
+
+  this->is_palette_visual = visual->c_class!=TrueColor && visual->c_class!=DirectColor;
+
+  if (this->is_palette_visual) {
+    InitPalette(display, visual);
+  } else {
+    InitMaskedChannelTables(visual->red_mask, visual->green_mask, visual->blue_mask);
+    if (visual->c_class==DirectColor) InitDirectColorTables(display, visual);
+  }
+
+  InitLayouts();
+}
+
+// Constructor
+PixelDecoder::PixelDecoder(unsigned long red_mask, unsigned long green_mask, unsigned long blue_mask) {
+  this->is_palette_visual = false;
+
+  InitMaskedChannelTables(red_mask, green_mask, blue_mask);
+  InitLayouts();
+}
+
+// Constructor
+PixelDecoder::PixelDecoder(const std::vector<unsigned int> &palette) {
+  this->is_palette_visual = true;
+  this->palette = palette;
+
+  InitLayouts();
+}
+
+void PixelDecoder::DecodeRow(const Frame &frame, unsigned short y, unsigned int *rgb_row) const {
+  const unsigned char *row = frame.Row(y);
+  bool is_lsb_first = frame.is_lsb_first;
+
+  // Dispatch once per row, so the per-pixel loop is specialized on the layout, resp. the pixel size
+  switch (GetLayout(frame.bits_per_pixel, is_lsb_first)) {
+    case kLayoutBgrx32:DecodeRowOfLayout(Bgrx32Layout(*this, is_lsb_first), row, frame.width, rgb_row);
+      return;
+    case kLayoutBgr24:DecodeRowOfLayout(Bgr24Layout(*this, is_lsb_first), row, frame.width, rgb_row);
+      return;
+    case kLayoutRgb565:DecodeRowOfLayout(Rgb565Layout(*this, is_lsb_first), row, frame.width, rgb_row);
+      return;
+    default:break;
+  }
+
+  switch (frame.bits_per_pixel) {
+    case 32:DecodeRowOfLayout(MaskedLayout<32>(*this, is_lsb_first), row, frame.width, rgb_row);
+      break;
+    case 24:DecodeRowOfLayout(MaskedLayout<24>(*this, is_lsb_first), row, frame.width, rgb_row);
+      break;
+    case 16:DecodeRowOfLayout(MaskedLayout<16>(*this, is_lsb_first), row, frame.width, rgb_row);
+      break;
+    case 8:DecodeRowOfLayout(MaskedLayout<8>(*this, is_lsb_first), row, frame.width, rgb_row);
+      break;
+    default:
+      for (unsigned short x = 0; x < frame.width; ++x) rgb_row[x] = 0;
+  }
+}
+
+PixelDecoder::Layout PixelDecoder::GetLayout(unsigned short bits_per_pixel, bool is_lsb_first) const {
+  if (!is_lsb_first) return kLayoutMasked;
+
+  if (is_bgr_888) {
+    if (bits_per_pixel==32) return kLayoutBgrx32;
+    if (bits_per_pixel==24) return kLayoutBgr24;
+  }
+
+  return bits_per_pixel==16 && !rgb565_table.empty() ? kLayoutRgb565 : kLayoutMasked;
+}
+
+// Detect visuals of dedicated layouts, once the channel tables are final
+void PixelDecoder::InitLayouts() {
+  this->is_bgr_888 = false;
+  if (is_palette_visual) return;
+
+  if (red_mask==0xff0000 && green_mask==0x00ff00 && blue_mask==0x0000ff) {
+    // DirectColor colormaps can remap channel values
+    bool is_unchanged = true;
+    for (unsigned int value = 0; value < 256 && is_unchanged; ++value)
+      is_unchanged = Decode((value << 16) | (value << 8) | value)==((value << 16) | (value << 8) | value);
+
+    this->is_bgr_888 = is_unchanged;
+  } else if (red_mask==0xf800 && green_mask==0x07e0 && blue_mask==0x001f) {
+    this->rgb565_table.resize(1 << 16);
+    for (unsigned long pixel = 0; pixel < rgb565_table.size(); ++pixel) rgb565_table[pixel] = Decode(pixel);
+  }
+}
+
+// Resolve right-shift and amount of bits of given channel mask, e.g. 0xff0000 => shift 16, 8 bits
+void PixelDecoder::ResolveMask(unsigned long mask, unsigned short &shift, unsigned short &bits) {
+  shift = 0;
+  bits = 0;
+  if (mask==0) return;
+
+  while (!(mask & 1)) {
+    mask >>= 1;
+    ++shift;
+  }
+  while (mask & 1) {
+    mask >>= 1;
+    ++bits;
+  }
+
+  if (bits > kMaxChannelBits) {
+    shift += bits - kMaxChannelBits;
+    bits = kMaxChannelBits;
+  }
+}
+
+// Fill table w/ linearly scaled 8-bit channel values, for TrueColor visuals
+void PixelDecoder::InitScaledTable(std::vector<unsigned int> &lut, unsigned short bits, unsigned short position) {
+  unsigned long amount_entries = 1UL << bits;
+  unsigned long max_value = amount_entries - 1;
+
+  lut.resize(amount_entries);
+  for (unsigned long value = 0; value < amount_entries; ++value) {
+    unsigned int value_8bit = max_value==0 ? 0 : static_cast<unsigned int>((value*255 + max_value/2)/max_value);
+    lut[value] = value_8bit << position;
+  }
+}
+
+void PixelDecoder::InitMaskedChannelTables(unsigned long red_mask, unsigned long green_mask, unsigned long blue_mask) {
+  this->red_mask = red_mask;
+  this->green_mask = green_mask;
+  this->blue_mask = blue_mask;
+
+  unsigned short red_bits, green_bits, blue_bits;
+  ResolveMask(red_mask, red_shift, red_bits);
+  ResolveMask(green_mask, green_shift, green_bits);
+  ResolveMask(blue_mask, blue_shift, blue_bits);
+
+  InitScaledTable(lut_red, red_bits, 16);
+  InitScaledTable(lut_green, green_bits, 8);
+  InitScaledTable(lut_blue, blue_bits, 0);
+}
+
+// DirectColor: channel values are indices into the colormap, resolve all cells in one batched request
+void PixelDecoder::InitDirectColorTables(Display *display, Visual *visual) {
+  auto amount_cells = static_cast<unsigned long>(visual->map_entries);
+  std::vector<XColor> cells(amount_cells);
+  for (unsigned long index = 0; index < amount_cells; ++index) {
+    cells[index].pixel = ((index << red_shift) & red_mask)
+        | ((index << green_shift) & green_mask)
+        | ((index << blue_shift) & blue_mask);
+  }
+  XQueryColors(display, DefaultColormap(display, DefaultScreen(display)), cells.data(), static_cast<int>(amount_cells));
+
+  for (unsigned long index = 0; index < amount_cells; ++index) {
+    if (index < lut_red.size()) lut_red[index] = static_cast<unsigned int>(cells[index].red >> 8) << 16;
+    if (index < lut_green.size()) lut_green[index] = static_cast<unsigned int>(cells[index].green >> 8) << 8;
+    if (index < lut_blue.size()) lut_blue[index] = static_cast<unsigned int>(cells[index].blue >> 8);
+  }
+}
+
+// Palette visuals: resolve all colormap cells in one batched request
+void PixelDecoder::InitPalette(Display *display, Visual *visual) {
+  auto amount_cells = static_cast<unsigned long>(visual->map_entries);
+  std::vector<XColor> cells(amount_cells);
+  for (unsigned long index = 0; index < amount_cells; ++index) cells[index].pixel = index;
+
+  XQueryColors(display, DefaultColormap(display, DefaultScreen(display)), cells.data(), static_cast<int>(amount_cells));
+
+  palette.resize(amount_cells);
+  for (unsigned long index = 0; index < amount_cells; ++index) {
+    palette[index] = (static_cast<unsigned int>(cells[index].red >> 8) << 16)
+        | (static_cast<unsigned int>(cells[index].green >> 8) << 8)
+        | static_cast<unsigned int>(cells[index].blue >> 8);
+  }
+}
+
+} // namespace pixloc
@@ -0,0 +1,180 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_PIXEL_DECODER
+#define CLASS_PIXLOC_PIXEL_DECODER
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <cstring>
+#include <vector>
+
+#include "pixloc/models/frame.h"
+
+namespace pixloc {
+
+// Converts raw pixel values of the screen's visual into packed 0xRRGGBB values, in-process.
+// Visual and colormap are queried once at construction, instead of one XQueryColor round trip per pixel
+class PixelDecoder {
+
+ public:
+  // Pixel layouts of frames w/ a dedicated decoder, others are decoded via the channel tables or palette
+  enum Layout {
+    kLayoutMasked,  // Any pixel size and visual
+    kLayoutBgrx32,  // 32 bits per pixel, LSB first, 8-bit channels: bytes B, G, R, unused
+    kLayoutBgr24,   // 24 bits per pixel, LSB first, 8-bit channels: bytes B, G, R
+    kLayoutRgb565   // 16 bits per pixel, LSB first, 5-bit red, 6-bit green, 5-bit blue
+  };
+
+  // Decoders of a pixel of a layout, w/o branches. Instantiated per layout by DecodeRow() and ScanKernel
+  struct Bgrx32Layout {
+    static const unsigned short kBytesPerPixel = 4;
+
+    Bgrx32Layout(const PixelDecoder &, bool) {}
+
+    inline unsigned int Decode(const unsigned char *pixel) const {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__
+      unsigned int value;
+      memcpy(&value, pixel, sizeof(value));
+
+      return value & 0xffffff;
+#else
+      return pixel[0] | (pixel[1] << 8) | (static_cast<unsigned int>(pixel[2]) << 16);
+#endif
+    }
+  };
+
+  struct Bgr24Layout {
+    static const unsigned short kBytesPerPixel = 3;
+
+    Bgr24Layout(const PixelDecoder &, bool) {}
+
+    inline unsigned int Decode(const unsigned char *pixel) const {
+      return pixel[0] | (pixel[1] << 8) | (static_cast<unsigned int>(pixel[2]) << 16);
+    }
+  };
+
+  struct Rgb565Layout {
+    static const unsigned short kBytesPerPixel = 2;
+
+    // pixel value => 0xRRGGBB
+    const unsigned int *table;
+
+    Rgb565Layout(const PixelDecoder &decoder, bool) : table(decoder.rgb565_table.data()) {}
+
+    inline unsigned int Decode(const unsigned char *pixel) const { return table[pixel[0] | (pixel[1] << 8)]; }
+  };
+
+  template<unsigned short kBitsPerPixel>
+  struct MaskedLayout {
+    static const unsigned short kBytesPerPixel = kBitsPerPixel/8;
+
+    const PixelDecoder *decoder;
+    bool is_lsb_first;
+
+    MaskedLayout(const PixelDecoder &decoder, bool is_lsb_first) : decoder(&decoder), is_lsb_first(is_lsb_first) {}
+
+    inline unsigned int Decode(const unsigned char *pixel) const {
+      return decoder->Decode(Frame::ReadPixel(pixel, kBitsPerPixel, is_lsb_first));
+    }
+  };
+
+  // Constructor: decode pixels of the default visual of given display
+  explicit PixelDecoder(Display *display);
+
+  // Constructor: decode TrueColor pixels of given channel masks, e.g. of recorded frames
+  PixelDecoder(unsigned long red_mask, unsigned long green_mask, unsigned long blue_mask);
+
+  // Constructor: decode pixels of a palette visual, given its packed 0xRRGGBB colors per pixel value
+  explicit PixelDecoder(const std::vector<unsigned int> &palette);
+
+  // Return red, green and blue channels of given raw pixel value, packed into 0xRRGGBB
+  inline unsigned int Decode(unsigned long pixel) const {
+    if (is_palette_visual) return pixel < palette.size() ? palette[pixel] : 0;
+
+    return lut_red[(pixel & red_mask) >> red_shift]
+        | lut_green[(pixel & green_mask) >> green_shift]
+        | lut_blue[(pixel & blue_mask) >> blue_shift];
+  }
+
+  // Decode row at given y of given frame into packed 0xRRGGBB values, rgb_row must hold frame.width values
+  void DecodeRow(const Frame &frame, unsigned short y, unsigned int *rgb_row) const;
+
+  // Get layout of frames of given pixel size and byte order, as decoded by this decoder
+  Layout GetLayout(unsigned short bits_per_pixel, bool is_lsb_first) const;
+
+  template<class LayoutDecoder>
+  static inline void DecodeRowOfLayout(const LayoutDecoder &layout, const unsigned char *row, unsigned short width,
+                                       unsigned int *rgb_row) {
+    for (unsigned short x = 0; x < width; ++x) rgb_row[x] = layout.Decode(row + x*LayoutDecoder::kBytesPerPixel);
+  }
+
+  static inline unsigned char GetRed(unsigned int rgb) { return static_cast<unsigned char>(rgb >> 16); }
+  static inline unsigned char GetGreen(unsigned int rgb) { return static_cast<unsigned char>(rgb >> 8); }
+  static inline unsigned char GetBlue(unsigned int rgb) { return static_cast<unsigned char>(rgb); }
+
+ private:
+  // Channel masks wider than this are truncated to their most significant bits
+  static const unsigned short kMaxChannelBits = 16;
+
+  bool is_palette_visual;
+
+  unsigned long red_mask;
+  unsigned long green_mask;
+  unsigned long blue_mask;
+  unsigned short red_shift;
+  unsigned short green_shift;
+  unsigned short blue_shift;
+
+  // Per-channel tables: shifted-down masked channel value => 8-bit channel value, at its position within 0xRRGGBB
+  std::vector<unsigned int> lut_red;
+  std::vector<unsigned int> lut_green;
+  std::vector<unsigned int> lut_blue;
+
+  // PseudoColor, StaticColor, GrayScale, StaticGray: pixel value => 0xRRGGBB
+  std::vector<unsigned int> palette;
+
+  // TrueColor w/ 8-bit channels at 0xRRGGBB, decoded unchanged
+  bool is_bgr_888;
+  // TrueColor w/ 5-6-5 bit channels: pixel value => 0xRRGGBB, empty for other visuals
+  std::vector<unsigned int> rgb565_table;
+
+  void InitLayouts();
+
+  void InitMaskedChannelTables(unsigned long red_mask, unsigned long green_mask, unsigned long blue_mask);
+  void InitDirectColorTables(Display *display, Visual *visual);
+  void InitPalette(Display *display, Visual *visual);
+
+  static void ResolveMask(unsigned long mask, unsigned short &shift, unsigned short &bits);
+  static void InitScaledTable(std::vector<unsigned int> &lut, unsigned short bits, unsigned short position);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_PIXEL_DECODER
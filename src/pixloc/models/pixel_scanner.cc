@@ -27,75 +27,81 @@
   POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <memory>
+#include <thread>
+
 #include "pixel_scanner.h"
-#include "pixloc/helper/strings.h"
 
 namespace pixloc {
 
 // Constructor
-PixelScanner::PixelScanner(Display *display,
+PixelScanner::PixelScanner(const Frame &frame,
+                           const PixelDecoder *decoder,
                            unsigned short x_start, unsigned short y_start,
                            unsigned short range_x, unsigned short range_y,
-                           unsigned short find_red, unsigned short find_green, unsigned short find_blue,
-                           unsigned short tolerance) {
-  this->display = display;
-  this->color = new XColor();
+                           const ColorMatcher &color_matcher) {
+  this->decoder = decoder;
 
   this->x_start = x_start;
   this->y_start = y_start;
   this->range_x = range_x;
   this->range_y = range_y;
 
-  this->color_matcher = new ColorMatcher(find_red, find_green, find_blue, tolerance);
+  this->color_matcher = new ColorMatcher(color_matcher);
+
+  this->frame = frame;
+  this->rgb_row.resize(range_x);
+
+  this->scan_kernel = new ScanKernel(*decoder, *this->color_matcher, frame.bits_per_pixel, frame.is_lsb_first);
 
-  this->image = XGetImage(display,
-                          RootWindow(display, DefaultScreen(display)),
-                          x_start, y_start,
-                          range_x, range_y,
-                          AllPlanes,
-                          XYPixmap);
+  this->stats = nullptr;
+  this->report_matched_color = false;
 };
 
 // Destructor
 PixelScanner::~PixelScanner() {
-  delete this->color;
+  delete this->scan_kernel;
   delete this->color_matcher;
 }
 
-// Scan (or trace) given line or column on screenshot image
+// Scan given line or column on screenshot image
 // Return x or y position where given RGB occurs in given amount of consecutive pixels,
 // Or return -1 if not found
-int PixelScanner::ScanUniaxial(unsigned short amount_find, unsigned short step_size, bool trace) {
-  auto *color = new XColor;
+int PixelScanner::ScanUniaxial(unsigned short amount_find, unsigned short step_size) {
+  ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+  CountThreads(1);
+
+  if (step_size==1 && range_y==1) {
+    // Find horizontal run of matching pixels within row classified at once
+    Bitmask matches(range_x, 1);
+    color_matcher->MatchRow(DecodeRow(0), range_x, matches.GetRow(0));
+    CountCandidates(range_x);
+
+    return Bitmask::FindRun(matches.GetRow(0), range_x, amount_find);
+  }
 
   unsigned short step_size_x, step_size_y;
   InitUniaxialStepSize(step_size, step_size_x, step_size_y);
 
   unsigned short amount_found = 0;
   for (unsigned short y = 0; y < range_y; y += step_size_y) {
+    const unsigned int *rgb_row = DecodeRow(y);
+    CountCandidates((range_x + step_size_x - 1)/step_size_x);
+
     for (unsigned short x = 0; x < range_x; x += step_size_x) {
-      color->pixel = XGetPixel(image, x, y);
-      XQueryColor(display, DefaultColormap(display, DefaultScreen(display)), color);
+      unsigned int rgb = rgb_row[x];
 
-      if (trace)
-        std::cout << (color->red/256) << "," << (color->green/256) << "," << (color->blue/256) << "\n";
-      else if (color_matcher->Matches(color->red, color->green, color->blue)) {
+      if (color_matcher->Matches(rgb)) {
         if (step_size==1) {
           // Found matching pixel while scanning with frequency of 1 pixel
           ++amount_found;
           if (amount_found==amount_find) {
-            XFree(image);
-            delete color;
-
             return range_y==1 ? x : y;
           }
         } else {
           // Found 1 matching pixel while interval scanning, now scan directly neighbouring pixels
           signed short starting_value = GetStartingValueOfHomochromaticSetAtCoordinate(x, y, amount_find);
           if (starting_value > -1) {
-            XFree(image);
-            delete color;
-
             return starting_value;
           }
         }
@@ -103,19 +109,61 @@ int PixelScanner::ScanUniaxial(unsigned short amount_find, unsigned short step_s
     }
   }
 
-  XFree(image);
-  delete color;
-
   return -1;
 }
 
+// Output color of every step-th pixel of given line or column, in given format:
+// text: "r,g,b" per line, JSON lines: coordinate and color per line, raw: header and 3 bytes per pixel
+void PixelScanner::TraceUniaxial(unsigned short step_size, OutputBuffer::Format format, OutputBuffer &out) {
+  ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+  CountThreads(1);
+
+  unsigned short step_size_x, step_size_y;
+  InitUniaxialStepSize(step_size, step_size_x, step_size_y);
+
+  if (format==OutputBuffer::kFormatRaw)
+    out.AppendRawHeader(OutputBuffer::kRawTypeRgb,
+                        static_cast<unsigned short>((range_x + step_size_x - 1)/step_size_x),
+                        static_cast<unsigned short>((range_y + step_size_y - 1)/step_size_y));
+
+  for (unsigned short y = 0; y < range_y; y += step_size_y) {
+    const unsigned int *rgb_row = DecodeRow(y);
+
+    for (unsigned short x = 0; x < range_x; x += step_size_x) {
+      unsigned int rgb = rgb_row[x];
+
+      if (format==OutputBuffer::kFormatRaw) {
+        out.Append(static_cast<char>(PixelDecoder::GetRed(rgb)));
+        out.Append(static_cast<char>(PixelDecoder::GetGreen(rgb)));
+        out.Append(static_cast<char>(PixelDecoder::GetBlue(rgb)));
+        continue;
+      }
+
+      if (format==OutputBuffer::kFormatJsonl) {
+        Match match = GetMatch(x, y);
+        out.Append("{\"x\":", 5);
+        out.AppendNumber(match.x);
+        out.Append(",\"y\":", 5);
+        out.AppendNumber(match.y);
+        out.Append(",\"rgb\":[", 8);
+      }
+
+      out.AppendNumber(PixelDecoder::GetRed(rgb));
+      out.Append(',');
+      out.AppendNumber(PixelDecoder::GetGreen(rgb));
+      out.Append(',');
+      out.AppendNumber(PixelDecoder::GetBlue(rgb));
+      if (format==OutputBuffer::kFormatJsonl) out.Append("]}", 2);
+      out.Append('\n');
+    }
+  }
+}
+
 signed short PixelScanner::GetStartingValueOfHomochromaticSetAtCoordinate(
     unsigned short x_start,
     unsigned short y_start,
     unsigned short amount_find
 ) {
-  auto *color = new XColor;
-
   unsigned short topmost_matching_y = y_start;
   unsigned short leftmost_matching_x = x_start;
 
@@ -125,15 +173,11 @@ signed short PixelScanner::GetStartingValueOfHomochromaticSetAtCoordinate(
     for (unsigned short offset_y = 1; offset_y < amount_found; ++offset_y) {
       // 1. Scan from starting y up, until y == 0 or sought amount was found or a not-matching pixel reached
       if (y_start - offset_y < 0) break;
-      color->pixel = XGetPixel(image, x_start, y_start - offset_y);
-      XQueryColor(display, DefaultColormap(display, DefaultScreen(display)), color);
-      if (color_matcher->Matches(color->red, color->green, color->blue)) {
+      unsigned int rgb = DecodePixel(x_start, y_start - offset_y);
+      if (color_matcher->Matches(rgb)) {
         topmost_matching_y = y_start - offset_y;
         ++amount_found;
         if (amount_found==amount_find) {
-          XFree(image);
-          delete color;
-
           return topmost_matching_y;
         }
       } else break;
@@ -141,14 +185,10 @@ signed short PixelScanner::GetStartingValueOfHomochromaticSetAtCoordinate(
     for (unsigned short offset_y = 1; offset_y < amount_found; ++offset_y) {
       // 2. Scan from starting y down, until y >= range or sought amount was found or a not-matching pixel reached
       if (y_start + offset_y > range_y) break;
-      color->pixel = XGetPixel(image, x_start, y_start + offset_y);
-      XQueryColor(display, DefaultColormap(display, DefaultScreen(display)), color);
-      if (color_matcher->Matches(color->red, color->green, color->blue)) {
+      unsigned int rgb = DecodePixel(x_start, y_start + offset_y);
+      if (color_matcher->Matches(rgb)) {
         ++amount_found;
         if (amount_found==amount_find) {
-          XFree(image);
-          delete color;
-
           return topmost_matching_y;
         }
       } else break;
@@ -158,15 +198,11 @@ signed short PixelScanner::GetStartingValueOfHomochromaticSetAtCoordinate(
     for (unsigned short offset_x = 1; offset_x < amount_find; ++offset_x) {
       // 1. Scan from starting x to the left, until x == 0 or sought amount was found or a not-matching pixel reached
       if (x_start - offset_x < 0) break;
-      color->pixel = XGetPixel(image, x_start - offset_x, y_start);
-      XQueryColor(display, DefaultColormap(display, DefaultScreen(display)), color);
-      if (color_matcher->Matches(color->red, color->green, color->blue)) {
+      unsigned int rgb = DecodePixel(x_start - offset_x, y_start);
+      if (color_matcher->Matches(rgb)) {
         leftmost_matching_x = x_start - offset_x;
         ++amount_found;
         if (amount_found==amount_find) {
-          XFree(image);
-          delete color;
-
           return leftmost_matching_x;
         }
       } else break;
@@ -174,14 +210,10 @@ signed short PixelScanner::GetStartingValueOfHomochromaticSetAtCoordinate(
     for (unsigned short offset_x = 1; offset_x < amount_found; ++offset_x) {
       // 2. Scan from starting x to the right, until x >= range or sought amount was found or a not-matching pixel reached
       if (x_start + offset_x > range_x) break;
-      color->pixel = XGetPixel(image, x_start + offset_x, y_start);
-      XQueryColor(display, DefaultColormap(display, DefaultScreen(display)), color);
-      if (color_matcher->Matches(color->red, color->green, color->blue)) {
+      unsigned int rgb = DecodePixel(x_start + offset_x, y_start);
+      if (color_matcher->Matches(rgb)) {
         ++amount_found;
         if (amount_found==amount_find) {
-          XFree(image);
-          delete color;
-
           return leftmost_matching_x;
         }
       } else break;
@@ -203,151 +235,776 @@ void PixelScanner::InitUniaxialStepSize(unsigned short step_size,
   }
 }
 
-void PixelScanner::TraceMainColor() {
-  auto *color = new XColor;
+// Output most common color as "r,g,b", or given amount of most common colors w/ their amount of pixels, one per line.
+// Rows are split into bands, counted into per-thread partial histograms by given amount of threads
+// (0 = hardware concurrency), which are merged at the end
+void PixelScanner::TraceMainColor(std::ostream &out, unsigned short amount_top, unsigned short amount_threads) {
+  auto most_common = GetMostCommonColors(amount_top==0 ? 1 : amount_top, amount_threads);
+
+  if (amount_top==0) {
+    if (!most_common.empty()) out << ColorHistogram::FormatRgb(most_common[0].first);
+    return;
+  }
+
+  for (const auto &color : most_common) out << ColorHistogram::FormatRgb(color.first) << " " << color.second << "\n";
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> PixelScanner::GetMostCommonColors(unsigned short amount,
+                                                                                     unsigned short amount_threads) {
+  if (amount_threads==0) amount_threads = static_cast<unsigned short>(std::thread::hardware_concurrency());
+  if (amount_threads==0) amount_threads = 1;
 
-  std::vector<std::string> colors;
+  unsigned int amount_bands = (range_y + kMinHistogramBandHeight - 1)/kMinHistogramBandHeight;
+  if (amount_threads > amount_bands) amount_threads = static_cast<unsigned short>(amount_bands);
+  if (amount_threads==0) amount_threads = 1;
 
-  for (unsigned short y = 0; y < range_y; ++y) {
-    for (unsigned short x = 0; x < range_x; ++x) {
-      color->pixel = XGetPixel(image, x, y);
-      XQueryColor(display, DefaultColormap(display, DefaultScreen(display)), color);
-      char rgb[12];
-      sprintf(rgb, "%d,%d,%d", color->red/256, color->green/256, color->blue/256);
-      colors.emplace_back(rgb);
+  std::vector<ColorHistogram> histograms(amount_threads);
+  CountThreads(amount_threads);
+
+  auto count_band = [&](unsigned short index_thread) {
+    ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+    std::vector<unsigned int> rgb_buffer(range_x);
+    ColorHistogram &histogram = histograms[index_thread];
+
+    auto first_y = static_cast<unsigned short>(static_cast<unsigned long>(range_y)*index_thread/amount_threads);
+    auto end_y = static_cast<unsigned short>(static_cast<unsigned long>(range_y)*(index_thread + 1)/amount_threads);
+
+    for (unsigned short y = first_y; y < end_y; ++y) {
+      DecodeRow(y, rgb_buffer.data());
+      histogram.AddRow(rgb_buffer.data(), range_x);
     }
+  };
+
+  if (amount_threads <= 1) {
+    count_band(0);
+  } else {
+    std::vector<std::thread> workers;
+    for (unsigned short index = 0; index < amount_threads; ++index) workers.emplace_back(count_band, index);
+    for (auto &worker : workers) worker.join();
   }
 
-  XFree(image);
-  delete color;
+  for (unsigned short index = 1; index < amount_threads; ++index) histograms[0].Merge(histograms[index]);
 
-  std::cout << helper::strings::FindMostCommon(colors);
+  return histograms[0].GetMostCommon(amount);
 }
 
-void PixelScanner::TraceBitmask() {
+// Output bitmask of pixels matching the sought colors, in given format:
+// text: a row of * and _ per line, JSON lines: y-coordinate and row per line,
+// raw: header and rows of bits, padded to whole bytes, bit x%8 of byte x/8 represents pixel x
+void PixelScanner::TraceBitmask(OutputBuffer::Format format, OutputBuffer &out) {
+  ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+  CountThreads(1);
+
+  Bitmask bitmask(range_x, range_y);
+  if (format==OutputBuffer::kFormatRaw) out.AppendRawHeader(OutputBuffer::kRawTypeBitmask, range_x, range_y);
+
   for (unsigned short y = 0; y < range_y; ++y) {
-    std::cout << this->GetBitmaskLineFromImage(y) << (y < range_y - 1 ? "," : "") << "\n";
+    LoadBitmaskRow(bitmask, y, y);
+    const uint64_t *row = bitmask.GetRow(y);
+
+    if (format==OutputBuffer::kFormatRaw) {
+      char *bytes = out.Extend((range_x + 7)/8);
+      for (unsigned short index_byte = 0; index_byte < (range_x + 7)/8; ++index_byte)
+        bytes[index_byte] = static_cast<char>(row[index_byte/8] >> (index_byte%8*8));
+      continue;
+    }
+
+    if (format==OutputBuffer::kFormatJsonl) {
+      out.Append("{\"y\":", 5);
+      out.AppendNumber(GetMatch(0, y).y);
+      out.Append(",\"row\":\"", 8);
+    }
+
+    char *chars = out.Extend(range_x);
+    for (unsigned short x = 0; x < range_x; ++x)
+      chars[x] = (row[x >> 6] >> (x & 63)) & 1 ? Bitmask::kCharSet : Bitmask::kCharUnset;
+
+    if (format==OutputBuffer::kFormatJsonl)
+      out.Append("\"}", 2);
+    else if (y < range_y - 1)
+      out.Append(Bitmask::kRowSeparator);
+
+    out.Append('\n');
   }
+}
+
+uint64_t PixelScanner::GetFingerprint(Fingerprint::Kind kind) {
+  ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+  CountThreads(1);
+
+  Fingerprint fingerprint(kind, range_x, range_y);
+  for (unsigned short y = 0; y < range_y; ++y) fingerprint.AddRow(DecodeRow(y));
+
+  return fingerprint.GetValue();
+}
+
+// Decode given row of captured image into reused buffer of packed 0xRRGGBB values
+const unsigned int *PixelScanner::DecodeRow(unsigned short y) {
+  DecodeRow(y, rgb_row.data());
 
-  XFree(image);
+  return rgb_row.data();
 }
 
-std::string PixelScanner::GetBitmaskLineFromImage(unsigned short y) {
-  std::string bitmask_haystack;
+// Decode given row of captured image into given buffer, timed and counted if statistics are collected
+void PixelScanner::DecodeRow(unsigned short y, unsigned int *rgb_buffer) const {
+  DecodeRow(frame, y, rgb_buffer);
+}
 
-  for (unsigned short x = 0; x < this->range_x; ++x) {
-    color->pixel = XGetPixel(this->image, x, y);
-    XQueryColor(display, DefaultColormap(display, DefaultScreen(display)), color);
-    bitmask_haystack += this->color_matcher->Matches(color->red, color->green, color->blue) ? '*' : '_';
+void PixelScanner::DecodeRow(const Frame &source_frame, unsigned short y, unsigned int *rgb_buffer) const {
+  if (!stats) {
+    decoder->DecodeRow(source_frame, y, rgb_buffer);
+    return;
   }
 
-  return bitmask_haystack;
+  uint64_t start = ScanStats::Now();
+  decoder->DecodeRow(source_frame, y, rgb_buffer);
+  stats->Add(ScanStats::kPhaseDecode, ScanStats::Now() - start);
+  stats->Add(ScanStats::kCounterPixelsDecoded, range_x);
 }
 
-// Find coordinate of bitmask sought-after
-std::string PixelScanner::FindBitmask(const std::string &bitmask_needle) {
-  std::vector<std::string> needle_lines = helper::strings::Explode(bitmask_needle, ',');
-
-  unsigned short haystack_width = this->range_x - this->x_start;
-  unsigned short amount_haystack_lines = this->range_y - this->y_start;
-  std::vector<std::string> haystack_lines(amount_haystack_lines);
-  // index to enable lazy-loading: next line that has to be grabbed
-  unsigned short index_haystack_line_empty = 0;
-  auto amount_needle_lines = static_cast<unsigned short>(needle_lines.size());
-  auto needle_width = static_cast<unsigned short>(needle_lines[0].length());
-  unsigned short last_possible_offset_per_haystack_line = haystack_width - needle_width;
-  auto last_possible_occurrence_haystack_line =
-      static_cast<unsigned short>(amount_haystack_lines - amount_needle_lines + 1);
-  signed long offset_needle;
-  unsigned short index_haystack_line;
-  unsigned short index_needle_line;
-  auto index_last_needle_line = static_cast<unsigned short>(needle_lines.size() - 1);
-
-  std::string haystack_line_compare;
-  std::string needle_compare;
-
-  const char *needle_line;
-  unsigned short index_haystack_line_compare;
-
-  // Iterate over lines of haystack
-  std::string haystack_line;
-  for (index_haystack_line = 0; index_haystack_line < last_possible_occurrence_haystack_line; ++index_haystack_line) {
-    FetchHaystackLine(haystack_lines,
-                      index_haystack_line_empty,
-                      index_haystack_line,
-                      haystack_line);
-    // Find 1st line of sought bitmask within current line of screenshot
-    offset_needle = static_cast<signed short>(haystack_line.find(needle_lines[0], 0));
-
-    while (true) {
-      // Look at all occurrences of 1st line of needle
-      if (offset_needle==std::string::npos ||
-          offset_needle > last_possible_offset_per_haystack_line ||
-          index_haystack_line > last_possible_occurrence_haystack_line)
-        break;
+// Set bits of all pixels matching the sought color, within given row of given bitmask,
+// from given row of the frame, decoded and matched at once. Decoding is not timed apart from matching
+void PixelScanner::LoadBitmaskRow(Bitmask &bitmask, unsigned short bitmask_y, unsigned short frame_y) const {
+  scan_kernel->MatchRow(frame.Row(frame_y), range_x, bitmask.GetRow(bitmask_y));
+  if (stats) stats->Add(ScanStats::kCounterPixelsDecoded, range_x);
+}
+
+// Find coordinate of bitmask sought-after.
+// The candidate rows are split into bands, searched by given amount of threads (0 = hardware concurrency)
+std::string PixelScanner::FindBitmask(const std::string &bitmask_needle, unsigned short amount_threads) {
+  Match match{};
+
+  return FindBitmask(bitmask_needle, amount_threads, match) ? FormatMatch(match) : kCoordinateNotFound;
+}
+
+bool PixelScanner::FindBitmask(const std::string &bitmask_needle, unsigned short amount_threads, Match &match) {
+  Bitmask bitmask(bitmask_needle);
+  BitmaskNeedle needle{bitmask};
+  unsigned short needle_width = needle.GetWidth();
+  unsigned short needle_height = needle.GetHeight();
+  if (needle_width==0 || needle_width > range_x || needle_height > range_y) return false;
+
+  auto amount_candidate_rows = static_cast<unsigned int>(range_y - needle_height + 1);
+  unsigned int band_height;
+  unsigned int amount_bands;
+  InitBands(amount_candidate_rows, needle_height, amount_threads, band_height, amount_bands);
+  CountThreads(amount_threads);
+
+  std::vector<int> found_x(amount_bands, -1);
+  std::vector<int> found_y(amount_bands, -1);
+
+  // Bands are handed out in scan order to whichever worker is idle
+  std::atomic<unsigned int> index_next_band(0);
+  // Lowest band that found an occurrence: workers stop searching all later bands
+  std::atomic<unsigned int> index_first_found_band(amount_bands);
+
+  auto search_bands = [&]() {
+    ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+    unsigned int index_band;
+
+    while ((index_band = index_next_band++) < amount_bands && index_band < index_first_found_band.load()) {
+      auto first_y = static_cast<unsigned short>(index_band*band_height);
+      auto last_y = static_cast<unsigned short>(
+          index_band*band_height + band_height > amount_candidate_rows
+          ? amount_candidate_rows - 1
+          : index_band*band_height + band_height - 1);
+
+      if (!FindBitmaskInBand(needle, first_y, last_y, index_band, index_first_found_band,
+                             found_x[index_band], found_y[index_band]))
+        continue;
+
+      unsigned int index_found = index_first_found_band.load();
+      while (index_band < index_found && !index_first_found_band.compare_exchange_weak(index_found, index_band)) {}
+    }
+  };
+
+  if (amount_threads <= 1) {
+    search_bands();
+  } else {
+    std::vector<std::thread> workers;
+    for (unsigned short index = 0; index < amount_threads; ++index) workers.emplace_back(search_bands);
+    for (auto &worker : workers) worker.join();
+  }
+
+  unsigned int index_found = index_first_found_band.load();
+  if (index_found >= amount_bands) return false;
+
+  auto x = static_cast<unsigned short>(found_x[index_found]);
+  auto y = static_cast<unsigned short>(found_y[index_found]);
+  match = GetMatch(x, y, GetIndexOfMatchedColor(bitmask, x, y));
+
+  return true;
+}
 
-      if (amount_needle_lines==1) {
-        // Bitmask has only 1 line: found it
-        XFree(image);
-        return FormatCoordinate(offset_needle, index_haystack_line);
+// Rows are kept in rings of the needle's height: classified, and decoded only for reporting the matched color.
+// Once the last row under a candidate top row arrived, the candidate row is checked like in FindBitmaskInBand
+std::string PixelScanner::FindBitmaskInStrips(
+    const std::string &bitmask_needle,
+    const std::function<void(const FrameSource::StripConsumer &)> &capture_strips) {
+  Bitmask bitmask(bitmask_needle);
+  BitmaskNeedle needle{bitmask};
+  unsigned short needle_width = needle.GetWidth();
+  unsigned short needle_height = needle.GetHeight();
+  if (needle_width==0 || needle_width > range_x || needle_height > range_y) return kCoordinateNotFound;
+
+  CountThreads(1);
+  auto last_possible_x = static_cast<unsigned short>(range_x - needle_width);
+  Bitmask haystack(range_x, needle_height);
+  std::vector<unsigned int> rgb_rows(report_matched_color ? static_cast<unsigned long>(range_x)*needle_height : 0);
+  int found_x = -1, found_y = -1, index_color = -1;
+
+  // Strips are of the source's layout, unknown to the scanner until the 1st one arrives
+  std::unique_ptr<ScanKernel> strip_kernel;
+
+  capture_strips([&](const Frame &strip, unsigned short strip_y) {
+    ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+    if (!strip_kernel)
+      strip_kernel.reset(new ScanKernel(*decoder, *color_matcher, strip.bits_per_pixel, strip.is_lsb_first));
+
+    for (unsigned short y = 0; y < strip.height; ++y) {
+      unsigned int haystack_y = strip_y + y;
+      auto ring_y = static_cast<unsigned short>(haystack_y%needle_height);
+      strip_kernel->MatchRow(strip.Row(y), range_x, haystack.GetRow(ring_y));
+      if (report_matched_color) {
+        DecodeRow(strip, y, &rgb_rows[static_cast<unsigned long>(ring_y)*range_x]);
+      } else if (stats) {
+        stats->Add(ScanStats::kCounterPixelsDecoded, range_x);
       }
 
-      // Iterate down the lines of needle
-      for (index_needle_line = 1; index_needle_line < amount_needle_lines; ++index_needle_line) {
-        // Check whether following haystack line contains resp. needle line at rel. offset
-        needle_line = needle_lines[index_needle_line].c_str();
-
-        index_haystack_line_compare = index_haystack_line + index_needle_line;
-        if (index_haystack_line > last_possible_occurrence_haystack_line)
-          break;
-
-        FetchHaystackLine(haystack_lines,
-                          index_haystack_line_empty,
-                          index_haystack_line_compare,
-                          haystack_line_compare);
-        needle_compare = haystack_line_compare.substr(static_cast<unsigned long>(offset_needle), needle_width);
-
-        if (strcmp(needle_compare.c_str(), needle_line)!=0)
-          break;
-        else if (index_needle_line==index_last_needle_line) {
-          // All lines of needle were found within haystack, return absolute coordinate
-          XFree(image);
-          return FormatCoordinate(offset_needle, index_haystack_line);
-        }
-        // Needle line found but there are more, check following haystack line
+      if (haystack_y + 1 < needle_height) continue;
+
+      unsigned int top_y = haystack_y + 1 - needle_height;
+      CountCandidates(last_possible_x + 1u);
+
+      for (unsigned short x = 0; x <= last_possible_x; ++x) {
+        unsigned short needle_y = 0;
+        while (needle_y < needle_height &&
+            needle.MatchesRow(haystack.GetRow(static_cast<unsigned short>((top_y + needle_y)%needle_height)), x,
+                              needle_y))
+          ++needle_y;
+
+        if (needle_y < needle_height) continue;
+
+        found_x = x;
+        found_y = static_cast<int>(top_y);
+
+        unsigned short first_x, first_y;
+        if (report_matched_color && bitmask.FindFirstSet(first_x, first_y))
+          index_color = color_matcher->GetIndexOfMatchingColor(
+              rgb_rows[((top_y + first_y)%needle_height)*range_x + x + first_x]);
+
+        return false;
       }
+    }
 
-      // Not all lines of needle were found at this offset in lines under occurrence of 1st needle line
+    return true;
+  });
 
-      // Reached end of haystack line? Continue scanning in next haystack line
-      if (offset_needle >= last_possible_offset_per_haystack_line) break;
+  return found_x > -1
+         ? FormatCoordinate(found_x, static_cast<unsigned short>(found_y), index_color)
+         : kCoordinateNotFound;
+}
+
+// Find coordinate of given image, topmost than leftmost occurrence.
+// The candidate rows are split into bands, searched by given amount of threads (0 = hardware concurrency)
+std::string PixelScanner::FindImage(const ImageNeedle &needle, unsigned short amount_threads) {
+  Match match{};
 
-      // Init next iteration: check lines under next occurrence of 1st needle line in current haystack line
-      offset_needle = static_cast<unsigned short>(
-          haystack_line.find(needle_lines[0], static_cast<unsigned long>(offset_needle + 1)));
+  return FindImage(needle, amount_threads, match) ? FormatMatch(match) : kCoordinateNotFound;
+}
+
+bool PixelScanner::FindImage(const ImageNeedle &needle, unsigned short amount_threads, Match &match) {
+  unsigned short needle_width = needle.GetWidth();
+  unsigned short needle_height = needle.GetHeight();
+  if (needle_width==0 || needle_width > range_x || needle_height > range_y) return false;
+
+  auto amount_candidate_rows = static_cast<unsigned int>(range_y - needle_height + 1);
+  unsigned int band_height;
+  unsigned int amount_bands;
+  InitBands(amount_candidate_rows, needle_height, amount_threads, band_height, amount_bands);
+  CountThreads(amount_threads);
+
+  std::vector<int> found_x(amount_bands, -1);
+  std::vector<int> found_y(amount_bands, -1);
+
+  std::atomic<unsigned int> index_next_band(0);
+  std::atomic<unsigned int> index_first_found_band(amount_bands);
+
+  auto search_bands = [&]() {
+    ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+    std::vector<unsigned int> band_rows;
+    unsigned int index_band;
+
+    while ((index_band = index_next_band++) < amount_bands && index_band < index_first_found_band.load()) {
+      auto first_y = static_cast<unsigned short>(index_band*band_height);
+      auto last_y = static_cast<unsigned short>(
+          index_band*band_height + band_height > amount_candidate_rows
+          ? amount_candidate_rows - 1
+          : index_band*band_height + band_height - 1);
+
+      if (!FindImageInBand(needle, first_y, last_y, index_band, index_first_found_band, band_rows,
+                           found_x[index_band], found_y[index_band]))
+        continue;
+
+      unsigned int index_found = index_first_found_band.load();
+      while (index_band < index_found && !index_first_found_band.compare_exchange_weak(index_found, index_band)) {}
     }
+  };
+
+  if (amount_threads <= 1) {
+    search_bands();
+  } else {
+    std::vector<std::thread> workers;
+    for (unsigned short index = 0; index < amount_threads; ++index) workers.emplace_back(search_bands);
+    for (auto &worker : workers) worker.join();
   }
 
-  return "x=-1; y=-1;";
+  unsigned int index_found = index_first_found_band.load();
+  if (index_found >= amount_bands) return false;
+
+  match = GetMatch(found_x[index_found], static_cast<unsigned short>(found_y[index_found]));
+
+  return true;
 }
 
-// Get line from bitmask haystack. this is lazy-loaded: initialize it via GetBitmaskLineFromImage if not yet
-void PixelScanner::FetchHaystackLine(std::vector<std::string> &haystack_lines,
-                                     unsigned short &index_empty_haystack_line,
-                                     unsigned short index_haystack_line,
-                                     std::string &haystack_line) {
-  if (index_empty_haystack_line > index_haystack_line) {
-    haystack_line = haystack_lines.at(index_haystack_line);
+// Search image w/ its top row within given range of candidate rows (incl. last_y). Rows are lazy-loaded into given
+// buffer, candidates are rejected at their first mismatching row.
+// Cancels as soon as an earlier band found an occurrence
+bool PixelScanner::FindImageInBand(const ImageNeedle &needle,
+                                   unsigned short first_y,
+                                   unsigned short last_y,
+                                   unsigned int index_band,
+                                   const std::atomic<unsigned int> &index_first_found_band,
+                                   std::vector<unsigned int> &band_rows,
+                                   int &found_x,
+                                   int &found_y) const {
+  unsigned short needle_height = needle.GetHeight();
+  auto last_possible_x = static_cast<unsigned short>(range_x - needle.GetWidth());
+
+  // Band rows overlap w/ the following band by the needle's height
+  band_rows.resize(static_cast<unsigned long>(last_y - first_y + needle_height)*range_x);
+  unsigned short amount_rows_loaded = 0;
+
+  auto get_row = [&](unsigned short y) -> const unsigned int * {
+    while (amount_rows_loaded <= y) {
+      DecodeRow(static_cast<unsigned short>(first_y + amount_rows_loaded),
+                &band_rows[static_cast<unsigned long>(amount_rows_loaded)*range_x]);
+      ++amount_rows_loaded;
+    }
+
+    return &band_rows[static_cast<unsigned long>(y)*range_x];
+  };
+
+  for (unsigned short y = 0; y <= last_y - first_y; ++y) {
+    if (index_first_found_band.load(std::memory_order_relaxed) < index_band) return false;
+
+    const unsigned int *haystack_row = get_row(y);
+    CountCandidates(last_possible_x + 1u);
+
+    for (unsigned short x = 0; x <= last_possible_x; ++x) {
+      if (!needle.MatchesRow(haystack_row, x, 0)) continue;
+
+      unsigned short needle_y = 1;
+      while (needle_y < needle_height &&
+          needle.MatchesRow(get_row(static_cast<unsigned short>(y + needle_y)), x, needle_y))
+        ++needle_y;
+
+      if (needle_y==needle_height) {
+        found_x = x;
+        found_y = first_y + y;
+
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+// Find coordinates of all occurrences of given bitmask, row by row, capped to given amount (0 = all).
+// Uses the linear-time Baker-Bird algorithm, the candidate rows are split into bands, searched by given amount of
+// threads (0 = hardware concurrency). Returns false if no occurrence was found
+bool PixelScanner::FindAllBitmasks(const std::string &bitmask_needle,
+                                   unsigned int max_results,
+                                   unsigned short amount_threads,
+                                   std::ostream &out) {
+  std::vector<Match> matches;
+  FindAllBitmasks(bitmask_needle, max_results, amount_threads, matches);
+
+  for (const auto &match : matches) out << FormatMatch(match);
+  if (matches.empty()) out << kCoordinateNotFound;
+
+  return !matches.empty();
+}
+
+void PixelScanner::FindAllBitmasks(const std::string &bitmask_needle,
+                                   unsigned int max_results,
+                                   unsigned short amount_threads,
+                                   std::vector<Match> &matches) {
+  Bitmask bitmask(bitmask_needle);
+  BitmaskAutomaton needle{bitmask};
+  unsigned short needle_width = needle.GetWidth();
+  unsigned short needle_height = needle.GetHeight();
+  if (needle_width==0 || needle_width > range_x || needle_height > range_y) return;
+
+  auto amount_candidate_rows = static_cast<unsigned int>(range_y - needle_height + 1);
+  unsigned int band_height;
+  unsigned int amount_bands;
+  InitBands(amount_candidate_rows, needle_height, amount_threads, band_height, amount_bands);
+  CountThreads(amount_threads);
+
+  std::vector<std::vector<std::pair<unsigned short, unsigned short>>> found(amount_bands);
+  std::atomic<unsigned int> index_next_band(0);
+
+  auto search_bands = [&]() {
+    ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+    unsigned int index_band;
+
+    while ((index_band = index_next_band++) < amount_bands) {
+      auto first_y = static_cast<unsigned short>(index_band*band_height);
+      auto last_y = static_cast<unsigned short>(
+          index_band*band_height + band_height > amount_candidate_rows
+          ? amount_candidate_rows - 1
+          : index_band*band_height + band_height - 1);
+
+      FindAllBitmasksInBand(needle, first_y, last_y, max_results, found[index_band]);
+    }
+  };
+
+  if (amount_threads <= 1) {
+    search_bands();
   } else {
-    haystack_line = this->GetBitmaskLineFromImage(index_haystack_line);
-    haystack_lines.at(index_haystack_line) = haystack_line;
-    index_empty_haystack_line = static_cast<unsigned short>(index_haystack_line + 1);
+    std::vector<std::thread> workers;
+    for (unsigned short index = 0; index < amount_threads; ++index) workers.emplace_back(search_bands);
+    for (auto &worker : workers) worker.join();
+  }
+
+  for (const auto &band : found) {
+    for (const auto &coordinate : band) {
+      if (max_results > 0 && matches.size()==max_results) return;
+
+      matches.push_back(GetMatch(coordinate.first, coordinate.second,
+                                 GetIndexOfMatchedColor(bitmask, coordinate.first, coordinate.second)));
+    }
+  }
+}
+
+// Find all occurrences of needle w/ its top row within given range of candidate rows (incl. last_y), up to given
+// amount (0 = all). Each haystack row is loaded once, column states are carried down the band
+void PixelScanner::FindAllBitmasksInBand(const BitmaskAutomaton &needle,
+                                         unsigned short first_y,
+                                         unsigned short last_y,
+                                         unsigned int max_results,
+                                         std::vector<std::pair<unsigned short, unsigned short>> &found) const {
+  unsigned short needle_width = needle.GetWidth();
+  unsigned short needle_height = needle.GetHeight();
+
+  Bitmask haystack_row(range_x, 1);
+  std::vector<unsigned short> column_states(range_x, 0);
+  // Per column: 1 + haystack row of the last needle row found in it, columns w/o a needle row in the previous
+  // haystack row restart matching
+  std::vector<unsigned int> column_rows(range_x, 0);
+
+  for (unsigned int y = first_y; y <= static_cast<unsigned int>(last_y) + needle_height - 1; ++y) {
+    LoadBitmaskRow(haystack_row, 0, static_cast<unsigned short>(y));
+    CountCandidates(range_x - needle_width + 1u);
+
+    bool is_complete = false;
+    needle.ScanRow(haystack_row.GetRow(0), range_x,
+                   [&](unsigned short x, unsigned short index_needle, unsigned short row_id) {
+      if (is_complete) return;
+
+      unsigned short state = column_rows[x]==y ? column_states[x] : static_cast<unsigned short>(0);
+      column_states[x] = state = needle.AdvanceColumn(index_needle, state, row_id);
+      column_rows[x] = y + 1;
+      if (state!=needle_height) return;
+
+      found.emplace_back(static_cast<unsigned short>(x - needle_width + 1),
+                         static_cast<unsigned short>(y - needle_height + 1));
+      is_complete = max_results > 0 && found.size()==max_results;
+    });
+
+    if (is_complete) return;
   }
 }
 
-std::string PixelScanner::FormatCoordinate(signed long offset_needle, unsigned short index_haystack_line) const {
-  return "x=" + std::to_string(x_start + offset_needle - 1) +
-      "; y=" + std::to_string(y_start + index_haystack_line - 1) + ";\n";
+// Templates of same color and tolerance: classified into one bitmask per haystack row, searched by a shared automaton
+struct PixelScanner::TemplateGroup {
+  ColorMatcher color_matcher;
+  BitmaskAutomaton automaton;
+  // Index within the library, per needle of the automaton
+  std::vector<unsigned short> indexes_templates;
+};
+
+// Find topmost (than leftmost) coordinate of each template of given library, output as "name: x=..; y=..;" lines.
+// All templates are searched in one pass over the rectangle, the candidate rows are split into bands, searched by
+// given amount of threads (0 = hardware concurrency). Returns false if none of the templates was found
+bool PixelScanner::FindTemplates(const TemplateLibrary &library, unsigned short amount_threads, std::ostream &out) {
+  const std::vector<BitmaskTemplate> &templates = library.GetTemplates();
+  auto amount_templates = static_cast<unsigned short>(templates.size());
+
+  // Group templates by color and tolerance
+  std::vector<std::vector<unsigned short>> indexes_groups;
+  for (unsigned short index = 0; index < amount_templates; ++index) {
+    const BitmaskTemplate &current = templates[index];
+    auto group = indexes_groups.begin();
+    for (; group!=indexes_groups.end(); ++group) {
+      const BitmaskTemplate &first = templates[group->front()];
+      if (first.red==current.red && first.green==current.green && first.blue==current.blue &&
+          first.tolerance==current.tolerance)
+        break;
+    }
+
+    if (group==indexes_groups.end()) {
+      indexes_groups.emplace_back(1, index);
+    } else {
+      group->push_back(index);
+    }
+  }
+
+  std::vector<TemplateGroup> groups;
+  for (const auto &indexes : indexes_groups) {
+    const BitmaskTemplate &first = templates[indexes.front()];
+    std::vector<const Bitmask *> bitmasks;
+    for (auto index : indexes) bitmasks.push_back(&templates[index].bitmask);
+
+    groups.push_back(TemplateGroup{ColorMatcher(first.red, first.green, first.blue, first.tolerance),
+                                   BitmaskAutomaton(bitmasks), indexes});
+  }
+
+  unsigned short min_height = range_y;
+  for (const auto &bitmask_template : templates) {
+    if (bitmask_template.bitmask.GetHeight() < min_height) min_height = bitmask_template.bitmask.GetHeight();
+  }
+
+  std::vector<int> found_x(amount_templates, -1);
+  std::vector<int> found_y(amount_templates, -1);
+
+  if (min_height > 0 && range_x > 0) {
+    auto amount_candidate_rows = static_cast<unsigned int>(range_y - min_height + 1);
+    unsigned int band_height;
+    unsigned int amount_bands;
+    InitBands(amount_candidate_rows, library.GetMaxHeight(), amount_threads, band_height, amount_bands);
+    CountThreads(amount_threads);
+
+    // Per band and template: coordinate of 1st occurrence
+    std::vector<int> found_x_per_band(static_cast<unsigned long>(amount_bands)*amount_templates, -1);
+    std::vector<int> found_y_per_band(static_cast<unsigned long>(amount_bands)*amount_templates, -1);
+
+    std::atomic<unsigned int> index_next_band(0);
+    // Per template: lowest band that found an occurrence, workers stop searching it in all later bands
+    std::vector<std::atomic<unsigned int>> indexes_first_found_bands(amount_templates);
+    for (auto &index_first_found_band : indexes_first_found_bands) index_first_found_band.store(amount_bands);
+
+    auto search_bands = [&]() {
+      ScanStats::Timer timer(stats, ScanStats::kPhaseWork);
+      std::vector<unsigned int> rgb_buffer(range_x);
+      unsigned int index_band;
+
+      while ((index_band = index_next_band++) < amount_bands) {
+        auto first_y = static_cast<unsigned short>(index_band*band_height);
+        auto last_y = static_cast<unsigned short>(
+            index_band*band_height + band_height > amount_candidate_rows
+            ? amount_candidate_rows - 1
+            : index_band*band_height + band_height - 1);
+
+        FindTemplatesInBand(templates, groups, library.GetMaxHeight(), first_y, last_y,
+                            index_band, indexes_first_found_bands,
+                            rgb_buffer.data(),
+                            &found_x_per_band[static_cast<unsigned long>(index_band)*amount_templates],
+                            &found_y_per_band[static_cast<unsigned long>(index_band)*amount_templates]);
+      }
+    };
+
+    if (amount_threads <= 1) {
+      search_bands();
+    } else {
+      std::vector<std::thread> workers;
+      for (unsigned short index = 0; index < amount_threads; ++index) workers.emplace_back(search_bands);
+      for (auto &worker : workers) worker.join();
+    }
+
+    for (unsigned short index = 0; index < amount_templates; ++index) {
+      unsigned int index_band = indexes_first_found_bands[index].load();
+      if (index_band==amount_bands) continue;
+
+      found_x[index] = found_x_per_band[static_cast<unsigned long>(index_band)*amount_templates + index];
+      found_y[index] = found_y_per_band[static_cast<unsigned long>(index_band)*amount_templates + index];
+    }
+  }
+
+  bool is_any_found = false;
+  for (unsigned short index = 0; index < amount_templates; ++index) {
+    out << templates[index].name << ": ";
+    if (found_x[index]==-1) {
+      out << kCoordinateNotFound << "\n";
+    } else {
+      out << FormatCoordinate(found_x[index], static_cast<unsigned short>(found_y[index]));
+      is_any_found = true;
+    }
+  }
+
+  return is_any_found;
+}
+
+// Find 1st occurrence of each template w/ its top row within given range of candidate rows (incl. last_y).
+// Each haystack row is decoded once, and classified once per group of templates.
+// Stops searching templates already found in an earlier band, and stops when all templates were found
+void PixelScanner::FindTemplatesInBand(const std::vector<BitmaskTemplate> &templates,
+                                       const std::vector<TemplateGroup> &groups,
+                                       unsigned short max_height,
+                                       unsigned short first_y,
+                                       unsigned short last_y,
+                                       unsigned int index_band,
+                                       std::vector<std::atomic<unsigned int>> &indexes_first_found_bands,
+                                       unsigned int *rgb_buffer,
+                                       int *found_x,
+                                       int *found_y) const {
+  auto amount_templates = static_cast<unsigned short>(templates.size());
+
+  Bitmask haystack_row(range_x, 1);
+  // Per group, needle and column: state and 1 + haystack row of the last needle row found in it
+  std::vector<std::vector<unsigned short>> column_states;
+  std::vector<std::vector<unsigned int>> column_rows;
+  for (const auto &group : groups) {
+    column_states.emplace_back(static_cast<unsigned long>(group.automaton.GetAmountNeedles())*range_x, 0);
+    column_rows.emplace_back(static_cast<unsigned long>(group.automaton.GetAmountNeedles())*range_x, 0);
+  }
+
+  auto last_scanned_y = static_cast<unsigned int>(last_y) + max_height - 1;
+  if (last_scanned_y >= range_y) last_scanned_y = static_cast<unsigned int>(range_y - 1);
+
+  for (unsigned int y = first_y; y <= last_scanned_y; ++y) {
+    unsigned short amount_pending = 0;
+    for (unsigned short index = 0; index < amount_templates; ++index) {
+      if (indexes_first_found_bands[index].load(std::memory_order_relaxed) > index_band) ++amount_pending;
+    }
+    if (amount_pending==0) return;
+
+    DecodeRow(static_cast<unsigned short>(y), rgb_buffer);
+
+    for (unsigned short index_group = 0; index_group < groups.size(); ++index_group) {
+      const TemplateGroup &group = groups[index_group];
+      unsigned short *states = column_states[index_group].data();
+      unsigned int *rows = column_rows[index_group].data();
+
+      group.color_matcher.MatchRow(rgb_buffer, range_x, haystack_row.GetRow(0));
+      CountCandidates(static_cast<unsigned long>(range_x)*group.automaton.GetAmountNeedles());
+      group.automaton.ScanRow(haystack_row.GetRow(0), range_x,
+                              [&](unsigned short x, unsigned short index_needle, unsigned short row_id) {
+        unsigned short index_template = group.indexes_templates[index_needle];
+        if (indexes_first_found_bands[index_template].load(std::memory_order_relaxed) <= index_band) return;
+
+        unsigned long index_column = static_cast<unsigned long>(index_needle)*range_x + x;
+        unsigned short state = rows[index_column]==y ? states[index_column] : static_cast<unsigned short>(0);
+        states[index_column] = state = group.automaton.AdvanceColumn(index_needle, state, row_id);
+        rows[index_column] = y + 1;
+
+        unsigned short height = group.automaton.GetHeight(index_needle);
+        if (state!=height || y - height + 1 > last_y) return;
+
+        found_x[index_template] = x - group.automaton.GetWidth(index_needle) + 1;
+        found_y[index_template] = static_cast<int>(y - height + 1);
+
+        unsigned int index_found = indexes_first_found_bands[index_template].load();
+        while (index_band < index_found &&
+            !indexes_first_found_bands[index_template].compare_exchange_weak(index_found, index_band)) {}
+      });
+    }
+  }
+}
+
+// Split given amount of candidate rows into bands, limit given amount of threads (0 = hardware concurrency) to them
+void PixelScanner::InitBands(unsigned int amount_candidate_rows,
+                             unsigned short needle_height,
+                             unsigned short &amount_threads,
+                             unsigned int &band_height,
+                             unsigned int &amount_bands) {
+  if (amount_threads==0) amount_threads = static_cast<unsigned short>(std::thread::hardware_concurrency());
+  if (amount_threads==0) amount_threads = 1;
+
+  // Several bands per thread, for balancing the load between threads finishing their bands early and others
+  band_height = amount_candidate_rows/(amount_threads*kBandsPerThread);
+  if (band_height < kMinBandHeight) band_height = kMinBandHeight;
+  if (band_height < needle_height) band_height = needle_height;
+
+  amount_bands = (amount_candidate_rows + band_height - 1)/band_height;
+  if (amount_threads > amount_bands) amount_threads = static_cast<unsigned short>(amount_bands);
+}
+
+// Search needle w/ its top row within given range of candidate rows (incl. last_y), rows are lazy-loaded.
+// Cancels as soon as an earlier band found an occurrence
+bool PixelScanner::FindBitmaskInBand(const BitmaskNeedle &needle,
+                                     unsigned short first_y,
+                                     unsigned short last_y,
+                                     unsigned int index_band,
+                                     const std::atomic<unsigned int> &index_first_found_band,
+                                     int &found_x,
+                                     int &found_y) const {
+  unsigned short needle_height = needle.GetHeight();
+  auto last_possible_x = static_cast<unsigned short>(range_x - needle.GetWidth());
+
+  // Band rows overlap w/ the following band by the needle's height
+  Bitmask haystack(range_x, static_cast<unsigned short>(last_y - first_y + needle_height));
+  unsigned short amount_rows_loaded = 0;
+
+  for (unsigned short y = 0; y <= last_y - first_y; ++y) {
+    if (index_first_found_band.load(std::memory_order_relaxed) < index_band) return false;
+
+    if (amount_rows_loaded <= y) {
+      LoadBitmaskRow(haystack, amount_rows_loaded, static_cast<unsigned short>(first_y + amount_rows_loaded));
+      ++amount_rows_loaded;
+    }
+    const uint64_t *haystack_row = haystack.GetRow(y);
+    CountCandidates(last_possible_x + 1u);
+
+    for (unsigned short x = 0; x <= last_possible_x; ++x) {
+      // Check 1st line of needle, than the following haystack lines under it
+      if (!needle.MatchesRow(haystack_row, x, 0)) continue;
+
+      unsigned short needle_y = 1;
+      for (; needle_y < needle_height; ++needle_y) {
+        auto haystack_y = static_cast<unsigned short>(y + needle_y);
+        if (amount_rows_loaded <= haystack_y) {
+          LoadBitmaskRow(haystack, amount_rows_loaded, static_cast<unsigned short>(first_y + amount_rows_loaded));
+          ++amount_rows_loaded;
+        }
+
+        if (!needle.MatchesRow(haystack.GetRow(haystack_y), x, needle_y)) break;
+      }
+
+      if (needle_y==needle_height) {
+        // All lines of needle were found within haystack
+        found_x = x;
+        found_y = first_y + y;
+
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+Match PixelScanner::GetMatch(signed long offset_needle, unsigned short index_haystack_line, int index_color) const {
+  Match match{};
+  match.x = static_cast<int>(x_start + offset_needle - 1);
+  match.y = y_start + index_haystack_line - 1;
+  match.index_color = index_color;
+
+  return match;
+}
+
+std::string PixelScanner::FormatMatch(const Match &match) {
+  return "x=" + std::to_string(match.x) + "; y=" + std::to_string(match.y) + ";" +
+      (match.index_color > -1 ? " color=" + std::to_string(match.index_color) + ";" : "") + "\n";
+}
+
+int PixelScanner::GetIndexOfMatchedColor(const Bitmask &needle, unsigned short x, unsigned short y) const {
+  unsigned short first_x, first_y;
+  if (!report_matched_color || !needle.FindFirstSet(first_x, first_y)) return -1;
+
+  return GetIndexOfMatchingColor(static_cast<unsigned short>(x + first_x), static_cast<unsigned short>(y + first_y));
 }
 
 } // namespace pixloc
@@ -32,38 +32,115 @@
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <utility>
 #include <vector>
 
+#include "pixloc/models/bitmask.h"
+#include "pixloc/models/bitmask_automaton.h"
+#include "pixloc/models/bitmask_needle.h"
+#include "pixloc/models/color_histogram.h"
 #include "pixloc/models/color_matcher.h"
+#include "pixloc/models/fingerprint.h"
+#include "pixloc/models/frame.h"
+#include "pixloc/models/frame_source.h"
+#include "pixloc/models/image_needle.h"
+#include "pixloc/models/output_buffer.h"
+#include "pixloc/models/pixel_decoder.h"
+#include "pixloc/models/scan_kernel.h"
+#include "pixloc/models/scan_stats.h"
+#include "pixloc/models/template_library.h"
 
 namespace pixloc {
+
+// Output of FindBitmask if the bitmask was not found
+static const char *const kCoordinateNotFound = "x=-1; y=-1;";
+
+// Occurrence of a needle: coordinate as output by FormatMatch, index of the matched sought color or -1
+struct Match {
+  int x;
+  int y;
+  int index_color;
+};
+
 class PixelScanner {
 
  public:
-  // Constructor
-  PixelScanner(Display *display,
+  // Constructor: scan given frame, captured from the rectangle at x_start,y_start of range_x * range_y pixels
+  PixelScanner(const Frame &frame,
+               const PixelDecoder *decoder,
                unsigned short x_start, unsigned short y_start,
                unsigned short range_x, unsigned short range_y,
-               unsigned short find_red, unsigned short find_green, unsigned short find_blue,
-               unsigned short tolerance);
+               const ColorMatcher &color_matcher);
+
+  // Collect timings and counters into given statistics, nullptr = don't collect
+  inline void SetStats(ScanStats *stats) { this->stats = stats; }
+
+  // Output index of the sought color matched by the 1st set pixel of found bitmasks, e.g. "x=99; y=49; color=1;"
+  inline void SetReportMatchedColor(bool report_matched_color) { this->report_matched_color = report_matched_color; }
+
+  // Get index of the sought color matched by the pixel at given offset within the scanned rectangle, or -1
+  inline int GetIndexOfMatchingColor(unsigned short x, unsigned short y) const {
+    return color_matcher->GetIndexOfMatchingColor(DecodePixel(x, y));
+  }
+
+  // Find given amount of consecutive matching pixels on x or y axis
+  int ScanUniaxial(unsigned short amount_find, unsigned short step_size);
+
+  // Output colors of pixels on x or y axis
+  void TraceUniaxial(unsigned short step_size, OutputBuffer::Format format, OutputBuffer &out);
 
-  // Scan pixels on x or y axis, trace or find
-  int ScanUniaxial(unsigned short amount_find, unsigned short step_size, bool trace);
+  void TraceMainColor(std::ostream &out, unsigned short amount_top = 0, unsigned short amount_threads = 1);
 
-  void TraceMainColor();
+  // Get given amount of most common colors w/ their amount of pixels, most common first
+  std::vector<std::pair<unsigned int, unsigned int>> GetMostCommonColors(unsigned short amount,
+                                                                         unsigned short amount_threads = 1);
 
-  void TraceBitmask();
+  void TraceBitmask(OutputBuffer::Format format, OutputBuffer &out);
+
+  // Get fingerprint of the scanned rectangle, decoding every pixel once
+  uint64_t GetFingerprint(Fingerprint::Kind kind);
+
+  std::string FindBitmask(const std::string &bitmask, unsigned short amount_threads = 1);
+  bool FindBitmask(const std::string &bitmask, unsigned short amount_threads, Match &match);
+
+  // Find bitmask within strips of the scanning rectangle's rows, handed top-down to the consumer given to the
+  // capture function. Rows are matched as soon as their strip arrives, capturing stops at the 1st occurrence
+  std::string FindBitmaskInStrips(const std::string &bitmask,
+                                  const std::function<void(const FrameSource::StripConsumer &)> &capture_strips);
+
+  std::string FindImage(const ImageNeedle &needle, unsigned short amount_threads = 1);
+  bool FindImage(const ImageNeedle &needle, unsigned short amount_threads, Match &match);
+
+  bool FindTemplates(const TemplateLibrary &library, unsigned short amount_threads, std::ostream &out);
+
+  bool FindAllBitmasks(const std::string &bitmask, unsigned int max_results, unsigned short amount_threads,
+                       std::ostream &out);
+  void FindAllBitmasks(const std::string &bitmask, unsigned int max_results, unsigned short amount_threads,
+                       std::vector<Match> &matches);
+
+  // Format given match, e.g. "x=99; y=49;\n" or "x=99; y=49; color=1;\n"
+  static std::string FormatMatch(const Match &match);
 
-  std::string FindBitmask(const std::string &bitmask);
   virtual ~PixelScanner();
 
  private:
-  Display *display;
-  XImage *image;
-  XColor *color;
+  // Parallel bitmask search: min. amount of candidate rows per band, and aimed amount of bands per thread
+  static const unsigned int kMinBandHeight = 16;
+  static const unsigned int kBandsPerThread = 4;
+
+  // Trace main color: min. amount of rows per thread, smaller frames are counted by less threads
+  static const unsigned int kMinHistogramBandHeight = 64;
+
+  Frame frame;
+  const PixelDecoder *decoder;
+
+  // Buffer of decoded row, reused for all rows
+  std::vector<unsigned int> rgb_row;
 
   unsigned short x_start;
   unsigned short y_start;
@@ -72,21 +149,77 @@ class PixelScanner {
 
   ColorMatcher *color_matcher;
 
+  // Fused decoding and matching of bitmask rows, specialized for the frame's layout and the matcher
+  ScanKernel *scan_kernel;
+
+  ScanStats *stats;
+
+  bool report_matched_color;
+
   void InitUniaxialStepSize(unsigned short step_size, unsigned short &step_size_x, unsigned short &step_size_y) const;
 
   signed short GetStartingValueOfHomochromaticSetAtCoordinate(unsigned short x,
                                                               unsigned short y,
                                                               unsigned short amount_find);
 
-  std::string GetBitmaskLineFromImage(unsigned short y);
+  const unsigned int *DecodeRow(unsigned short y);
+  void DecodeRow(unsigned short y, unsigned int *rgb_buffer) const;
+  void DecodeRow(const Frame &source_frame, unsigned short y, unsigned int *rgb_buffer) const;
+
+  inline void CountCandidates(unsigned long amount) const {
+    if (stats) stats->Add(ScanStats::kCounterCandidates, amount);
+  }
+
+  inline void CountThreads(unsigned short amount_threads) const {
+    if (stats) stats->SetMax(ScanStats::kCounterThreads, amount_threads);
+  }
+
+  inline unsigned int DecodePixel(unsigned short x, unsigned short y) const {
+    return decoder->Decode(frame.GetPixel(x, y));
+  }
+
+  void LoadBitmaskRow(Bitmask &bitmask, unsigned short bitmask_y, unsigned short frame_y) const;
+
+  bool FindBitmaskInBand(const BitmaskNeedle &needle,
+                         unsigned short first_y, unsigned short last_y,
+                         unsigned int index_band, const std::atomic<unsigned int> &index_first_found_band,
+                         int &found_x, int &found_y) const;
+
+  bool FindImageInBand(const ImageNeedle &needle,
+                       unsigned short first_y, unsigned short last_y,
+                       unsigned int index_band, const std::atomic<unsigned int> &index_first_found_band,
+                       std::vector<unsigned int> &band_rows,
+                       int &found_x, int &found_y) const;
+
+  struct TemplateGroup;
+
+  void FindTemplatesInBand(const std::vector<BitmaskTemplate> &templates,
+                           const std::vector<TemplateGroup> &groups,
+                           unsigned short max_height,
+                           unsigned short first_y, unsigned short last_y,
+                           unsigned int index_band, std::vector<std::atomic<unsigned int>> &indexes_first_found_bands,
+                           unsigned int *rgb_buffer,
+                           int *found_x, int *found_y) const;
+
+  void FindAllBitmasksInBand(const BitmaskAutomaton &needle,
+                             unsigned short first_y, unsigned short last_y,
+                             unsigned int max_results,
+                             std::vector<std::pair<unsigned short, unsigned short>> &found) const;
+
+  static void InitBands(unsigned int amount_candidate_rows, unsigned short needle_height,
+                        unsigned short &amount_threads, unsigned int &band_height, unsigned int &amount_bands);
+
+  // Get match at given offset within the scanned rectangle, w/ given index of matched color if it is not -1
+  Match GetMatch(signed long offset_needle, unsigned short index_haystack_line, int index_color = -1) const;
 
-  // Get line from bitmask haystack. this is lazy-loaded: initialize it via GetBitmaskLineFromImage if not yet
-  void FetchHaystackLine(std::vector<std::string> &haystack_lines,
-                         unsigned short &index_empty_haystack_line,
-                         unsigned short index_haystack_line,
-                         std::string &haystack_line);
+  inline std::string FormatCoordinate(signed long offset_needle, unsigned short index_haystack_line,
+                                      int index_color = -1) const {
+    return FormatMatch(GetMatch(offset_needle, index_haystack_line, index_color));
+  }
 
-  std::string FormatCoordinate(signed long offset_needle, unsigned short index_haystack_line) const;
+  // Get index of the color matched by the 1st set pixel of given bitmask found at given offset,
+  // or -1 if matched colors are not reported
+  int GetIndexOfMatchedColor(const Bitmask &needle, unsigned short x, unsigned short y) const;
 }; // class Scanner
 } // namespace pixloc
 
@@ -0,0 +1,101 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "raw_frame_source.h"
+
+namespace pixloc {
+
+// Constructor
+RawFrameSource::RawFrameSource(const std::string &path,
+                               const std::string &format,
+                               unsigned short width,
+                               unsigned short height,
+                               unsigned int stride) {
+  // Channel masks of pixel values read least significant byte first, e.g. bytes B,G,R,A => 0xAARRGGBB
+  unsigned long red_mask, blue_mask;
+  unsigned short bits_per_pixel;
+
+  if (format=="rgb" || format=="bgr") {
+    bits_per_pixel = 24;
+  } else if (format=="rgba" || format=="bgra" || format=="rgbx" || format=="bgrx") {
+    bits_per_pixel = 32;
+  } else {
+    throw "Raw input format must be rgb, bgr, rgba, bgra, rgbx or bgrx.";
+  }
+
+  if (format[0]=='r') {
+    red_mask = 0x0000ff;
+    blue_mask = 0xff0000;
+  } else {
+    red_mask = 0xff0000;
+    blue_mask = 0x0000ff;
+  }
+
+  if (width==0 || height==0) throw "Raw input dimension must be at least 1x1.";
+
+  unsigned int row_size = static_cast<unsigned int>(width)*(bits_per_pixel/8);
+  if (stride==0) stride = row_size;
+  if (stride < row_size) throw "Raw input stride is smaller than a row of pixels.";
+
+  int file_descriptor = open(path.c_str(), O_RDONLY);
+  if (file_descriptor==-1) throw "Failed to open raw input file.";
+
+  struct stat file_status{};
+  unsigned long required_size = static_cast<unsigned long>(stride)*(height - 1) + row_size;
+  if (fstat(file_descriptor, &file_status)==-1 || static_cast<unsigned long>(file_status.st_size) < required_size) {
+    close(file_descriptor);
+    throw "Raw input file is smaller than given dimension.";
+  }
+
+  this->mapped_size = static_cast<unsigned long>(file_status.st_size);
+  this->mapped_data = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  close(file_descriptor);
+  if (this->mapped_data==MAP_FAILED) throw "Failed to map raw input file.";
+
+  frame.data = static_cast<const unsigned char *>(mapped_data);
+  frame.width = width;
+  frame.height = height;
+  frame.stride = stride;
+  frame.bits_per_pixel = bits_per_pixel;
+  frame.is_lsb_first = true;
+
+  decoder = new PixelDecoder(red_mask, 0x00ff00, blue_mask);
+}
+
+// Destructor
+RawFrameSource::~RawFrameSource() {
+  munmap(this->mapped_data, this->mapped_size);
+}
+
+} // namespace pixloc
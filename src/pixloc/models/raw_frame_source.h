@@ -0,0 +1,59 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_RAW_FRAME_SOURCE
+#define CLASS_PIXLOC_RAW_FRAME_SOURCE
+
+#include <string>
+
+#include "pixloc/models/recorded_frame_source.h"
+
+namespace pixloc {
+
+// Recorded frame of a raw framebuffer dump, memory-mapped read-only: large dumps are scanned w/o being copied
+class RawFrameSource : public RecordedFrameSource {
+
+ public:
+  // Constructor: map file at given path, of given pixel format (rgb, bgr, rgba, bgra, rgbx, bgrx) and dimension.
+  // Stride 0 = rows w/o padding
+  RawFrameSource(const std::string &path, const std::string &format,
+                 unsigned short width, unsigned short height, unsigned int stride);
+
+  const char *GetName() const override { return "raw"; }
+
+  ~RawFrameSource() override;
+
+ private:
+  void *mapped_data;
+  unsigned long mapped_size;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_RAW_FRAME_SOURCE
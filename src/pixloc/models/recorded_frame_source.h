@@ -0,0 +1,59 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_RECORDED_FRAME_SOURCE
+#define CLASS_PIXLOC_RECORDED_FRAME_SOURCE
+
+#include "pixloc/models/frame_source.h"
+
+namespace pixloc {
+
+// Base of sources of a single recorded frame: captures are zero-copy views onto it
+class RecordedFrameSource : public FrameSource {
+
+ public:
+  Frame Capture(unsigned short x, unsigned short y, unsigned short width, unsigned short height) override;
+
+  const PixelDecoder *GetDecoder() const override { return decoder; }
+
+  unsigned short GetWidth() const override { return frame.width; }
+  unsigned short GetHeight() const override { return frame.height; }
+
+  void GetMousePosition(int &x, int &y) const override;
+
+  ~RecordedFrameSource() override;
+
+ protected:
+  Frame frame;
+  PixelDecoder *decoder = nullptr;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_RECORDED_FRAME_SOURCE
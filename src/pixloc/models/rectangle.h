@@ -0,0 +1,74 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_RECTANGLE
+#define CLASS_PIXLOC_RECTANGLE
+
+namespace pixloc {
+
+// Screen rectangle
+struct Rectangle {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+
+  Rectangle() = default;
+
+  Rectangle(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
+
+  inline long GetArea() const { return static_cast<long>(width)*height; }
+
+  inline bool IsEmpty() const { return width <= 0 || height <= 0; }
+
+  inline bool Contains(const Rectangle &other) const {
+    return other.x >= x && other.y >= y && other.x + other.width <= x + width && other.y + other.height <= y + height;
+  }
+
+  inline bool Intersects(const Rectangle &other) const {
+    return other.x < x + width && x < other.x + other.width && other.y < y + height && y < other.y + other.height;
+  }
+
+  // Get bounding box of this and given rectangle
+  inline Rectangle Merge(const Rectangle &other) const {
+    if (IsEmpty()) return other;
+    if (other.IsEmpty()) return *this;
+
+    int left = x < other.x ? x : other.x;
+    int top = y < other.y ? y : other.y;
+    int right = x + width > other.x + other.width ? x + width : other.x + other.width;
+    int bottom = y + height > other.y + other.height ? y + height : other.y + other.height;
+
+    return Rectangle(left, top, right - left, bottom - top);
+  }
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_RECTANGLE
@@ -0,0 +1,297 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PIXLOC_HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#include "scan_kernel.h"
+
+namespace pixloc {
+
+// Pixels of unsupported sizes are decoded as black, like by PixelDecoder::DecodeRow()
+struct ScanKernel::UnsupportedLayout {
+  static const unsigned short kBytesPerPixel = 0;
+
+  UnsupportedLayout(const PixelDecoder &, bool) {}
+
+  inline unsigned int Decode(const unsigned char *) const { return 0; }
+};
+
+struct ScanKernel::ExactMatcher {
+  unsigned int rgb;
+
+  explicit ExactMatcher(const ColorMatcher &color_matcher) : rgb(color_matcher.packed_min) {}
+
+  inline uint64_t MatchChunk(const unsigned int *rgb_chunk, unsigned short amount, Baseline) const {
+    uint64_t bits = 0;
+    unsigned short x = 0;
+#ifdef __SSE2__
+    const __m128i find = _mm_set1_epi32(static_cast<int>(rgb));
+
+    for (; x + 4 <= amount; x += 4) {
+      __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb_chunk + x));
+      bits |= static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(pixels, find)))) << x;
+    }
+#endif
+    for (; x < amount; ++x) bits |= static_cast<uint64_t>(rgb_chunk[x]==rgb) << x;
+
+    return bits;
+  }
+
+#ifdef PIXLOC_HAS_X86_KERNELS
+  __attribute__((target("avx2")))
+  inline uint64_t MatchChunk(const unsigned int *rgb_chunk, unsigned short amount, Avx2) const {
+    const __m256i find = _mm256_set1_epi32(static_cast<int>(rgb));
+    uint64_t bits = 0;
+    unsigned short x = 0;
+
+    for (; x + 8 <= amount; x += 8) {
+      __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rgb_chunk + x));
+      bits |= static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(pixels, find)))) << x;
+    }
+    for (; x < amount; ++x) bits |= static_cast<uint64_t>(rgb_chunk[x]==rgb) << x;
+
+    return bits;
+  }
+#endif
+};
+
+// Per byte: min <= value <= max, see ColorMatcher::MatchRowSse2()
+struct ScanKernel::RangeMatcher {
+  unsigned int packed_min;
+  unsigned int packed_max;
+  // Per channel: min. value and width of the range, compared w/ unsigned wrap-around instead of branching
+  unsigned int red_min, red_span, green_min, green_span, blue_min, blue_span;
+
+  explicit RangeMatcher(const ColorMatcher &color_matcher)
+      : packed_min(color_matcher.packed_min), packed_max(color_matcher.packed_max),
+        red_min(color_matcher.red_min), red_span(color_matcher.red_max - color_matcher.red_min),
+        green_min(color_matcher.green_min), green_span(color_matcher.green_max - color_matcher.green_min),
+        blue_min(color_matcher.blue_min), blue_span(color_matcher.blue_max - color_matcher.blue_min) {}
+
+  inline bool Matches(unsigned int rgb) const {
+    return (((rgb >> 16) & 0xff) - red_min <= red_span) &
+        (((rgb >> 8) & 0xff) - green_min <= green_span) &
+        ((rgb & 0xff) - blue_min <= blue_span);
+  }
+
+  inline uint64_t MatchChunk(const unsigned int *rgb_chunk, unsigned short amount, Baseline) const {
+    uint64_t bits = 0;
+    unsigned short x = 0;
+#ifdef __SSE2__
+    const __m128i min = _mm_set1_epi32(static_cast<int>(packed_min));
+    const __m128i max = _mm_set1_epi32(static_cast<int>(packed_max));
+    const __m128i all_set = _mm_set1_epi32(-1);
+
+    for (; x + 4 <= amount; x += 4) {
+      __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb_chunk + x));
+      __m128i in_range = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(pixels, min), pixels),
+                                       _mm_cmpeq_epi8(_mm_min_epu8(pixels, max), pixels));
+      bits |= static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(in_range, all_set)))) << x;
+    }
+#endif
+    for (; x < amount; ++x) bits |= static_cast<uint64_t>(Matches(rgb_chunk[x])) << x;
+
+    return bits;
+  }
+
+#ifdef PIXLOC_HAS_X86_KERNELS
+  __attribute__((target("avx2")))
+  inline uint64_t MatchChunk(const unsigned int *rgb_chunk, unsigned short amount, Avx2) const {
+    const __m256i min = _mm256_set1_epi32(static_cast<int>(packed_min));
+    const __m256i max = _mm256_set1_epi32(static_cast<int>(packed_max));
+    const __m256i all_set = _mm256_set1_epi32(-1);
+    uint64_t bits = 0;
+    unsigned short x = 0;
+
+    for (; x + 8 <= amount; x += 8) {
+      __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rgb_chunk + x));
+      __m256i in_range = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(pixels, min), pixels),
+                                          _mm256_cmpeq_epi8(_mm256_min_epu8(pixels, max), pixels));
+      bits |= static_cast<uint64_t>(
+          _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(in_range, all_set)))) << x;
+    }
+    for (; x < amount; ++x) bits |= static_cast<uint64_t>(Matches(rgb_chunk[x])) << x;
+
+    return bits;
+  }
+#endif
+};
+
+// Lookups of colors are independent of the instruction set. Cells w/o matching colors are skipped early
+struct ScanKernel::LookupMatcher {
+  const ColorMatcher::Lookup *lookup;
+
+  explicit LookupMatcher(const ColorMatcher &color_matcher) : lookup(color_matcher.lookup.get()) {}
+
+  inline uint64_t MatchChunk(const unsigned int *rgb_chunk, unsigned short amount, Baseline) const {
+    uint64_t bits = 0;
+    for (unsigned short x = 0; x < amount; ++x) bits |= static_cast<uint64_t>(lookup->Contains(rgb_chunk[x])) << x;
+
+    return bits;
+  }
+
+  inline uint64_t MatchChunk(const unsigned int *rgb_chunk, unsigned short amount, Avx2) const {
+    return MatchChunk(rgb_chunk, amount, Baseline());
+  }
+};
+
+// Constructor
+ScanKernel::ScanKernel(const PixelDecoder &decoder,
+                       const ColorMatcher &color_matcher,
+                       unsigned short bits_per_pixel,
+                       bool is_lsb_first,
+                       const char *instruction_set) {
+  this->decoder = &decoder;
+  this->color_matcher = &color_matcher;
+  this->bits_per_pixel = bits_per_pixel;
+  this->is_lsb_first = is_lsb_first;
+#ifdef PIXLOC_HAS_X86_KERNELS
+  this->is_avx2 = strcmp(instruction_set, "avx2")==0;
+#else
+  this->is_avx2 = false;
+#endif
+
+  this->layout = decoder.GetLayout(bits_per_pixel, is_lsb_first);
+
+  if (color_matcher.lookup)
+    this->matcher = kMatcherLookup;
+  else
+    this->matcher = color_matcher.packed_min==color_matcher.packed_max ? kMatcherExact : kMatcherRange;
+
+  const char *layout_name;
+  switch (layout) {
+    case PixelDecoder::kLayoutBgrx32:
+      layout_name = "bgrx32";
+      this->match_row = SelectMatcher<PixelDecoder::Bgrx32Layout>();
+      break;
+    case PixelDecoder::kLayoutBgr24:
+      layout_name = "bgr24";
+      this->match_row = SelectMatcher<PixelDecoder::Bgr24Layout>();
+      break;
+    case PixelDecoder::kLayoutRgb565:
+      layout_name = "rgb565";
+      this->match_row = SelectMatcher<PixelDecoder::Rgb565Layout>();
+      break;
+    default:
+      layout_name = "masked";
+      switch (bits_per_pixel) {
+        case 32:this->match_row = SelectMatcher<PixelDecoder::MaskedLayout<32>>();
+          break;
+        case 24:this->match_row = SelectMatcher<PixelDecoder::MaskedLayout<24>>();
+          break;
+        case 16:this->match_row = SelectMatcher<PixelDecoder::MaskedLayout<16>>();
+          break;
+        case 8:this->match_row = SelectMatcher<PixelDecoder::MaskedLayout<8>>();
+          break;
+        default:this->match_row = SelectMatcher<UnsupportedLayout>();
+      }
+  }
+
+  const char *const matcher_names[] = {"exact", "range", "lookup"};
+#ifdef __SSE2__
+  const char *baseline_name = "sse2";
+#else
+  const char *baseline_name = "scalar";
+#endif
+
+  this->name = std::string(layout_name) + "/" + matcher_names[matcher] + "/" + (is_avx2 ? "avx2" : baseline_name);
+}
+
+const char *ScanKernel::GetName() const {
+  return name.c_str();
+}
+
+template<class LayoutDecoder>
+ScanKernel::MatchRowFunction ScanKernel::SelectMatcher() const {
+  switch (matcher) {
+    case kMatcherExact:
+      return is_avx2 ? MatchRowOfAvx2<LayoutDecoder, ExactMatcher> : MatchRowOf<LayoutDecoder, ExactMatcher>;
+    case kMatcherRange:
+      return is_avx2 ? MatchRowOfAvx2<LayoutDecoder, RangeMatcher> : MatchRowOf<LayoutDecoder, RangeMatcher>;
+    default:
+      return is_avx2 ? MatchRowOfAvx2<LayoutDecoder, LookupMatcher> : MatchRowOf<LayoutDecoder, LookupMatcher>;
+  }
+}
+
+// Decode chunks of 64 pixels into a buffer kept in L1 cache, classify each chunk into a word of the bitmap
+template<class LayoutDecoder, class RowMatcher, class InstructionSet>
+inline void ScanKernel::MatchRowInChunks(const ScanKernel &kernel,
+                                         const unsigned char *row,
+                                         unsigned short width,
+                                         uint64_t *bitmap) {
+  const LayoutDecoder layout_decoder(*kernel.decoder, kernel.is_lsb_first);
+  const RowMatcher row_matcher(*kernel.color_matcher);
+  unsigned int rgb_chunk[64];
+
+  for (unsigned int offset = 0; offset < width; offset += 64) {
+    auto amount = static_cast<unsigned short>(width - offset < 64 ? width - offset : 64);
+
+    PixelDecoder::DecodeRowOfLayout(layout_decoder, row + offset*LayoutDecoder::kBytesPerPixel, amount, rgb_chunk);
+    bitmap[offset >> 6] = row_matcher.MatchChunk(rgb_chunk, amount, InstructionSet());
+  }
+}
+
+template<class LayoutDecoder, class RowMatcher>
+void ScanKernel::MatchRowOf(const ScanKernel &kernel,
+                            const unsigned char *row,
+                            unsigned short width,
+                            uint64_t *bitmap) {
+  MatchRowInChunks<LayoutDecoder, RowMatcher, Baseline>(kernel, row, width, bitmap);
+}
+
+#ifdef PIXLOC_HAS_X86_KERNELS
+
+// Decoding is compiled for AVX2 as well
+template<class LayoutDecoder, class RowMatcher>
+__attribute__((target("avx2")))
+void ScanKernel::MatchRowOfAvx2(const ScanKernel &kernel,
+                                const unsigned char *row,
+                                unsigned short width,
+                                uint64_t *bitmap) {
+  MatchRowInChunks<LayoutDecoder, RowMatcher, Avx2>(kernel, row, width, bitmap);
+}
+
+#else
+
+template<class LayoutDecoder, class RowMatcher>
+void ScanKernel::MatchRowOfAvx2(const ScanKernel &kernel,
+                                const unsigned char *row,
+                                unsigned short width,
+                                uint64_t *bitmap) {
+  MatchRowInChunks<LayoutDecoder, RowMatcher, Baseline>(kernel, row, width, bitmap);
+}
+
+#endif //PIXLOC_HAS_X86_KERNELS
+
+} // namespace pixloc
@@ -0,0 +1,115 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_SCAN_KERNEL
+#define CLASS_PIXLOC_SCAN_KERNEL
+
+#include <cstdint>
+#include <string>
+
+#include "pixloc/models/color_matcher.h"
+#include "pixloc/models/pixel_decoder.h"
+
+namespace pixloc {
+
+// Decodes and classifies rows of raw pixels into bitmaps at once, compiled per pixel layout (see
+// PixelDecoder::Layout), per matcher (exact color, channel bounds or lookup) and per instruction set.
+// The instantiation is selected once at construction: within a row, decoding and matching are inlined and branch-free
+class ScanKernel {
+
+ public:
+  enum Matcher {
+    kMatcherExact,   // Single color w/o tolerance
+    kMatcherRange,   // Single color w/ per-channel tolerances: channel bounds
+    kMatcherLookup   // Perceptual distances or several colors: lookup table
+  };
+
+  // Constructor: classify rows of frames of given pixel size and byte order, decoded by given decoder, by given
+  // matcher (which must outlive the kernel). Instruction set: "avx2", or the baseline one for other names
+  ScanKernel(const PixelDecoder &decoder, const ColorMatcher &color_matcher,
+             unsigned short bits_per_pixel, bool is_lsb_first,
+             const char *instruction_set = ColorMatcher::GetBestMatchRowKernelName());
+
+  // Set bit x%64 of bitmap word x/64 for every matching pixel x of given row of raw pixels
+  inline void MatchRow(const unsigned char *row, unsigned short width, uint64_t *bitmap) const {
+    match_row(*this, row, width, bitmap);
+  }
+
+  inline PixelDecoder::Layout GetLayout() const { return layout; }
+  inline Matcher GetMatcher() const { return matcher; }
+
+  // Name of the instantiation, e.g. "bgrx32/range/avx2"
+  const char *GetName() const;
+
+ private:
+  typedef void (*MatchRowFunction)(const ScanKernel &kernel, const unsigned char *row, unsigned short width,
+                                   uint64_t *bitmap);
+
+  const PixelDecoder *decoder;
+  const ColorMatcher *color_matcher;
+
+  unsigned short bits_per_pixel;
+  bool is_lsb_first;
+  bool is_avx2;
+
+  PixelDecoder::Layout layout;
+  Matcher matcher;
+
+  MatchRowFunction match_row;
+
+  std::string name;
+
+  template<class LayoutDecoder> MatchRowFunction SelectMatcher() const;
+
+  // Row loop shared by the instantiations of all instruction sets, inlined into their functions
+  template<class LayoutDecoder, class RowMatcher, class InstructionSet>
+  static inline void MatchRowInChunks(const ScanKernel &kernel, const unsigned char *row, unsigned short width,
+                                      uint64_t *bitmap) __attribute__((always_inline));
+
+  template<class LayoutDecoder, class RowMatcher>
+  static void MatchRowOf(const ScanKernel &kernel, const unsigned char *row, unsigned short width, uint64_t *bitmap);
+
+  template<class LayoutDecoder, class RowMatcher>
+  static void MatchRowOfAvx2(const ScanKernel &kernel, const unsigned char *row, unsigned short width,
+                             uint64_t *bitmap);
+
+  // Instruction sets, selecting the matchers' chunk functions
+  struct Baseline {};
+  struct Avx2 {};
+
+  struct UnsupportedLayout;
+
+  struct ExactMatcher;
+  struct RangeMatcher;
+  struct LookupMatcher;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_SCAN_KERNEL
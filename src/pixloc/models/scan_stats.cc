@@ -0,0 +1,67 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdio>
+
+#include "scan_stats.h"
+
+namespace pixloc {
+
+// Constructor
+ScanStats::ScanStats() {
+  for (auto &duration : durations) duration.store(0);
+  for (auto &counter : counters) counter.store(0);
+}
+
+void ScanStats::SetMax(Counter counter, uint64_t amount) {
+  uint64_t current = counters[counter].load();
+  while (current < amount && !counters[counter].compare_exchange_weak(current, amount)) {}
+}
+
+std::string ScanStats::FormatJson() const {
+  auto milliseconds = [this](Phase phase) { return static_cast<double>(durations[phase].load())/1000000; };
+  auto count = [this](Counter counter) { return static_cast<unsigned long long>(counters[counter].load()); };
+
+  double work = milliseconds(kPhaseWork);
+  double decode = milliseconds(kPhaseDecode);
+
+  char json[640];
+  snprintf(json, sizeof(json),
+           "{\"open_display_ms\":%.3f,\"resolve_ms\":%.3f,\"capture_ms\":%.3f,\"scan_ms\":%.3f,\"decode_ms\":%.3f,"
+           "\"match_ms\":%.3f,\"total_ms\":%.3f,\"captures\":%llu,\"pixels_decoded\":%llu,\"candidates\":%llu,"
+           "\"threads\":%llu,\"x_requests\":%llu,\"bytes_transferred\":%llu,\"cache_hits\":%llu}",
+           milliseconds(kPhaseOpenDisplay), milliseconds(kPhaseResolve), milliseconds(kPhaseCapture),
+           milliseconds(kPhaseScan), decode, work > decode ? work - decode : 0, milliseconds(kPhaseTotal),
+           count(kCounterCaptures), count(kCounterPixelsDecoded), count(kCounterCandidates), count(kCounterThreads),
+           count(kCounterXRequests), count(kCounterBytesTransferred), count(kCounterCacheHits));
+
+  return json;
+}
+
+} // namespace pixloc
@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_SCAN_STATS
+#define CLASS_PIXLOC_SCAN_STATS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace pixloc {
+
+// Monotonic timings of the phases of running queries, and counters of the work done. Thread-safe.
+// Collecting is optional: instrumented code holds a pointer to the statistics, which is nullptr if they are not
+// collected, so the overhead then is a pointer comparison per row
+class ScanStats {
+
+ public:
+  enum Phase {
+    kPhaseOpenDisplay,  // Open display or recorded frame, init. capture backend and pixel decoder
+    kPhaseResolve,      // Resolve and validate query, incl. loading needle files
+    kPhaseCapture,      // Capture scanning rectangles
+    kPhaseScan,         // Scan captured frames, wall-clock
+    kPhaseDecode,       // Decode rows of pixels, summed over all threads
+    kPhaseWork,         // Decode and match, summed over all threads
+    kPhaseTotal,
+    kAmountPhases
+  };
+
+  enum Counter {
+    kCounterCaptures,
+    kCounterPixelsDecoded,
+    kCounterCandidates,         // Positions examined for a needle, resp. pixels examined in uniaxial modes
+    kCounterThreads,            // Max. amount of threads that scanned a frame
+    kCounterXRequests,
+    kCounterBytesTransferred,   // Pixel data received from the X server
+    kCounterCacheHits,          // Captures replaced by frames cached by earlier processes
+    kAmountCounters
+  };
+
+  // Measure duration of a phase from construction until destruction, if given statistics are collected
+  class Timer {
+
+   public:
+    // Constructor
+    Timer(ScanStats *stats, Phase phase) : stats(stats), phase(phase), start(stats ? Now() : 0) {}
+
+    // Destructor
+    ~Timer() {
+      if (stats) stats->Add(phase, Now() - start);
+    }
+
+   private:
+    ScanStats *stats;
+    Phase phase;
+    uint64_t start;
+  };
+
+  // Constructor
+  ScanStats();
+
+  // Current monotonic time in nanoseconds
+  static inline uint64_t Now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  inline void Add(Phase phase, uint64_t nanoseconds) {
+    durations[phase].fetch_add(nanoseconds, std::memory_order_relaxed);
+  }
+
+  inline void Add(Counter counter, uint64_t amount) {
+    counters[counter].fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  void SetMax(Counter counter, uint64_t amount);
+  inline void Set(Counter counter, uint64_t amount) { counters[counter].store(amount); }
+
+  // Single line JSON object of all timings in milliseconds and all counters. Match time: work time minus decoding
+  std::string FormatJson() const;
+
+ private:
+  std::atomic<uint64_t> durations[kAmountPhases];
+  std::atomic<uint64_t> counters[kAmountCounters];
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_SCAN_STATS
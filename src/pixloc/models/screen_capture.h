@@ -0,0 +1,58 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_SCREEN_CAPTURE
+#define CLASS_PIXLOC_SCREEN_CAPTURE
+
+#include <X11/Xlib.h>
+#include <string>
+
+#include "pixloc/models/frame.h"
+
+namespace pixloc {
+
+// Interface of backends capturing a rectangle of the root window
+class ScreenCapture {
+
+ public:
+  // Create best available backend: MIT-SHM if supported by the X server, XGetImage otherwise.
+  // Or create the backend of given name: xshm or xgetimage, throws if it is unknown or not supported
+  static ScreenCapture *Create(Display *display, const std::string &name = "");
+
+  // Capture given rectangle. The returned frame remains valid until the next capture or destruction of the backend
+  virtual Frame Capture(unsigned short x, unsigned short y, unsigned short width, unsigned short height) = 0;
+
+  virtual const char *GetName() const = 0;
+
+  virtual ~ScreenCapture() = default;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_SCREEN_CAPTURE
@@ -0,0 +1,416 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <X11/Xlib.h>
+#include <chrono>
+#include <sstream>
+
+#include "session.h"
+#include "pixloc/models/damage_monitor.h"
+#include "pixloc/models/pixel_scanner.h"
+
+namespace pixloc {
+
+// Constructor
+Session::Session(const std::string &input) {
+  this->source = FrameSource::Create(input);
+  this->stats = nullptr;
+  this->frame_cache = nullptr;
+}
+
+// Destructor
+Session::~Session() {
+  delete this->frame_cache;
+  delete this->source;
+}
+
+int Session::Run(const clioptions::Arguments &arguments, std::ostream &out, std::ostream &err) {
+  clioptions::Query query;
+
+  try {
+    {
+      ScanStats::Timer timer(stats, ScanStats::kPhaseResolve);
+      clioptions::ResolveQuery(arguments, *source, query);
+    }
+    if (!Run(query, out) && (query.wait_ms > 0 || query.is_fingerprint_compared)) return 1;
+  } catch (char const *exception) {
+    err << "Error: " << exception << "\nFor help run: pixloc -h\n\n";
+    return -1;
+  }
+
+  return 0;
+}
+
+bool Session::Run(const clioptions::Query &query, std::ostream &out) {
+  if (query.mode_id==clioptions::kModeIdTraceMouse) {
+    WriteMousePosition(query, out);
+    return true;
+  }
+
+  if (query.wait_ms > 0) return RunUntilFound(query, out);
+
+  return RunOnRectangle(query, GetScanningRectangle(query), out);
+}
+
+bool Session::RunOnRectangle(const clioptions::Query &query, const Rectangle &rectangle, std::ostream &out) {
+  if (query.strip_height > 0) return RunOnStrips(query, rectangle, out);
+
+  // Release a frame looked up in the cache also if scanning throws, its lock would block publishers until exiting
+  struct CacheReleaser {
+    FrameCache *&frame_cache;
+
+    ~CacheReleaser() {
+      if (frame_cache) frame_cache->Release();
+    }
+  } cache_releaser{frame_cache};
+
+  return RunOnFrame(query, Capture(rectangle, query.max_age_ms), out);
+}
+
+bool Session::RunOnStrips(const clioptions::Query &query, const Rectangle &rectangle, std::ostream &out) {
+  PixelScanner scanner(
+      Frame(),
+      source->GetDecoder(),
+      static_cast<unsigned short>(query.from_x), static_cast<unsigned short>(query.from_y),
+      static_cast<unsigned short>(query.range_x), static_cast<unsigned short>(query.range_y),
+      ColorMatcher(query.colors));
+  scanner.SetStats(stats);
+  scanner.SetReportMatchedColor(query.report_matched_color);
+
+  uint64_t start = stats ? ScanStats::Now() : 0;
+  uint64_t scan_duration = 0;
+
+  std::string coordinate = scanner.FindBitmaskInStrips(query.bitmask, [&](const FrameSource::StripConsumer &consume) {
+    source->CaptureStrips(static_cast<unsigned short>(rectangle.x), static_cast<unsigned short>(rectangle.y),
+                          static_cast<unsigned short>(rectangle.width), static_cast<unsigned short>(rectangle.height),
+                          query.strip_height,
+                          [&](const Frame &strip, unsigned short strip_y) {
+                            if (!stats) return consume(strip, strip_y);
+
+                            stats->Add(ScanStats::kCounterCaptures, 1);
+                            if (source->GetDisplay()) stats->Add(ScanStats::kCounterBytesTransferred,
+                                                                 static_cast<uint64_t>(strip.stride)*strip.height);
+
+                            uint64_t start_scan = ScanStats::Now();
+                            bool is_continued = consume(strip, strip_y);
+                            scan_duration += ScanStats::Now() - start_scan;
+
+                            return is_continued;
+                          });
+  });
+
+  if (stats) {
+    stats->Add(ScanStats::kPhaseScan, scan_duration);
+    // Time spent waiting for strips, not overlapped by scanning
+    stats->Add(ScanStats::kPhaseCapture, ScanStats::Now() - start - scan_duration);
+  }
+
+  out << coordinate;
+
+  return coordinate!=kCoordinateNotFound;
+}
+
+bool Session::RunUntilFound(const clioptions::Query &query, std::ostream &out) {
+  Rectangle rectangle = GetScanningRectangle(query);
+
+  // Recorded frames never change
+  if (!source->GetDisplay()) return RunOnRectangle(query, rectangle, out);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(query.wait_ms);
+
+  // Start monitoring before the 1st capture, so no change in between gets lost
+  DamageMonitor damage_monitor(source->GetDisplay(), rectangle);
+
+  while (true) {
+    std::ostringstream output;
+    bool is_found = RunOnRectangle(query, rectangle, output);
+
+    auto remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    if (is_found || remaining_ms <= 0) {
+      out << output.str();
+      return is_found;
+    }
+
+    damage_monitor.Wait(static_cast<long>(remaining_ms));
+    // The cached frame is outdated now, also for other processes
+    if (frame_cache) frame_cache->Invalidate();
+  }
+}
+
+Frame Session::Capture(const Rectangle &rectangle, long max_age_ms) {
+  ScanStats::Timer timer(stats, ScanStats::kPhaseCapture);
+  Frame frame;
+
+  if (max_age_ms > 0 && source->GetDisplay()) {
+    if (!frame_cache) frame_cache = new FrameCache(source->GetDisplay());
+
+    if (frame_cache->Lookup(static_cast<unsigned short>(rectangle.x), static_cast<unsigned short>(rectangle.y),
+                            static_cast<unsigned short>(rectangle.width),
+                            static_cast<unsigned short>(rectangle.height),
+                            max_age_ms, frame)) {
+      if (stats) stats->Add(ScanStats::kCounterCacheHits, 1);
+
+      return frame;
+    }
+  }
+
+  uint64_t captured_ns = ScanStats::Now();
+  frame = source->Capture(static_cast<unsigned short>(rectangle.x), static_cast<unsigned short>(rectangle.y),
+                          static_cast<unsigned short>(rectangle.width),
+                          static_cast<unsigned short>(rectangle.height));
+
+  if (max_age_ms > 0 && frame_cache)
+    frame_cache->Publish(frame, static_cast<unsigned short>(rectangle.x), static_cast<unsigned short>(rectangle.y),
+                         captured_ns);
+
+  if (stats) {
+    stats->Add(ScanStats::kCounterCaptures, 1);
+    // Recorded frames are mapped, not transferred
+    if (source->GetDisplay()) stats->Add(ScanStats::kCounterBytesTransferred,
+                                         static_cast<uint64_t>(frame.stride)*frame.height);
+  }
+
+  return frame;
+}
+
+void Session::FinishStats() {
+  if (stats && source->GetDisplay())
+    stats->Set(ScanStats::kCounterXRequests, XNextRequest(source->GetDisplay()) - 1);
+}
+
+bool Session::RunOnFrame(const clioptions::Query &query, const Frame &frame, std::ostream &out) {
+  // Formats other than text are parsed by tools, which are not expecting the mouse position
+  if (query.is_trace_mode && query.use_mouse_for_from && query.output_format==OutputBuffer::kFormatText)
+    WriteMousePosition(query, out);
+
+  ScanStats::Timer timer(stats, ScanStats::kPhaseScan);
+  PixelScanner scanner(
+      frame,
+      source->GetDecoder(),
+      static_cast<unsigned short>(query.from_x), static_cast<unsigned short>(query.from_y),
+      static_cast<unsigned short>(query.range_x), static_cast<unsigned short>(query.range_y),
+      ColorMatcher(query.colors));
+  scanner.SetStats(stats);
+  scanner.SetReportMatchedColor(query.report_matched_color);
+
+  if (query.mode_id==clioptions::kModeIdTraceMainColor) {
+    scanner.TraceMainColor(out, query.amount_top, query.amount_threads);
+  } else if (query.mode_id==clioptions::kModeIdFingerprint) {
+    uint64_t fingerprint = scanner.GetFingerprint(query.fingerprint_kind);
+    out << Fingerprint::Format(fingerprint);
+
+    return !query.is_fingerprint_compared ||
+        Fingerprint::CountDifferingBits(fingerprint, query.compared_fingerprint) <= query.max_differing_bits;
+  } else if (query.mode_id==clioptions::kModeIdFindImage) {
+    std::string coordinate = scanner.FindImage(ImageNeedle(*query.image, query.color_tolerance), query.amount_threads);
+    out << coordinate;
+
+    return coordinate!=kCoordinateNotFound;
+  } else if (query.mode_id==clioptions::kModeIdFindLibrary) {
+    return scanner.FindTemplates(*query.library, query.amount_threads, out);
+  } else if (query.mode_id==clioptions::kModeIdFindAllBitmask) {
+    return scanner.FindAllBitmasks(query.bitmask, query.max_results, query.amount_threads, out);
+  } else if (query.is_bitmask_mode) {
+    if (query.is_trace_mode) {
+      OutputBuffer output(out);
+      scanner.TraceBitmask(query.output_format, output);
+    } else {
+      std::string coordinate = scanner.FindBitmask(query.bitmask, query.amount_threads);
+      out << coordinate;
+
+      return coordinate!=kCoordinateNotFound;
+    }
+  } else if (query.is_trace_mode) {
+    OutputBuffer output(out);
+    scanner.TraceUniaxial(query.step_size, query.output_format, output);
+  } else {
+    int location = scanner.ScanUniaxial(query.amount_px, query.step_size);
+    out << (query.range_y < 2 ? "x:" : "y:") << location << ";";
+    if (query.report_matched_color && location > -1)
+      out << " color=" << (query.range_y < 2
+                           ? scanner.GetIndexOfMatchingColor(static_cast<unsigned short>(location), 0)
+                           : scanner.GetIndexOfMatchingColor(0, static_cast<unsigned short>(location))) << ";";
+
+    return location > -1;
+  }
+
+  return true;
+}
+
+int Session::RunBatch(std::istream &in, std::ostream &out, std::ostream &err) {
+  std::vector<BatchEntry> entries;
+  std::string line;
+  unsigned long line_number = 0;
+
+  // 1. Resolve and validate all queries
+  while (std::getline(in, line)) {
+    ++line_number;
+    if (!line.empty() && line[line.length() - 1]=='\r') line.erase(line.length() - 1);
+    if (line.empty() || line[0]=='#') continue;
+
+    BatchEntry entry;
+    entry.line_number = line_number;
+    entry.is_failed = false;
+    entry.index_capture = -1;
+
+    clioptions::Arguments arguments;
+    std::string error_message;
+    if (!clioptions::ParseArgumentsLine(line, arguments, error_message)) {
+      entry.is_failed = true;
+      entry.output = "Error in command line: " + error_message;
+    } else {
+      try {
+        if (!arguments.input.empty()) throw "Input is not available in batch queries.";
+        if (arguments.stats) throw "Statistics are not available in batch queries.";
+        ScanStats::Timer timer(stats, ScanStats::kPhaseResolve);
+        clioptions::ResolveQuery(arguments, *source, entry.query);
+        if (entry.query.wait_ms > 0) throw "Waiting is not available in batch mode.";
+        if (entry.query.strip_height > 0) throw "Strip capture is not available in batch mode.";
+        if (entry.query.max_age_ms > 0) throw "Max. age is not available in batch mode.";
+        if (entry.query.output_format==OutputBuffer::kFormatRaw) throw "Raw output is not available in batch mode.";
+        if (entry.query.is_fingerprint_compared) throw "Comparing fingerprints is not available in batch mode.";
+      } catch (char const *exception) {
+        entry.is_failed = true;
+        entry.output = std::string("Error: ") + exception;
+      }
+    }
+
+    entries.push_back(entry);
+  }
+
+  // 2. Capture every merged rectangle once, run all queries within it on sub-frames of that capture
+  std::vector<Rectangle> captures = MergeScanningRectangles(entries);
+
+  for (int index_capture = -1; index_capture < static_cast<int>(captures.size()); ++index_capture) {
+    Frame frame;
+    Rectangle rectangle;
+
+    try {
+      if (index_capture > -1) {
+        rectangle = captures[static_cast<unsigned long>(index_capture)];
+        frame = Capture(rectangle);
+      }
+    } catch (char const *exception) {
+      for (auto &entry : entries) {
+        if (entry.is_failed || entry.index_capture!=index_capture) continue;
+        entry.is_failed = true;
+        entry.output = std::string("Error: ") + exception;
+      }
+      continue;
+    }
+
+    for (auto &entry : entries) {
+      if (entry.is_failed || entry.index_capture!=index_capture) continue;
+
+      std::ostringstream output;
+      if (index_capture==-1) {
+        WriteMousePosition(entry.query, output);
+      } else {
+        Rectangle scanning_rectangle = GetScanningRectangle(entry.query);
+        RunOnFrame(entry.query,
+                   frame.Crop(static_cast<unsigned short>(scanning_rectangle.x - rectangle.x),
+                              static_cast<unsigned short>(scanning_rectangle.y - rectangle.y),
+                              static_cast<unsigned short>(scanning_rectangle.width),
+                              static_cast<unsigned short>(scanning_rectangle.height)),
+                   output);
+      }
+      entry.output = output.str();
+    }
+  }
+
+  // 3. Print results in input order
+  int exit_code = 0;
+  for (const auto &entry : entries) {
+    std::string output = entry.output;
+    if (output.empty() || output[output.length() - 1]!='\n') output += "\n";
+
+    if (entry.is_failed) {
+      err << output.substr(0, output.length() - 1) << " (line " << entry.line_number << ")\n";
+      exit_code = -1;
+    } else {
+      out << output;
+    }
+  }
+
+  return exit_code;
+}
+
+std::vector<Rectangle> Session::MergeScanningRectangles(std::vector<BatchEntry> &entries) {
+  std::vector<Rectangle> captures;
+  std::vector<long> scanned_areas;
+
+  for (auto &entry : entries) {
+    if (entry.is_failed || entry.query.mode_id==clioptions::kModeIdTraceMouse) continue;
+
+    Rectangle rectangle = GetScanningRectangle(entry.query);
+
+    // Merge into 1st capture rectangle whose bounding box w/ the query's rectangle doesn't waste too many pixels
+    for (unsigned long index = 0; index < captures.size(); ++index) {
+      Rectangle merged = captures[index].Merge(rectangle);
+      if (merged.GetArea() <= kBatchMaxMergeFactor*(scanned_areas[index] + rectangle.GetArea())) {
+        captures[index] = merged;
+        scanned_areas[index] += rectangle.GetArea();
+        entry.index_capture = static_cast<int>(index);
+        break;
+      }
+    }
+
+    if (entry.index_capture==-1) {
+      entry.index_capture = static_cast<int>(captures.size());
+      captures.push_back(rectangle);
+      scanned_areas.push_back(rectangle.GetArea());
+    }
+  }
+
+  // Merging can make rectangles overlap: assign every query to the 1st capture containing it
+  for (auto &entry : entries) {
+    if (entry.index_capture < 0) continue;
+
+    Rectangle rectangle = GetScanningRectangle(entry.query);
+    for (unsigned long index = 0; index < captures.size(); ++index) {
+      if (captures[index].Contains(rectangle)) {
+        entry.index_capture = static_cast<int>(index);
+        break;
+      }
+    }
+  }
+
+  return captures;
+}
+
+void Session::WriteMousePosition(const clioptions::Query &query, std::ostream &out) {
+  out << "x=" << query.from_x << "; y=" << query.from_y << ";\n";
+}
+
+Rectangle Session::GetScanningRectangle(const clioptions::Query &query) {
+  return Rectangle(query.from_x, query.from_y, query.range_x, query.range_y);
+}
+
+} // namespace pixloc
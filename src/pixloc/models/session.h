@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_SESSION
+#define CLASS_PIXLOC_SESSION
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "pixloc/cli_options.h"
+#include "pixloc/models/frame.h"
+#include "pixloc/models/frame_cache.h"
+#include "pixloc/models/frame_source.h"
+#include "pixloc/models/rectangle.h"
+#include "pixloc/models/scan_stats.h"
+
+namespace pixloc {
+
+// Source of frames (live screen or recorded frame), reused for all queries run via the session
+class Session {
+
+ public:
+  // Constructor: open source of given input (see FrameSource::Create), throws if it cannot be opened
+  explicit Session(const std::string &input = "");
+
+  // Resolve and run query from given arguments, write output into out and errors into err. Returns exit code
+  int Run(const clioptions::Arguments &arguments, std::ostream &out, std::ostream &err);
+
+  // Run given resolved query, throws on failure. Returns whether the query found a match (trace modes: always)
+  bool Run(const clioptions::Query &query, std::ostream &out);
+
+  // Run all query lines of given stream on as few captures as possible, print results in input order.
+  // Returns exit code: 0 if all queries succeeded
+  int RunBatch(std::istream &in, std::ostream &out, std::ostream &err);
+
+  // Collect timings and counters of all following queries into given statistics, nullptr = don't collect
+  inline void SetStats(ScanStats *stats) { this->stats = stats; }
+
+  // Add counters only known after running all queries, e.g. the amount of X requests
+  void FinishStats();
+
+  inline FrameSource *GetSource() const { return source; }
+
+  virtual ~Session();
+
+ private:
+  // Max. ratio of captured vs. actually scanned pixels, when merging scanning rectangles of batched queries
+  static const unsigned short kBatchMaxMergeFactor = 2;
+
+  struct BatchEntry {
+    unsigned long line_number;
+    clioptions::Query query;
+    std::string output;
+    bool is_failed;
+    // Index of capture rectangle containing the query's scanning rectangle, -1 = query needs no capture
+    int index_capture;
+  };
+
+  FrameSource *source;
+  ScanStats *stats;
+  // Frames shared w/ other pixloc processes, created on the 1st query w/ a max. age
+  FrameCache *frame_cache;
+
+  // Capture given rectangle. Given a max. age: scan a cached frame of an earlier process instead if there is one
+  // young enough, otherwise publish the captured one
+  Frame Capture(const Rectangle &rectangle, long max_age_ms = 0);
+
+  // Run given query on given frame, captured from the query's scanning rectangle. Returns whether a match was found
+  bool RunOnFrame(const clioptions::Query &query, const Frame &frame, std::ostream &out);
+
+  // Run given query on given scanning rectangle: captured at once, or strip-wise if the query asks for strips
+  bool RunOnRectangle(const clioptions::Query &query, const Rectangle &rectangle, std::ostream &out);
+
+  // Run given find bitmask query while its scanning rectangle is being captured strip-wise
+  bool RunOnStrips(const clioptions::Query &query, const Rectangle &rectangle, std::ostream &out);
+
+  // Rerun given query whenever its scanning rectangle changed, until a match is found or the wait duration passed
+  bool RunUntilFound(const clioptions::Query &query, std::ostream &out);
+
+  static void WriteMousePosition(const clioptions::Query &query, std::ostream &out);
+  static Rectangle GetScanningRectangle(const clioptions::Query &query);
+
+  // Group given rectangles into few capture rectangles, store index of containing capture rectangle per entry
+  static std::vector<Rectangle> MergeScanningRectangles(std::vector<BatchEntry> &entries);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_SESSION
@@ -0,0 +1,136 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "strip_pipeline.h"
+
+namespace pixloc {
+
+// Constructor
+StripPipeline::StripPipeline(Display *display, const std::string &backend) {
+  for (unsigned short index = 0; index < kAmountBuffers; ++index)
+    this->buffers.push_back(ScreenCapture::Create(display, backend));
+}
+
+// Destructor
+StripPipeline::~StripPipeline() {
+  for (auto buffer : buffers) delete buffer;
+}
+
+void StripPipeline::Run(unsigned short x,
+                        unsigned short y,
+                        unsigned short width,
+                        unsigned short height,
+                        unsigned short strip_height,
+                        const FrameSource::StripConsumer &consume) {
+  const unsigned int amount_strips = (height + strip_height - 1u)/strip_height;
+  const unsigned int amount_buffers = static_cast<unsigned int>(buffers.size());
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<Frame> strips(amount_buffers);
+  unsigned int amount_captured = 0;
+  unsigned int amount_consumed = 0;
+  bool is_stopped = false;
+  const char *error = nullptr;
+
+  std::thread capturer([&]() {
+    for (unsigned int index = 0; index < amount_strips; ++index) {
+      {
+        // Wait until the buffer's previous strip was consumed
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return is_stopped || index - amount_consumed < amount_buffers; });
+        if (is_stopped) return;
+      }
+
+      unsigned int strip_y = index*strip_height;
+      Frame strip;
+      try {
+        strip = buffers[index%amount_buffers]->Capture(
+            x, static_cast<unsigned short>(y + strip_y), width,
+            static_cast<unsigned short>(height - strip_y < strip_height ? height - strip_y : strip_height));
+      } catch (char const *exception) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = exception;
+        is_stopped = true;
+        condition.notify_all();
+
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      strips[index%amount_buffers] = strip;
+      ++amount_captured;
+      condition.notify_all();
+    }
+  });
+
+  auto stop = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      is_stopped = true;
+    }
+    condition.notify_all();
+    capturer.join();
+  };
+
+  try {
+    for (unsigned int index = 0; index < amount_strips; ++index) {
+      Frame strip;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return amount_captured > index || error; });
+        if (amount_captured <= index) break;
+        strip = strips[index%amount_buffers];
+      }
+
+      bool is_continued = consume(strip, static_cast<unsigned short>(index*strip_height));
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++amount_consumed;
+      }
+      condition.notify_all();
+
+      if (!is_continued) break;
+    }
+  } catch (...) {
+    stop();
+    throw;
+  }
+
+  stop();
+
+  if (error) throw error;
+}
+
+} // namespace pixloc
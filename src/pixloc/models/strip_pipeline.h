@@ -0,0 +1,68 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_STRIP_PIPELINE
+#define CLASS_PIXLOC_STRIP_PIPELINE
+
+#include <X11/Xlib.h>
+#include <string>
+#include <vector>
+
+#include "pixloc/models/frame_source.h"
+#include "pixloc/models/screen_capture.h"
+
+namespace pixloc {
+
+// Pipelined capture of a rectangle in horizontal strips: a capture thread fetches strips into a ring of buffers, each
+// an own capture backend sized to a strip, while the calling thread consumes the finished ones. Memory is bounded by
+// the buffers, fetching stops as soon as the consumer is done.
+// The display is only used by the capture thread while the pipeline runs
+class StripPipeline {
+
+ public:
+  // Triple buffering: the consumer can work on a strip while the next two are being fetched
+  static const unsigned short kAmountBuffers = 3;
+
+  // Constructor: buffers are captured via the backend of given name (see ScreenCapture::Create)
+  StripPipeline(Display *display, const std::string &backend);
+
+  // Capture given rectangle in strips of given amount of rows, hand them to given consumer in top-down order
+  void Run(unsigned short x, unsigned short y, unsigned short width, unsigned short height,
+           unsigned short strip_height, const FrameSource::StripConsumer &consume);
+
+  // Destructor
+  virtual ~StripPipeline();
+
+ private:
+  std::vector<ScreenCapture *> buffers;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_STRIP_PIPELINE
@@ -0,0 +1,118 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fstream>
+
+#include "template_library.h"
+#include "pixloc/helper/strings.h"
+#include "pixloc/models/color_matcher.h"
+
+namespace pixloc {
+
+// Constructor
+TemplateLibrary::TemplateLibrary(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) throw "Failed to open template library file.";
+
+  Load(file);
+}
+
+// Constructor
+TemplateLibrary::TemplateLibrary(std::istream &in) {
+  Load(in);
+}
+
+void TemplateLibrary::Load(std::istream &in) {
+  std::string line;
+  while (std::getline(in, line)) {
+    std::vector<std::string> fields = helper::strings::SplitArguments(line);
+    if (fields.empty() || fields[0][0]=='#') continue;
+
+    if (fields.size() < 3 || fields.size() > 4) throw "Invalid line in template library.";
+
+    std::vector<std::string> rgb = helper::strings::Explode(fields[1], ',');
+    if (!IsValidBitmask(fields[2]) || rgb.size()!=3) throw "Invalid line in template library.";
+
+    BitmaskTemplate bitmask_template{fields[0], Bitmask(fields[2]), 0, 0, 0, 0};
+    if (!ResolveChannel(rgb[0], bitmask_template.red) ||
+        !ResolveChannel(rgb[1], bitmask_template.green) ||
+        !ResolveChannel(rgb[2], bitmask_template.blue) ||
+        (fields.size()==4 && !ResolveChannel(fields[3], bitmask_template.tolerance)))
+      throw "Invalid line in template library.";
+
+    templates.push_back(bitmask_template);
+  }
+
+  if (templates.empty()) throw "Template library is empty.";
+}
+
+unsigned short TemplateLibrary::GetMaxWidth() const {
+  unsigned short max_width = 0;
+  for (const auto &bitmask_template : templates) {
+    if (bitmask_template.bitmask.GetWidth() > max_width) max_width = bitmask_template.bitmask.GetWidth();
+  }
+
+  return max_width;
+}
+
+unsigned short TemplateLibrary::GetMaxHeight() const {
+  unsigned short max_height = 0;
+  for (const auto &bitmask_template : templates) {
+    if (bitmask_template.bitmask.GetHeight() > max_height) max_height = bitmask_template.bitmask.GetHeight();
+  }
+
+  return max_height;
+}
+
+// Bitmask of rows of equal, non-zero width
+bool TemplateLibrary::IsValidBitmask(const std::string &bitmask) {
+  std::vector<std::string> rows = helper::strings::Explode(bitmask, Bitmask::kRowSeparator);
+  if (rows.empty()) return false;
+
+  for (const auto &row : rows) {
+    if (row.empty() || row.length()!=rows[0].length() ||
+        row.find_first_not_of(std::string{Bitmask::kCharSet, Bitmask::kCharUnset})!=std::string::npos)
+      return false;
+  }
+
+  return true;
+}
+
+bool TemplateLibrary::ResolveChannel(const std::string &value, unsigned short &channel) {
+  if (!helper::strings::IsNumeric(value) || value.length() > 3) return false;
+
+  int number = helper::strings::ToInt(value, -1);
+  if (number < 0 || number > ColorMatcher::kMaxChannelValue) return false;
+
+  channel = static_cast<unsigned short>(number);
+
+  return true;
+}
+
+} // namespace pixloc
@@ -0,0 +1,81 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_TEMPLATE_LIBRARY
+#define CLASS_PIXLOC_TEMPLATE_LIBRARY
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "pixloc/models/bitmask.h"
+
+namespace pixloc {
+
+// Named bitmask, filtered by its own color and tolerance
+struct BitmaskTemplate {
+  std::string name;
+  Bitmask bitmask;
+
+  unsigned short red;
+  unsigned short green;
+  unsigned short blue;
+  unsigned short tolerance;
+};
+
+// Named bitmasks, loaded from a text file of one template per line: name, color, bitmask and optional tolerance,
+// separated by whitespace, e.g.:
+//   ok_button 188,188,188 *__,**_,*__ 10
+// Empty lines and lines starting w/ # are ignored
+class TemplateLibrary {
+
+ public:
+  // Constructor: load library from file at given path
+  explicit TemplateLibrary(const std::string &path);
+
+  // Constructor: load library from lines of given stream
+  explicit TemplateLibrary(std::istream &in);
+
+  inline const std::vector<BitmaskTemplate> &GetTemplates() const { return templates; }
+
+  unsigned short GetMaxWidth() const;
+  unsigned short GetMaxHeight() const;
+
+ private:
+  std::vector<BitmaskTemplate> templates;
+
+  void Load(std::istream &in);
+
+  static bool IsValidBitmask(const std::string &bitmask);
+  static bool ResolveChannel(const std::string &value, unsigned short &channel);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_TEMPLATE_LIBRARY
@@ -0,0 +1,91 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "x_frame_source.h"
+
+namespace pixloc {
+
+// Constructor
+XFrameSource::XFrameSource(const std::string &backend) {
+  this->display = XOpenDisplay(nullptr);
+  if (!this->display) throw "Failed to open default display.";
+
+  try {
+    this->capture = ScreenCapture::Create(this->display, backend);
+  } catch (char const *) {
+    XCloseDisplay(this->display);
+    throw;
+  }
+
+  this->backend = backend;
+  this->decoder = new PixelDecoder(this->display);
+  this->strip_pipeline = nullptr;
+}
+
+// Destructor
+XFrameSource::~XFrameSource() {
+  delete this->strip_pipeline;
+  delete this->decoder;
+  delete this->capture;
+  XCloseDisplay(this->display);
+}
+
+Frame XFrameSource::Capture(unsigned short x, unsigned short y, unsigned short width, unsigned short height) {
+  return capture->Capture(x, y, width, height);
+}
+
+void XFrameSource::CaptureStrips(unsigned short x,
+                                 unsigned short y,
+                                 unsigned short width,
+                                 unsigned short height,
+                                 unsigned short strip_height,
+                                 const StripConsumer &consume) {
+  if (!strip_pipeline) strip_pipeline = new StripPipeline(display, backend);
+
+  strip_pipeline->Run(x, y, width, height, strip_height, consume);
+}
+
+unsigned short XFrameSource::GetWidth() const {
+  return static_cast<unsigned short>(DefaultScreenOfDisplay(display)->width);
+}
+
+unsigned short XFrameSource::GetHeight() const {
+  return static_cast<unsigned short>(DefaultScreenOfDisplay(display)->height);
+}
+
+void XFrameSource::GetMousePosition(int &x, int &y) const {
+  XEvent event{};
+  XQueryPointer(display, RootWindow(display, DefaultScreen(display)),
+                &event.xbutton.root, &event.xbutton.window,
+                &event.xbutton.x_root, &event.xbutton.y_root,
+                &x, &y,
+                &event.xbutton.state);
+}
+
+} // namespace pixloc
@@ -0,0 +1,79 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_X_FRAME_SOURCE
+#define CLASS_PIXLOC_X_FRAME_SOURCE
+
+#include <string>
+
+#include "pixloc/models/frame_source.h"
+#include "pixloc/models/screen_capture.h"
+#include "pixloc/models/strip_pipeline.h"
+
+namespace pixloc {
+
+// Live screen of the default X display, captured via the best available ScreenCapture backend
+class XFrameSource : public FrameSource {
+
+ public:
+  // Constructor, throws if the default display cannot be opened.
+  // Optional backend: xshm or xgetimage, default: best available
+  explicit XFrameSource(const std::string &backend = "");
+
+  Frame Capture(unsigned short x, unsigned short y, unsigned short width, unsigned short height) override;
+
+  // Pipelined: strips are fetched on a capture thread while the consumer scans the previous ones
+  void CaptureStrips(unsigned short x, unsigned short y, unsigned short width, unsigned short height,
+                     unsigned short strip_height, const StripConsumer &consume) override;
+
+  const PixelDecoder *GetDecoder() const override { return decoder; }
+
+  unsigned short GetWidth() const override;
+  unsigned short GetHeight() const override;
+
+  void GetMousePosition(int &x, int &y) const override;
+
+  Display *GetDisplay() const override { return display; }
+
+  const char *GetName() const override { return "x11"; }
+
+  ~XFrameSource() override;
+
+ private:
+  Display *display;
+  std::string backend;
+  ScreenCapture *capture;
+  PixelDecoder *decoder;
+  // Created on first strip-wise capture
+  StripPipeline *strip_pipeline;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_X_FRAME_SOURCE
@@ -0,0 +1,60 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_X_GET_IMAGE_CAPTURE
+#define CLASS_PIXLOC_X_GET_IMAGE_CAPTURE
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include "pixloc/models/screen_capture.h"
+
+namespace pixloc {
+
+// Capture via XGetImage: works w/ every X server, but transfers the image over the X connection
+class XGetImageCapture : public ScreenCapture {
+
+ public:
+  // Constructor
+  explicit XGetImageCapture(Display *display);
+
+  Frame Capture(unsigned short x, unsigned short y, unsigned short width, unsigned short height) override;
+
+  const char *GetName() const override { return "xgetimage"; }
+
+  ~XGetImageCapture() override;
+
+ private:
+  Display *display;
+  XImage *image;
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_X_GET_IMAGE_CAPTURE
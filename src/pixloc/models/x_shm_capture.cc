@@ -0,0 +1,183 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef PIXLOC_HAS_XSHM
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "x_shm_capture.h"
+
+namespace pixloc {
+
+static bool has_attach_error = false;
+
+// Constructor
+XShmCapture::XShmCapture(Display *display) {
+  this->display = display;
+  this->image = nullptr;
+  this->segment_size = 0;
+  this->is_attached = false;
+  this->is_failed = false;
+  this->fallback = nullptr;
+
+  this->shm_info.shmseg = 0;
+  this->shm_info.shmid = -1;
+  this->shm_info.shmaddr = nullptr;
+  this->shm_info.readOnly = False;
+}
+
+// Destructor
+XShmCapture::~XShmCapture() {
+  DestroyImage();
+  ReleaseSegment();
+  delete fallback;
+}
+
+bool XShmCapture::IsSupported(Display *display) {
+  return XShmQueryExtension(display)==True;
+}
+
+Frame XShmCapture::Capture(unsigned short x, unsigned short y, unsigned short width, unsigned short height) {
+  if (!is_failed && !PrepareImage(width, height)) {
+    is_failed = true;
+    DestroyImage();
+    ReleaseSegment();
+  }
+
+  if (is_failed) {
+    if (!fallback) fallback = new XGetImageCapture(display);
+
+    return fallback->Capture(x, y, width, height);
+  }
+
+  if (!XShmGetImage(display, RootWindow(display, DefaultScreen(display)), image, x, y, AllPlanes))
+    throw "Failed to capture screen.";
+
+  return Frame(image);
+}
+
+// Ensure image of given dimension, backed by a sufficiently large attached segment
+bool XShmCapture::PrepareImage(unsigned short width, unsigned short height) {
+  if (image && image->width==width && image->height==height) return true;
+
+  DestroyImage();
+
+  int screen = DefaultScreen(display);
+  image = XShmCreateImage(display,
+                          DefaultVisual(display, screen),
+                          static_cast<unsigned int>(DefaultDepth(display, screen)),
+                          ZPixmap,
+                          nullptr,
+                          &shm_info,
+                          width, height);
+  if (!image) return false;
+
+  auto size = static_cast<unsigned long>(image->bytes_per_line)*height;
+  if (size > segment_size && !AllocateSegment(size)) return false;
+
+  image->data = shm_info.shmaddr;
+
+  return true;
+}
+
+bool XShmCapture::AllocateSegment(unsigned long size) {
+  ReleaseSegment();
+
+  shm_info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+  if (shm_info.shmid==-1) return false;
+
+  shm_info.shmaddr = static_cast<char *>(shmat(shm_info.shmid, nullptr, 0));
+  if (shm_info.shmaddr==reinterpret_cast<char *>(-1)) {
+    shm_info.shmaddr = nullptr;
+    shmctl(shm_info.shmid, IPC_RMID, nullptr);
+    shm_info.shmid = -1;
+
+    return false;
+  }
+
+  // Attaching fails asynchronously (e.g. on remote displays): sync and check for errors
+  XSync(display, False);
+  has_attach_error = false;
+  XErrorHandler previous_handler = XSetErrorHandler(HandleAttachError);
+  XShmAttach(display, &shm_info);
+  XSync(display, False);
+  XSetErrorHandler(previous_handler);
+
+  // Mark for removal already now: the segment is freed as soon as both, client and server detached
+  shmctl(shm_info.shmid, IPC_RMID, nullptr);
+
+  if (has_attach_error) {
+    shmdt(shm_info.shmaddr);
+    shm_info.shmaddr = nullptr;
+    shm_info.shmid = -1;
+
+    return false;
+  }
+
+  is_attached = true;
+  segment_size = size;
+
+  return true;
+}
+
+void XShmCapture::ReleaseSegment() {
+  if (is_attached) {
+    XShmDetach(display, &shm_info);
+    XSync(display, False);
+    is_attached = false;
+  }
+
+  if (shm_info.shmaddr) {
+    shmdt(shm_info.shmaddr);
+    shm_info.shmaddr = nullptr;
+  }
+
+  shm_info.shmid = -1;
+  segment_size = 0;
+}
+
+void XShmCapture::DestroyImage() {
+  if (!image) return;
+
+  // Pixel data is owned by the segment, not the image
+  image->data = nullptr;
+  XDestroyImage(image);
+  image = nullptr;
+}
+
+int XShmCapture::HandleAttachError(Display *, XErrorEvent *) {
+  has_attach_error = true;
+
+  return 0;
+}
+
+} // namespace pixloc
+
+#endif //PIXLOC_HAS_XSHM
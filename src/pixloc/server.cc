@@ -0,0 +1,348 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <vector>
+
+#include "server.h"
+
+namespace pixloc {
+
+const char *const Server::kStatusPrefix = "exit: ";
+const int Server::kIdleTimeoutMs;
+const unsigned long Server::kMaxRequestLength;
+const unsigned long Server::kMaxConnections;
+
+static volatile sig_atomic_t is_terminated = 0;
+
+// Constructor
+Server::Server(Session *session, const std::string &socket_path) {
+  this->session = session;
+  this->socket_path = socket_path;
+}
+
+int Server::Run() {
+  struct sockaddr_un address{};
+  if (!InitSocketAddress(socket_path, address)) {
+    std::cerr << "Error: Invalid socket path.\n";
+    return -1;
+  }
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener==-1) {
+    std::cerr << "Error: Failed to create socket.\n";
+    return -1;
+  }
+
+  // Replace stale socket of an earlier daemon, but never remove any other kind of file
+  struct stat status{};
+  if (lstat(socket_path.c_str(), &status)==0) {
+    if (!S_ISSOCK(status.st_mode)) {
+      std::cerr << "Error: " << socket_path << " is not a socket.\n";
+      close(listener);
+      return -1;
+    }
+    unlink(socket_path.c_str());
+  }
+
+  if (bind(listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address))==-1) {
+    std::cerr << "Error: Failed to listen on socket " << socket_path << "\n";
+    close(listener);
+    return -1;
+  }
+
+  // Identity of the bound socket file: at shutdown, a file replaced meanwhile is not removed
+  lstat(socket_path.c_str(), &status);
+  dev_t bound_device = status.st_dev;
+  ino_t bound_inode = status.st_ino;
+
+  if (listen(listener, SOMAXCONN)==-1) {
+    std::cerr << "Error: Failed to listen on socket " << socket_path << "\n";
+    close(listener);
+    unlink(socket_path.c_str());
+    return -1;
+  }
+
+  // No SA_RESTART: let poll() return on termination signals
+  struct sigaction action{};
+  action.sa_handler = HandleTerminationSignal;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  // Listener and all open connections are polled at once: an idle or slow client never blocks the others
+  std::vector<Connection> connections;
+  std::vector<struct pollfd> poll_fds;
+
+  while (!is_terminated) {
+    poll_fds.assign(1, pollfd{listener, POLLIN, 0});
+    for (const auto &connection : connections) poll_fds.push_back(pollfd{connection.file_descriptor, POLLIN, 0});
+
+    if (poll(poll_fds.data(), poll_fds.size(), GetPollTimeout(connections))==-1) {
+      if (errno==EINTR) continue;
+      break;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::vector<Connection> open_connections;
+
+    for (unsigned long index = 0; index < connections.size(); ++index) {
+      Connection &connection = connections[index];
+      bool is_open = poll_fds[index + 1].revents
+                     ? ServeConnection(connection)
+                     : now < connection.idle_deadline;
+
+      if (is_open) {
+        if (poll_fds[index + 1].revents) connection.idle_deadline = now + std::chrono::milliseconds(kIdleTimeoutMs);
+        open_connections.push_back(std::move(connection));
+      } else {
+        close(connection.file_descriptor);
+      }
+    }
+    connections.swap(open_connections);
+
+    if (poll_fds[0].revents & POLLIN) AcceptConnection(listener, connections);
+  }
+
+  for (const auto &connection : connections) close(connection.file_descriptor);
+
+  close(listener);
+  if (lstat(socket_path.c_str(), &status)==0 && S_ISSOCK(status.st_mode)
+      && status.st_dev==bound_device && status.st_ino==bound_inode)
+    unlink(socket_path.c_str());
+
+  return 0;
+}
+
+void Server::AcceptConnection(int listener, std::vector<Connection> &connections) {
+  int file_descriptor = accept(listener, nullptr, nullptr);
+  if (file_descriptor==-1) return;
+
+  if (connections.size() >= kMaxConnections) {
+    WriteAll(file_descriptor, "Error: Too many connections.\n" + std::string(kStatusPrefix) + "-1\n\n");
+    close(file_descriptor);
+    return;
+  }
+
+  // Connections are only read when readable, the receive timeout is a safeguard. Writing a response to a client that
+  // does not read times out, closing its connection
+  struct timeval timeout{kIdleTimeoutMs/1000, 0};
+  setsockopt(file_descriptor, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(file_descriptor, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  Connection connection;
+  connection.file_descriptor = file_descriptor;
+  connection.idle_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kIdleTimeoutMs);
+  connections.push_back(std::move(connection));
+}
+
+// Milliseconds until the earliest idle deadline of given connections, -1 = none
+int Server::GetPollTimeout(const std::vector<Connection> &connections) {
+  if (connections.empty()) return -1;
+
+  auto deadline = connections[0].idle_deadline;
+  for (const auto &connection : connections) {
+    if (connection.idle_deadline < deadline) deadline = connection.idle_deadline;
+  }
+
+  auto remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now()).count();
+
+  return remaining_ms < 0 ? 0 : static_cast<int>(remaining_ms) + 1;
+}
+
+// Read what given connection received, run all request lines completed by it.
+// Return false if the connection is to be closed: closed by the client, failed, or w/ an over-long request line
+bool Server::ServeConnection(Connection &connection) {
+  char buffer[kReadBufferSize];
+
+  ssize_t amount_read = read(connection.file_descriptor, buffer, sizeof(buffer));
+  if (amount_read <= 0) return amount_read==-1 && errno==EINTR;
+
+  std::string &pending = connection.pending;
+  pending.append(buffer, static_cast<unsigned long>(amount_read));
+
+  std::string::size_type offset_newline;
+  while ((offset_newline = pending.find('\n'))!=std::string::npos) {
+    std::string line = pending.substr(0, offset_newline);
+    pending.erase(0, offset_newline + 1);
+    if (!line.empty() && line[line.length() - 1]=='\r') line.erase(line.length() - 1);
+    if (line.empty()) continue;
+
+    if (!WriteAll(connection.file_descriptor, RunRequest(line))) return false;
+  }
+
+  if (pending.length() > kMaxRequestLength) {
+    WriteAll(connection.file_descriptor, "Error: Request too long.\n" + std::string(kStatusPrefix) + "-1\n\n");
+    return false;
+  }
+
+  return true;
+}
+
+std::string Server::RunRequest(const std::string &line) {
+  std::ostringstream response;
+  clioptions::Arguments arguments;
+  std::string error_message;
+  int exit_code = -1;
+
+  if (!clioptions::ParseArgumentsLine(line, arguments, error_message))
+    response << "Error in command line: " << error_message << "\n";
+  else if (arguments.show_help || !arguments.serve.empty() || !arguments.client.empty() || !arguments.batch.empty() ||
+      !arguments.input.empty() || arguments.stats || arguments.format=="raw" || !arguments.compare.empty())
+    response << "Error: Option not available in daemon requests.\n";
+  else
+    exit_code = RunSession(arguments, response);
+
+  // Normalize to exactly one trailing newline, followed by the status line and the terminating empty line
+  std::string output = response.str();
+  while (!output.empty() && output[output.length() - 1]=='\n') output.erase(output.length() - 1);
+  if (!output.empty()) output += "\n";
+
+  return output + kStatusPrefix + std::to_string(exit_code) + "\n\n";
+}
+
+// Run query of given arguments, any failure is turned into an error response: a failing request must not terminate
+// the daemon for all other clients
+int Server::RunSession(const clioptions::Arguments &arguments, std::ostream &response) {
+  try {
+    return session->Run(arguments, response, response);
+  } catch (const std::exception &exception) {
+    response << "Error: " << exception.what() << "\n";
+  } catch (...) {
+    response << "Error: Failed to run query.\n";
+  }
+
+  return -1;
+}
+
+int Server::RunClient(const std::string &socket_path, const clioptions::Arguments &arguments) {
+  struct sockaddr_un address{};
+  int connection = -1;
+  if (!InitSocketAddress(socket_path, address)
+      || (connection = socket(AF_UNIX, SOCK_STREAM, 0))==-1
+      || connect(connection, reinterpret_cast<struct sockaddr *>(&address), sizeof(address))==-1) {
+    std::cerr << "Error: Failed to connect to daemon at " << socket_path << "\n";
+    if (connection!=-1) close(connection);
+    return -1;
+  }
+
+  // Files are opened by the daemon, relative to its own working directory: forward paths relative to the client's
+  clioptions::Arguments forwarded_arguments = arguments;
+  forwarded_arguments.image = ToAbsolutePath(arguments.image);
+  forwarded_arguments.library = ToAbsolutePath(arguments.library);
+
+  if (!WriteAll(connection, clioptions::FormatArguments(forwarded_arguments) + "\n")) {
+    std::cerr << "Error: Failed to send query to daemon.\n";
+    close(connection);
+    return -1;
+  }
+  shutdown(connection, SHUT_WR);
+
+  std::string response;
+  char buffer[kReadBufferSize];
+  ssize_t amount_read;
+  while ((amount_read = read(connection, buffer, sizeof(buffer))) > 0)
+    response.append(buffer, static_cast<unsigned long>(amount_read));
+  close(connection);
+
+  // Response must be complete: status line and terminating empty line, else the daemon failed mid-request
+  std::string::size_type offset_status = response.rfind('\n', response.length() < 3 ? 0 : response.length() - 3);
+  offset_status = offset_status==std::string::npos ? 0 : offset_status + 1;
+
+  if (response.length() < 2 || response.compare(response.length() - 2, 2, "\n\n")!=0
+      || response.compare(offset_status, strlen(kStatusPrefix), kStatusPrefix)!=0) {
+    std::cerr << "Error: Incomplete response from daemon.\n";
+    return -1;
+  }
+
+  int exit_code = atoi(response.c_str() + offset_status + strlen(kStatusPrefix));
+  response.erase(offset_status);
+
+  (response.compare(0, 5, "Error")==0 ? std::cerr : std::cout) << response;
+
+  return exit_code;
+}
+
+// Prefix given relative path w/ the current working directory. Empty and absolute paths are returned as-is
+std::string Server::ToAbsolutePath(const std::string &path) {
+  if (path.empty() || path[0]=='/') return path;
+
+  char *working_directory = getcwd(nullptr, 0);
+  if (!working_directory) return path;
+
+  std::string absolute_path = std::string(working_directory) + "/" + path;
+  free(working_directory);
+
+  return absolute_path;
+}
+
+bool Server::WriteAll(int file_descriptor, const std::string &data) {
+  const char *remaining = data.c_str();
+  std::string::size_type amount_remaining = data.length();
+
+  while (amount_remaining > 0) {
+    ssize_t amount_written = write(file_descriptor, remaining, amount_remaining);
+    if (amount_written==-1) {
+      if (errno==EINTR) continue;
+      return false;
+    }
+    remaining += amount_written;
+    amount_remaining -= static_cast<std::string::size_type>(amount_written);
+  }
+
+  return true;
+}
+
+bool Server::InitSocketAddress(const std::string &socket_path, struct sockaddr_un &address) {
+  if (socket_path.empty() || socket_path.length() >= sizeof(address.sun_path)) return false;
+
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+  return true;
+}
+
+void Server::HandleTerminationSignal(int) {
+  is_terminated = 1;
+}
+
+} // namespace pixloc
@@ -0,0 +1,93 @@
+/*
+  Copyright (c) 2019, Kay Stenschke
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   * Neither the name of  nor the names of its contributors may be used to
+     endorse or promote products derived from this software without specific
+     prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLASS_PIXLOC_SERVER
+#define CLASS_PIXLOC_SERVER
+
+#include <sys/un.h>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "pixloc/models/session.h"
+
+namespace pixloc {
+
+// Daemon mode: serve queries over a Unix domain socket, reusing one session for all of them.
+// Protocol: each request is one line of command line options (quoted like in a shell),
+// each response is the output pixloc prints for those options, followed by the status line "exit: <exit code>" and
+// terminated by an empty line.
+// Example: echo '-m "trace main color" -f 0,0 -r 16,16' | socat - UNIX-CONNECT:/tmp/pixloc.sock
+class Server {
+
+ public:
+  // Constructor
+  Server(Session *session, const std::string &socket_path);
+
+  // Listen and serve until terminated by SIGINT or SIGTERM. Returns exit code
+  int Run();
+
+  // Send query of given arguments to daemon listening on given socket, print its response. Returns exit code
+  static int RunClient(const std::string &socket_path, const clioptions::Arguments &arguments);
+
+ private:
+  static const unsigned short kReadBufferSize = 4096;
+  static const char *const kStatusPrefix;
+
+  // Connections idle for longer are closed, as are connections sending longer request lines
+  static const int kIdleTimeoutMs = 30000;
+  static const unsigned long kMaxRequestLength = 1UL << 20;
+  static const unsigned long kMaxConnections = 256;
+
+  // Open client connection w/ its received, yet incomplete request line
+  struct Connection {
+    int file_descriptor;
+    std::string pending;
+    std::chrono::steady_clock::time_point idle_deadline;
+  };
+
+  Session *session;
+  std::string socket_path;
+
+  static void AcceptConnection(int listener, std::vector<Connection> &connections);
+  static int GetPollTimeout(const std::vector<Connection> &connections);
+  bool ServeConnection(Connection &connection);
+  std::string RunRequest(const std::string &line);
+  int RunSession(const clioptions::Arguments &arguments, std::ostream &response);
+
+  static std::string ToAbsolutePath(const std::string &path);
+  static bool WriteAll(int file_descriptor, const std::string &data);
+  static bool InitSocketAddress(const std::string &socket_path, struct sockaddr_un &address);
+  static void HandleTerminationSignal(int signal_number);
+};
+
+} // namespace pixloc
+
+#endif //CLASS_PIXLOC_SERVER